@@ -93,6 +93,31 @@ smb_list al_cast_to_list(smb_al *list);
    @param newData The data to append
  */
 void al_append(smb_al *list, DATA newData);
+/**
+   @brief Append an array of items to the end of a list, with one copy.
+
+   The items may be part of the list itself.
+   @param list A pointer to the list to append to.
+   @param data The items to append.
+   @param n The number of items.
+ */
+void al_extend(smb_al *list, const DATA *data, int n);
+/**
+   @brief Make room for n items in total, so that adding them won't reallocate.
+
+   The list grows geometrically on its own, so this just saves the few
+   reallocations (and the slack) when the final length is known.
+   @param list A pointer to the list.
+   @param n The number of items to make room for.
+ */
+void al_reserve(smb_al *list, int n);
+/**
+   @brief Free the unused space at the end of the list.
+
+   The next append will reallocate, so this is for lists that are done growing.
+   @param list A pointer to the list.
+ */
+void al_shrink_to_fit(smb_al *list);
 /**
    @brief Prepend an item to the beginning of the list.
    @param list A pointer to the list to prepend to.
@@ -0,0 +1,174 @@
+/***************************************************************************//**
+
+  @file         libstephen/ala.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Array List for Any data.
+
+  Like smb_hta does for hash tables, smb_ala stores items of a size chosen when
+  the list is created, end to end in one array, instead of DATA.  A list of
+  structs is then one allocation, not one per struct plus an array of
+  pointers.  Functions take and return pointers to items, which are good until
+  the next call that adds or removes items.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_ALA_H
+#define LIBSTEPHEN_ALA_H
+
+#include "base.h"  /* smb_status */
+#include "list.h"  /* smb_iter   */
+
+/**
+   @brief An array list of items of any one size.
+ */
+typedef struct smb_ala
+{
+  /**
+     @brief The items, end to end.
+   */
+  void *data;
+
+  /**
+     @brief The number of items in the list.
+   */
+  int length;
+
+  /**
+     @brief The number of items there is room for.
+   */
+  int allocated;
+
+  /**
+     @brief The size of each item.
+   */
+  unsigned int item_size;
+
+} smb_ala;
+
+/**
+   @brief Return a pointer to an item, without checking the index.
+ */
+#define ALA_ITEM(list, index) \
+  ((void *) ((char *) (list)->data + (size_t) (index) * (list)->item_size))
+
+/**
+   @brief Initialize an empty list in memory already allocated.
+   @param list A pointer to the list to initialize.
+   @param item_size The size of each item.
+ */
+void ala_init(smb_ala *list, unsigned int item_size);
+/**
+   @brief Allocate and initialize an empty list.
+   @param item_size The size of each item.
+   @returns A pointer to the new list.
+ */
+smb_ala *ala_create(unsigned int item_size);
+/**
+   @brief Free the resources used by the list, but not the pointer.
+   @param list A pointer to the list to destroy.
+ */
+void ala_destroy(smb_ala *list);
+/**
+   @brief Free the list and its resources.
+   @param list A pointer to the list to delete.
+ */
+void ala_delete(smb_ala *list);
+
+/**
+   @brief Make room for n items in total, so that adding them won't reallocate.
+   @param list A pointer to the list.
+   @param n The number of items to make room for.
+ */
+void ala_reserve(smb_ala *list, int n);
+/**
+   @brief Free the unused space at the end of the list.
+   @param list A pointer to the list.
+ */
+void ala_shrink_to_fit(smb_ala *list);
+
+/**
+   @brief Append an item to the end of the list.
+
+   Like smb_al, the list doubles in size when it's full.  The item may be one
+   from the list itself, such as a pointer from ala_get().
+   @param list A pointer to the list.
+   @param item The item to copy in, or NULL for a zeroed item that the caller
+   fills in through the returned pointer.
+   @returns A pointer to the new item.
+ */
+void *ala_append(smb_ala *list, const void *item);
+/**
+   @brief Append an array of items to the end of the list, with one copy.
+
+   The items may be part of the list itself.
+   @param list A pointer to the list.
+   @param items The items, end to end.
+   @param n The number of items.
+ */
+void ala_extend(smb_ala *list, const void *items, int n);
+/**
+   @brief Insert an item, shifting up every item from the index on.
+
+   Like al_insert(), an index below 0 is treated as 0, and one past the end as
+   the end.  The item may be one from the list itself.
+   @param list A pointer to the list.
+   @param index Where to insert the item.
+   @param item The item to copy in, or NULL for a zeroed item.
+   @returns A pointer to the new item.
+ */
+void *ala_insert(smb_ala *list, int index, const void *item);
+/**
+   @brief Return a pointer to the item at an index.
+   @param list A pointer to the list.
+   @param index The index of the item.
+   @param[out] status Status variable.
+   @returns A pointer to the item, or NULL.
+   @exception SMB_INDEX_ERROR If the index was out of range.
+ */
+void *ala_get(const smb_ala *list, int index, smb_status *status);
+/**
+   @brief Remove the item at an index, shifting down every item after it.
+   @param list A pointer to the list.
+   @param index The index of the item.
+   @param[out] status Status variable.
+   @exception SMB_INDEX_ERROR If the index was out of range.
+ */
+void ala_remove(smb_ala *list, int index, smb_status *status);
+/**
+   @brief Remove the last item of the list.
+   @param list A pointer to the list.
+   @param[out] item Where to copy the item (may be NULL).
+   @param[out] status Status variable.
+   @exception SMB_INDEX_ERROR If the list is empty.
+ */
+void ala_pop_back(smb_ala *list, void *item, smb_status *status);
+/**
+   @brief Sort the items in place, with qsort().
+   @param list A pointer to the list.
+   @param compare A comparison function, as for qsort().
+ */
+void ala_sort(smb_ala *list, int (*compare)(const void *, const void *));
+/**
+   @brief Return the number of items in the list.
+   @param list A pointer to the list.
+   @returns The number of items.
+ */
+int ala_length(const smb_ala *list);
+/**
+   @brief Return an iterator over the items of a list.
+
+   Each call to next() returns a pointer to the next item in data_ptr, so
+   nothing is copied.
+   @param list A pointer to the list.
+   @returns An iterator struct.
+ */
+smb_iter ala_get_iter(const smb_ala *list);
+
+#endif // LIBSTEPHEN_ALA_H
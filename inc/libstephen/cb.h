@@ -75,6 +75,13 @@ void cb_delete(cbuf *obj);
    @param str The string to concat.
  */
 void cb_concat(cbuf *obj, char *str);
+/**
+   @brief Concat the first n characters of a string onto the character buffer.
+   @param obj The buffer to concat onto.
+   @param str The string to concat (need not be NUL terminated).
+   @param n The number of characters to concat.
+ */
+void cb_nconcat(cbuf *obj, const char *str, int n);
 /**
    @brief Append a character onto the end of the character buffer.
    @param obj The buffer to append onto.
@@ -158,6 +165,13 @@ void wcb_delete(wcbuf *obj);
    @param str The wide string to concat on.
  */
 void wcb_concat(wcbuf *obj, wchar_t *str);
+/**
+   @brief Concat the first n characters of a wide string onto the wide buffer.
+   @param obj The wide buffer to concat onto.
+   @param str The wide string to concat (need not be NUL terminated).
+   @param n The number of characters to concat.
+ */
+void wcb_nconcat(wcbuf *obj, const wchar_t *str, int n);
 /**
    @brief Append a single character onto the buffer.
    @param obj The wide buffer to append onto.
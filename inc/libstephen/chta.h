@@ -0,0 +1,145 @@
+/***************************************************************************//**
+
+  @file         libstephen/chta.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Concurrent Hash Table for Any data
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_CHTA_H
+#define LIBSTEPHEN_CHTA_H
+
+#include <pthread.h>
+
+#include "base.h"
+#include "hta.h"
+
+/**
+   @brief The number of stripes a concurrent table is split into.
+
+   Each stripe has its own lock, so this bounds how many writers can make
+   progress at once.  It must be a power of two.
+ */
+#define CHTA_STRIPES 64
+
+/**
+   @brief One lock, and the part of the table it protects.
+ */
+typedef struct smb_chta_stripe
+{
+  /**
+     @brief Held for reading by lookups, and for writing by changes.
+   */
+  pthread_rwlock_t lock;
+
+  /**
+     @brief The keys whose hashes select this stripe.
+   */
+  smb_hta table;
+
+} smb_chta_stripe;
+
+/**
+   @brief A hash table that any number of threads may use at once.
+
+   Keys are split between CHTA_STRIPES independent smb_hta tables by their
+   hash, and each is guarded by a reader-writer lock.  Lookups in a stripe run
+   in parallel with each other, and changes to different stripes run in
+   parallel with everything.  Each stripe grows and shrinks on its own, and
+   rehashes incrementally, so a resize only holds up its own stripe, and not
+   for long.
+ */
+typedef struct smb_chta
+{
+  /**
+     @brief The stripes.
+   */
+  smb_chta_stripe stripes[CHTA_STRIPES];
+
+} smb_chta;
+
+/**
+   @brief Initialize a concurrent hash table in memory already allocated.
+   @param table A pointer to the table to initialize.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for keys.
+   @param key_size Size of keys.
+   @param value_size Size of values.
+ */
+void chta_init(smb_chta *table, HTA_HASH hash_func, HTA_COMP equal,
+               unsigned int key_size, unsigned int value_size);
+/**
+   @brief Allocate and initialize a concurrent hash table.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for keys.
+   @param key_size Size of keys.
+   @param value_size Size of values.
+   @returns A pointer to the new hash table.
+ */
+smb_chta *chta_create(HTA_HASH hash_func, HTA_COMP equal,
+                      unsigned int key_size, unsigned int value_size);
+/**
+   @brief Free resources used by the table, but not the pointer itself.
+
+   No other thread may be using the table.
+   @param table The table to destroy.
+ */
+void chta_destroy(smb_chta *table);
+/**
+   @brief Free the table and its resources.
+   @param table The table to free.
+ */
+void chta_delete(smb_chta *table);
+
+/**
+   @brief Insert data into the table, or overwrite the value of an existing key.
+   @param table A pointer to the hash table.
+   @param key The key to insert.
+   @param value The value to insert at the key.
+ */
+void chta_insert(smb_chta *table, void *key, void *value);
+/**
+   @brief Remove a key and its value from the table.
+   @param table A pointer to the hash table.
+   @param key The key to delete.
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+void chta_remove(smb_chta *table, void *key, smb_status *status);
+/**
+   @brief Copy out the value associated with a key.
+
+   Unlike hta_get(), this can't return a pointer into the table, since another
+   thread could move the record as soon as the lock is released.
+   @param table A pointer to the hash table.
+   @param key The key whose value to retrieve.
+   @param[out] value Where to copy the value (may be NULL).
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+void chta_get(smb_chta *table, void *key, void *value, smb_status *status);
+/**
+   @brief Return true when a key is contained in the table.
+   @param table A pointer to the hash table.
+   @param key The key to search for.
+   @returns Whether the key is present.
+ */
+bool chta_contains(smb_chta *table, void *key);
+/**
+   @brief Return the number of keys in the table.
+
+   Each stripe is counted in turn, so if other threads are changing the table,
+   the result may not match the table at any one moment.
+   @param table A pointer to the hash table.
+   @returns The number of keys.
+ */
+unsigned int chta_length(smb_chta *table);
+
+#endif // LIBSTEPHEN_CHTA_H
@@ -0,0 +1,109 @@
+/***************************************************************************//**
+
+  @file         libstephen/hash.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Fast hash functions for strings, bytes and integers.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_HASH_H
+#define LIBSTEPHEN_HASH_H
+
+#include <stdint.h>
+
+#include "base.h"
+
+/**
+   @brief Hash a block of memory, 8 bytes at a time.
+
+   This is wyhash: every step is a 64 by 64 bit multiply, whose high and low
+   halves are folded together, so each input bit affects every output bit.
+   @param data The bytes to hash.
+   @param len The number of bytes.
+   @param seed Any value.  Different seeds give unrelated hashes.
+   @returns The 64 bit hash.
+ */
+uint64_t hash_bytes(const void *data, size_t len, uint64_t seed);
+/**
+   @brief Hash a nul terminated string, like hash_bytes().
+   @param str The string to hash (may be NULL, which hashes like "").
+   @param seed Any value.
+   @returns The 64 bit hash.
+ */
+uint64_t hash_string(const char *str, uint64_t seed);
+/**
+   @brief Scramble an integer, so that every bit of the input affects every bit
+   of the output.
+   @param x The integer to hash.
+   @param seed Any value.
+   @returns The 64 bit hash.
+ */
+uint64_t hash_int(uint64_t x, uint64_t seed);
+
+/**
+   @brief Set the seed used by the table adapters below.
+
+   If an attacker can choose keys, and knows the hash function, they can choose
+   keys that all collide, and make every operation on a table take linear time.
+   A secret, random seed prevents that.  The seed starts out as 0.  Change it
+   only while no table holds keys hashed with the old one.
+   @param seed The new seed.
+ */
+void hash_set_seed(uint64_t seed);
+/**
+   @brief Set the seed for the table adapters to a random value.
+
+   This reads /dev/urandom, and falls back on the time and process ID.
+ */
+void hash_random_seed(void);
+/**
+   @brief Return the seed used by the table adapters below.
+ */
+uint64_t hash_get_seed(void);
+
+/**
+   @brief Hash a string in a DATA, with hash_string(), for smb_ht.
+   @param data The string to hash, assuming that the value contained is a char*.
+   @returns The hash value of the string.
+ */
+unsigned int ht_fast_string_hash(DATA data);
+/**
+   @brief Hash an integer in a DATA, with hash_int(), for smb_ht.
+   @param data The integer to hash, assuming that the value is in data_llint.
+   @returns The hash value of the integer.
+ */
+unsigned int ht_int_hash(DATA data);
+/**
+   @brief Hash a string key (a char*), with hash_string(), for smb_hta.
+   @param data A pointer to the key.
+   @returns The hash value of the string.
+ */
+unsigned int hta_fast_string_hash(void *data);
+/**
+   @brief Hash an int key with hash_int(), for smb_hta.
+   @param data A pointer to the key.
+   @returns The hash value of the integer.
+ */
+unsigned int hta_int_hash(void *data);
+/**
+   @brief Hash a long long key with hash_int(), for smb_hta.
+   @param data A pointer to the key.
+   @returns The hash value of the integer.
+ */
+unsigned int hta_llint_hash(void *data);
+/**
+   @brief Hash an smb_hta_bytes key with hash_bytes(), for tables made by
+   hta_init_keys().
+   @param data A pointer to the key.
+   @returns The hash value of the bytes.
+ */
+unsigned int hta_bytes_hash(void *data);
+
+#endif // LIBSTEPHEN_HASH_H
@@ -30,6 +30,33 @@
  */
 #define HASH_TABLE_MAX_LOAD_FACTOR 0.5
 
+/**
+   @brief The initial amount of rows in a power of two sized hash table.
+ */
+#define HASH_TABLE_INITIAL_POW2 32
+
+/**
+   @brief The number of slots an incremental rehash moves on each change.
+
+   A rehash starts when the new table is at most half full, so this has to move
+   the old table over well before the new one fills up, even when shrinking.
+ */
+#define HASH_TABLE_MIGRATE_SLOTS 16
+
+/**
+   @brief How the number of slots in a hash table is chosen.
+
+   Prime sizes spread out any hash function, but every probe needs a modulo,
+   which is an integer division.  Power of two sizes need just a bit mask, and
+   hashes are scrambled first, so that weak hashes (which often differ only in
+   their high bits) still spread across the table.  HT_GROUP tables are sized
+   like HT_POW2 ones, but smb_hta also gives them an array of control bytes,
+   which it probes a group at a time (smb_ht treats them as HT_POW2).
+ */
+typedef enum smb_ht_policy {
+  HT_PRIME=0, HT_POW2, HT_GROUP
+} smb_ht_policy;
+
 /**
    @brief A hash function declaration.
 
@@ -67,6 +94,12 @@ typedef struct smb_ht_bckt
    */
   DATA value;
 
+  /**
+     @brief The hash of the key, so that rehashing needn't call the hash
+     function, and probing can skip keys that can't be equal.
+   */
+  unsigned int hash;
+
   /**
      @brief Marker for whether or not the table is full or empty.
    */
@@ -89,6 +122,16 @@ typedef struct smb_ht
    */
   unsigned int allocated;
 
+  /**
+     @brief The number of slots holding grave stones.
+   */
+  unsigned int graves;
+
+  /**
+     @brief How the number of slots is chosen.
+   */
+  smb_ht_policy policy;
+
   /**
      @brief The hash function for this hash table.
    */
@@ -104,8 +147,98 @@ typedef struct smb_ht
    */
   struct smb_ht_bckt *table;
 
+  /**
+     @brief The table being moved out of during an incremental rehash, or NULL.
+
+     Its length is the number of keys left in it, and they count towards this
+     table's length too.
+   */
+  struct smb_ht *old;
+
+  /**
+     @brief The number of slots of the old table already moved.
+   */
+  unsigned int migrated;
+
+  /**
+     @brief Whether rehashing happens a few slots at a time.
+   */
+  bool incremental;
+
+  /**
+     @brief The number of times the table has been rehashed.
+   */
+  unsigned long resizes;
+
+  /**
+     @brief Lookups, hits and slots probed, counted only when libstephen is
+     built with SMB_HT_STATS.  See ht_stats().
+   */
+  unsigned long lookups, hits, probes;
+
 } smb_ht;
 
+/**
+   @brief Number of probe lengths smb_ht_stats counts separately.  Longer probes
+   are counted with the longest.
+ */
+#define HT_STATS_PROBES 16
+
+/**
+   @brief How full a table is, and how far its keys are from home.
+
+   Filled in by ht_stats() and hta_stats().  During an incremental rehash, it
+   covers both the new and the old table.
+ */
+typedef struct smb_ht_stats
+{
+  /**
+     @brief The number of keys.
+   */
+  unsigned int length;
+
+  /**
+     @brief The number of slots.
+   */
+  unsigned int allocated;
+
+  /**
+     @brief The number of slots holding grave stones.
+   */
+  unsigned int graves;
+
+  /**
+     @brief probe_lengths[n] counts the keys that a lookup finds after probing
+     n + 1 slots (or groups of slots, for HT_GROUP tables in smb_hta).
+   */
+  unsigned int probe_lengths[HT_STATS_PROBES];
+
+  /**
+     @brief The longest probe needed to find any key.
+   */
+  unsigned int max_probe_length;
+
+  /**
+     @brief The number of rehashes, including ones which only cleared graves.
+   */
+  unsigned long resizes;
+
+  /**
+     @brief Bytes used by the table, including the struct itself.
+   */
+  size_t bytes;
+
+  /**
+     @brief The number of lookups (every get, insert and remove does one), how
+     many of them found their key, and how many slots (or groups) they probed
+     in all.  These are always zero unless
+     libstephen is built with SMB_HT_STATS (the ht_stats meson option), since
+     counting them slows down every lookup.
+   */
+  unsigned long lookups, hits, probes;
+
+} smb_ht_stats;
+
 /**
    @brief Initialize a hash table in memory already allocated.
    @param table A pointer to the table to initialize.
@@ -113,6 +246,28 @@ typedef struct smb_ht
    @param equal A comparison function for DATA.
  */
 void ht_init(smb_ht *table, HASH_FUNCTION hash_func, DATA_COMPARE equal);
+/**
+   @brief Initialize a hash table with a choice of sizing policy.
+   @param table A pointer to the table to initialize.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for DATA.
+   @param policy How the number of slots is chosen.
+ */
+void ht_init_policy(smb_ht *table, HASH_FUNCTION hash_func, DATA_COMPARE equal,
+                    smb_ht_policy policy);
+/**
+   @brief Choose whether the table rehashes all at once, or incrementally.
+
+   Normally, when a table grows, every key is moved to the new table during the
+   insert that triggered it, so that one insert takes time proportional to the
+   size of the table.  An incremental table keeps the old table around, moves
+   HASH_TABLE_MIGRATE_SLOTS of its slots on each insert or remove, and looks
+   keys up in both until it's empty.  Lookups don't move anything, since they
+   don't modify the table.  Turning this off finishes any rehash in progress.
+   @param table A pointer to the table.
+   @param incremental Whether to rehash incrementally.
+ */
+void ht_set_incremental(smb_ht *table, bool incremental);
 /**
    @brief Allocate and initialize a hash table.
    @param hash_func A function that takes one DATA and returns a hash value
@@ -160,14 +315,39 @@ void ht_delete(smb_ht *table);
 
    Expands the hash table if the load factor is below a threshold.  If the key
    already exists in the table, then the function will overwrite it with the new
-   data provided.
+   data provided.  Grave stones count towards the load factor, and once they
+   make up most of it, the table is rehashed at the same size to clear them.
    @param table A pointer to the hash table.
    @param key The key to insert.
    @param value The value to insert at the key.
  */
 void ht_insert(smb_ht *table, DATA key, DATA value);
+/**
+   @brief Return the value slot for a key, inserting the key if need be.
+
+   This probes the table once, where looking the key up and then inserting it
+   would probe twice.  A new key's value is LLINT(0).  The pointer is good until
+   the next change to the table.
+   @param table A pointer to the hash table.
+   @param key The key to find or insert.
+   @param[out] inserted Set to whether the key was inserted (may be NULL).
+   @returns A pointer to the key's value.
+ */
+DATA *ht_upsert(smb_ht *table, DATA key, bool *inserted);
+/**
+   @brief Make room for n keys in total, so that inserting them won't rehash.
+
+   Useful before loading a known number of keys.  Removing keys may still
+   shrink the table again.
+   @param table A pointer to the hash table.
+   @param n The number of keys to make room for.
+ */
+void ht_reserve(smb_ht *table, unsigned int n);
 /**
    @brief Remove the key, value pair stored in the hash table.
+
+   When few enough slots are left in use, the table shrinks, which rehashes it.
+   So, keys can't be removed while iterating over the table.
    @param table A pointer to the hash table.
    @param key The key to delete.
    @param deleter The action to perform on the value before removing it.
@@ -202,6 +382,43 @@ DATA ht_get(smb_ht const *table, DATA key, smb_status *status);
    @returns Whether the key is present.
  */
 bool ht_contains(smb_ht const *table, DATA key);
+/**
+   @brief Initialize a table holding the keys in either of two tables.
+
+   The two tables must have the same hash function.  The result has a's hash
+   function, comparison and policy, is sized up front for every key of both,
+   and keeps a's value for a key in both.  The larger table is copied first,
+   and no key is hashed again.  For a set with no values at all, see
+   hta_init_policy().
+   @param[out] out The table to initialize.
+   @param a The first table.
+   @param b The second table.
+ */
+void ht_union(smb_ht *out, smb_ht const *a, smb_ht const *b);
+/**
+   @brief Initialize a table holding the keys in both of two tables.
+
+   Like ht_union(), this keeps a's values.  It goes through the smaller table,
+   looking each key up in the larger one.
+   @param[out] out The table to initialize.
+   @param a The first table.
+   @param b The second table.
+ */
+void ht_intersection(smb_ht *out, smb_ht const *a, smb_ht const *b);
+/**
+   @brief Initialize a table holding the keys of a which aren't in b.
+   @param[out] out The table to initialize.
+   @param a The first table.
+   @param b The second table.
+ */
+void ht_difference(smb_ht *out, smb_ht const *a, smb_ht const *b);
+/**
+   @brief Return whether every key of a is in b.
+   @param a The first table.
+   @param b The second table.
+   @returns Whether a is a subset of b.
+ */
+bool ht_is_subset(smb_ht const *a, smb_ht const *b);
 /**
    @brief Return an iterator over the keys of the table.
    @param ht A pointer to the hash table.
@@ -225,8 +442,104 @@ unsigned int ht_string_hash(DATA data);
  */
 void ht_print(smb_ht const *table, int full_mode);
 
+/**
+   @brief Describe a table's size, load and probe lengths.
+   @param table The table to describe.
+   @param[out] stats Where to put the description.
+ */
+void ht_stats(smb_ht const *table, smb_ht_stats *stats);
+/**
+   @brief Print table stats from ht_stats() or hta_stats() in a few lines.
+   @param f File to print to.
+   @param stats The stats to print.
+ */
+void ht_print_stats(FILE *f, smb_ht_stats const *stats);
+
+/**
+   Count a lookup statistic, if they're compiled in.  Not really public, but
+   shared for hta.  Lookups don't otherwise write to the table, and may run
+   concurrently (in smb_chta), so this is atomic where it can be.
+ */
+#ifndef SMB_HT_STATS
+#define HT_COUNT(table, field, n) ((void) 0)
+#elif defined(__GNUC__)
+#define HT_COUNT(table, field, n) \
+  __atomic_fetch_add((unsigned long *) &(table)->field, (n), __ATOMIC_RELAXED)
+#else
+#define HT_COUNT(table, field, n) (*(unsigned long *) &(table)->field += (n))
+#endif
+/**
+   Add up a probe length for the stats.  Not really public, but shared for hta.
+ */
+void ht_stats_probe(smb_ht_stats *stats, unsigned int length);
 /**
    The next hash table size.  Not really public, but shared for hta.
  */
 int ht_next_size(int current);
+/**
+   The initial size for a policy.  Not really public, but shared for hta.
+ */
+unsigned int ht_initial_size(smb_ht_policy policy);
+/**
+   The next size for a policy.  Not really public, but shared for hta.
+ */
+unsigned int ht_grow_size(unsigned int current, smb_ht_policy policy);
+/**
+   Whether a table of a policy could have this many slots.  Not really public,
+   but shared for hta.
+ */
+bool ht_valid_size(unsigned int allocated, smb_ht_policy policy);
+/**
+   The size to rehash a table to once its slots are used up.  Not really
+   public, but shared for hta.
+ */
+unsigned int ht_rehash_size(unsigned int allocated, unsigned int length,
+                            smb_ht_policy policy, double max_load);
+/**
+   The size to shrink a table to, or allocated if it shouldn't shrink.  Not
+   really public, but shared for hta.
+ */
+unsigned int ht_shrink_size(unsigned int allocated, unsigned int length,
+                            smb_ht_policy policy, double max_load);
+/**
+   The size that holds n keys without rehashing.  Not really public, but shared
+   for hta.
+ */
+unsigned int ht_reserve_size(unsigned int allocated, unsigned int n,
+                             smb_ht_policy policy, double max_load);
+/**
+   The slot a hash belongs in.  Not really public, but shared for hta and the
+   tables in "libstephen/htt.h", which is why it's inline.
+
+   With a power of two size, the mask keeps only the low bits of the hash, so
+   the hash is multiplied by 2^32 divided by the golden ratio (Fibonacci
+   hashing), which mixes every bit into the high bits, and those are folded
+   back down.
+ */
+static inline unsigned int ht_home(unsigned int hash, unsigned int allocated,
+                                   smb_ht_policy policy)
+{
+  if (policy != HT_PRIME) {
+    hash *= 2654435769u;
+    return (hash ^ (hash >> 16)) & (allocated - 1);
+  }
+  return hash % allocated;
+}
+/**
+   The slot to try on the nth probe (starting with 1).  Not really public, but
+   shared like ht_home().
+
+   Prime tables use quadratic probing, adding 1, 3, 5, ... so that the nth probe
+   is n^2 slots from home.  That isn't guaranteed to visit every slot of a power
+   of two table, so they add 1, 2, 3, ... instead, which is.
+ */
+static inline unsigned int ht_probe(unsigned int index, unsigned int n,
+                                    unsigned int allocated,
+                                    smb_ht_policy policy)
+{
+  if (policy != HT_PRIME) {
+    return (index + n) & (allocated - 1);
+  }
+  return (index + 2 * n - 1) % allocated;
+}
 #endif // LIBSTEPHEN_HT_H
@@ -18,11 +18,115 @@
 #define LIBSTEPHEN_HTA_H
 
 #include "base.h"
+#include "ht.h" /* smb_ht_policy */
 
-#define HTA_KEY_OFFSET 1
+#include <stdint.h>
+#include <string.h> /* strlen, for HTA_STR */
+
+/**
+   @brief Offset of the key's hash in a record, after the mark.
+
+   It's stored unaligned, so read it with memcpy().
+ */
+#define HTA_HASH_OFFSET 1
+#define HTA_KEY_OFFSET (HTA_HASH_OFFSET + sizeof(unsigned int))
+
+/**
+   @brief Number of control bytes probed at once by HT_GROUP tables.
+ */
+#define HTA_GROUP_SIZE 16
+/**
+   @brief Control byte for an empty slot in an HT_GROUP table.
+ */
+#define HTA_CTRL_EMPTY 0x80
+/**
+   @brief Control byte for a deleted slot in an HT_GROUP table.
+ */
+#define HTA_CTRL_GRAVE 0xFE
 
 #define HTA_MARK(t, i) ((int8_t*)t->table)[i]
 
+/**
+   @brief Keys of up to this many bytes are kept in the slot itself, in tables
+   made by hta_init_keys().
+ */
+#define HTA_INLINE_KEY 12
+
+/**
+   @brief A key of a table made by hta_init_keys(): any run of bytes.
+
+   Pass a pointer to one wherever the table takes a key.  HTA_BYTES() and
+   HTA_STR() make them in place, as in hta_get(&t, &HTA_STR("key"), &status).
+ */
+typedef struct smb_hta_bytes
+{
+  /**
+     @brief The bytes of the key.
+   */
+  const void *data;
+
+  /**
+     @brief The number of bytes.
+   */
+  unsigned int length;
+
+} smb_hta_bytes;
+
+#define HTA_BYTES(d, n) ((smb_hta_bytes) {(d), (n)})
+#define HTA_STR(s) ((smb_hta_bytes) {(s), strlen(s)})
+
+/**
+   @brief How a table made by hta_init_keys() stores a key in its slot.
+
+   Keys of up to HTA_INLINE_KEY bytes are kept whole in data.  Longer ones are
+   copied into the table's arena, and data holds their first four bytes (which
+   are compared before looking in the arena), then their 8 byte offset there.
+ */
+typedef struct smb_hta_key
+{
+  /**
+     @brief The length of the key.
+   */
+  unsigned int length;
+
+  /**
+     @brief The key, or its prefix and offset.
+   */
+  char data[HTA_INLINE_KEY];
+
+} smb_hta_key;
+
+/**
+   @brief Where a table made by hta_init_keys() keeps keys too long to inline.
+
+   Keys are only ever appended.  Removing one leaves its bytes behind, and once
+   they make up half the arena, the next rehash copies the live keys into a new
+   one.
+ */
+typedef struct smb_hta_arena
+{
+  /**
+     @brief The bytes of the keys, end to end.
+   */
+  char *data;
+
+  /**
+     @brief The number of bytes used.
+   */
+  size_t length;
+
+  /**
+     @brief The number of bytes allocated.
+   */
+  size_t allocated;
+
+  /**
+     @brief The number of bytes used by keys since removed.
+   */
+  size_t dead;
+
+} smb_hta_arena;
+
 /**
    @brief A hash function declaration.
 
@@ -63,6 +167,11 @@ typedef struct smb_hta
    */
   unsigned int allocated;
 
+  /**
+     @brief The number of slots holding grave stones.
+   */
+  unsigned int graves;
+
   /**
      @brief Size of keys
    */
@@ -73,6 +182,11 @@ typedef struct smb_hta
    */
   unsigned int value_size;
 
+  /**
+     @brief How the number of slots is chosen.
+   */
+  smb_ht_policy policy;
+
   /**
      @brief The hash function for this hash table.
    */
@@ -88,6 +202,53 @@ typedef struct smb_hta
    */
   void *table;
 
+  /**
+     @brief Control bytes for each slot, if the policy is HT_GROUP.
+   */
+  uint8_t *ctrl;
+
+  /**
+     @brief The arena long keys are copied into, if made by hta_init_keys().
+     An old table shares it.
+   */
+  smb_hta_arena *arena;
+
+  /**
+     @brief The table being moved out of during an incremental rehash, or NULL.
+   */
+  struct smb_hta *old;
+
+  /**
+     @brief The number of slots of the old table already moved.
+   */
+  unsigned int migrated;
+
+  /**
+     @brief Whether rehashing happens a few slots at a time.
+   */
+  bool incremental;
+
+  /**
+     @brief The file mapping table and ctrl point into, if made by hta_map().
+   */
+  void *map;
+
+  /**
+     @brief The size of the file mapping.
+   */
+  size_t map_size;
+
+  /**
+     @brief The number of times the table has been rehashed.
+   */
+  unsigned long resizes;
+
+  /**
+     @brief Lookups, hits and slots (or groups) probed, counted only when
+     libstephen is built with SMB_HT_STATS.  See hta_stats().
+   */
+  unsigned long lookups, hits, probes;
+
 } smb_hta;
 
 /**
@@ -100,6 +261,58 @@ typedef struct smb_hta
  */
 void hta_init(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
               unsigned int key_size, unsigned int value_size);
+/**
+   @brief Initialize a hash table with a choice of sizing policy.
+
+   With a value_size of 0, the table is a set: records hold just the mark,
+   hash and key, and values may be passed as NULL.  A set of DATA keys this
+   way (key_size sizeof(DATA), with hta_llint_hash() and hta_llint_comp())
+   takes 13 bytes a slot, where an smb_ht with dummy values takes 24.
+   @param table A pointer to the table to initialize.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for DATA.
+   @param key_size Size of keys.
+   @param value_size Size of values.
+   @param policy How the number of slots is chosen.
+ */
+void hta_init_policy(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
+                     unsigned int key_size, unsigned int value_size,
+                     smb_ht_policy policy);
+/**
+   @brief Initialize a hash table whose keys are runs of bytes of any length.
+
+   Keys are passed as pointers to smb_hta_bytes.  The table copies each one in,
+   into the slot itself if it's short, or else into an arena the table owns,
+   so no key needs an allocation of its own, and the caller's buffer can be
+   reused as soon as the call returns.  Keys are hashed with hta_bytes_hash().
+   These tables can't be saved with hta_save(), or frozen.
+   @param table A pointer to the table to initialize.
+   @param value_size Size of values.
+   @param policy How the number of slots is chosen.
+ */
+void hta_init_keys(smb_hta *table, unsigned int value_size,
+                   smb_ht_policy policy);
+/**
+   @brief Return the bytes of a key stored in a table made by hta_init_keys().
+
+   This is for keys found in the table's slots (for instance, by a print
+   function passed to hta_print()).  The bytes are good until the next change
+   to the table.
+   @param table The table.
+   @param key A pointer to the key in its slot.
+   @returns The bytes of the key.
+ */
+smb_hta_bytes hta_key_bytes(smb_hta const *table, void *key);
+/**
+   @brief Choose whether the table rehashes all at once, or incrementally.
+
+   This works just like ht_set_incremental().  Since an incremental rehash
+   moves records from the old table to the new one, a pointer returned by
+   hta_get() is only good until the next insert or remove, as it always was.
+   @param table A pointer to the table.
+   @param incremental Whether to rehash incrementally.
+ */
+void hta_set_incremental(smb_hta *table, bool incremental);
 /**
    @brief Allocate and initialize a hash table.
    @param hash_func A function that takes one DATA and returns a hash value
@@ -135,13 +348,32 @@ void hta_delete(smb_hta *table);
    data provided.
    @param table A pointer to the hash table.
    @param key The key to insert.
-   @param value The value to insert at the key.
+   @param value The value to insert at the key (may be NULL in a set).
  */
 void hta_insert(smb_hta *table, void *key, void *value);
+/**
+   @brief Return the value of a key, inserting the key if need be.
+
+   This probes the table once, where looking the key up and then inserting it
+   would probe twice.  A new key's value is zeroed.  The pointer is good until
+   the next change to the table.
+   @param table A pointer to the hash table.
+   @param key The key to find or insert.
+   @param[out] inserted Set to whether the key was inserted (may be NULL).
+   @returns A pointer to the key's value.
+ */
+void *hta_upsert(smb_hta *table, void *key, bool *inserted);
+/**
+   @brief Make room for n keys in total, so that inserting them won't rehash.
+   @param table A pointer to the hash table.
+   @param n The number of keys to make room for.
+ */
+void hta_reserve(smb_hta *table, unsigned int n);
 /**
    @brief Remove the key, value pair stored in the hash table.
 
-   This function does not call a deleter on the stored data.
+   This function does not call a deleter on the stored data.  When few enough
+   slots are left in use, the table shrinks, which rehashes it.
    @param table A pointer to the hash table.
    @param key The key to delete.
    @param[out] status Status variable.
@@ -164,6 +396,92 @@ void *hta_get(smb_hta const *table, void *key, smb_status *status);
    @returns Whether the key is present.
  */
 bool hta_contains(smb_hta const *table, void *key);
+/**
+   @brief Initialize a table holding the keys in either of two tables.
+
+   The two tables must take the same keys and values, with the same hash
+   function.  The result has a's hash function, comparison and policy, is sized
+   up front for every key of both, and keeps a's value for a key in both.  The
+   larger table is copied first, and no key is hashed again.
+   @param[out] out The table to initialize.
+   @param a The first table.
+   @param b The second table.
+ */
+void hta_union(smb_hta *out, smb_hta const *a, smb_hta const *b);
+/**
+   @brief Initialize a table holding the keys in both of two tables.
+
+   Like hta_union(), this keeps a's values.  It goes through the smaller table,
+   looking each key up in the larger one.
+   @param[out] out The table to initialize.
+   @param a The first table.
+   @param b The second table.
+ */
+void hta_intersection(smb_hta *out, smb_hta const *a, smb_hta const *b);
+/**
+   @brief Initialize a table holding the keys of a which aren't in b.
+   @param[out] out The table to initialize.
+   @param a The first table.
+   @param b The second table.
+ */
+void hta_difference(smb_hta *out, smb_hta const *a, smb_hta const *b);
+/**
+   @brief Return whether every key of a is in b.
+   @param a The first table.
+   @param b The second table.
+   @returns Whether a is a subset of b.
+ */
+bool hta_is_subset(smb_hta const *a, smb_hta const *b);
+/**
+   @brief Describe a table's size, load and probe lengths.
+
+   Probe lengths of HT_GROUP tables count groups of HTA_GROUP_SIZE slots, since
+   that's what they probe.
+   @param table The table to describe.
+   @param[out] stats Where to put the description.
+ */
+void hta_stats(smb_hta const *table, smb_ht_stats *stats);
+/**
+   @brief Write a table to a file that hta_map() can open.
+
+   The file holds a header followed by the records and control bytes exactly as
+   they are in memory, so keys and values must not contain pointers (which
+   rules out the string hash functions, whose keys are char *).  The header
+   records the hash function when it's one of the integer ones from
+   "libstephen/hash.h", along with the seed they use.  Any incremental rehash is
+   finished first.  The byte order and int sizes of the machine are part of the
+   format.
+   @param table The table to write.
+   @param path The file to write.
+   @param[out] status Status variable.
+   @exception SMB_IO_ERROR If the file couldn't be written.
+   @exception SMB_FORMAT_ERROR If the table was made by hta_init_keys(), whose
+   keys aren't all in its records.
+ */
+void hta_save(smb_hta *table, const char *path, smb_status *status);
+/**
+   @brief Initialize a table from a file written by hta_save(), without reading
+   it.
+
+   The file is mapped privately, so opening it takes the same time whatever its
+   size, pages are read in as lookups touch them, and processes mapping the same
+   file share them.  The table can be changed like any other.  Changed pages
+   are copied, and the file itself is never written.  Destroy the table as
+   usual to unmap it.
+   @param table A pointer to the table to initialize.
+   @param path The file to map.
+   @param hash_func The hash function the table was saved with.
+   @param equal A comparison function for keys.
+   @param key_size Size of keys, which must match the file.
+   @param value_size Size of values, which must match the file.
+   @param[out] status Status variable.
+   @exception SMB_IO_ERROR If the file couldn't be opened or mapped.
+   @exception SMB_FORMAT_ERROR If the file isn't a table saved by hta_save() on
+   this kind of machine, or the sizes, hash function or seed don't match.
+ */
+void hta_map(smb_hta *table, const char *path, HTA_HASH hash_func,
+             HTA_COMP equal, unsigned int key_size, unsigned int value_size,
+             smb_status *status);
 /**
    @brief Return the hash of the data, interpreting it as a string.
    @param data The string to hash, assuming that the value contained is a char*.
@@ -171,7 +489,12 @@ bool hta_contains(smb_hta const *table, void *key);
  */
 unsigned int hta_string_hash(void *data);
 int hta_string_comp(void *left, void *right);
+/**
+   @brief Compare two smb_hta_bytes keys, by their bytes and then their length.
+ */
+int hta_bytes_comp(void *left, void *right);
 int hta_int_comp(void *left, void *right);
+int hta_llint_comp(void *left, void *right);
 /**
    @brief Print the entire hash table.
 
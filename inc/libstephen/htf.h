@@ -0,0 +1,301 @@
+/***************************************************************************//**
+
+  @file         libstephen/htf.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Frozen (read only) hash tables, using a minimal perfect hash.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_HTF_H
+#define LIBSTEPHEN_HTF_H
+
+#include <stdint.h>
+
+#include "base.h"
+#include "ht.h"
+#include "hta.h"
+
+/**
+   @brief One key, value pair of a frozen smb_ht.
+ */
+typedef struct smb_ht_frozen_entry
+{
+  /**
+     @brief The hash of the key.
+   */
+  unsigned int hash;
+
+  /**
+     @brief The key of this entry.
+   */
+  DATA key;
+
+  /**
+     @brief The value of this entry.
+   */
+  DATA value;
+
+} smb_ht_frozen_entry;
+
+/**
+   @brief An smb_ht which can no longer change, made by ht_freeze().
+
+   Keys are spread over buckets (about two to a bucket) by their hash.  Each
+   bucket has a number, its pilot, which was chosen so that mixing it with the
+   hashes of the bucket's keys gives each of them a slot of its own.  So, there
+   are exactly as many slots as keys, and a lookup goes straight to the one
+   slot its key could be in, and compares the stored hash before calling
+   equal() once.  Building this is like PTHash, or CHD.
+
+   A perfect hash can't separate keys whose hashes are equal, so all but one
+   key with any given hash go in a small overflow array, sorted by hash, which
+   a lookup only searches when the key isn't in its slot.  With a good 32 bit
+   hash, about n^2 / 2^33 of n keys end up there.
+ */
+typedef struct smb_ht_frozen
+{
+  /**
+     @brief The number of keys in the table.
+   */
+  unsigned int length;
+
+  /**
+     @brief The number of slots, one for every key not in the overflow.
+   */
+  unsigned int allocated;
+
+  /**
+     @brief The number of buckets (and pilots).
+   */
+  unsigned int nbuckets;
+
+  /**
+     @brief The number of keys in the overflow.
+   */
+  unsigned int noverflow;
+
+  /**
+     @brief The seed mixed into every hash, chosen while building.
+   */
+  uint64_t seed;
+
+  /**
+     @brief The hash function of the original table.
+   */
+  HASH_FUNCTION hash;
+
+  /**
+     @brief The comparison function of the original table.
+   */
+  DATA_COMPARE equal;
+
+  /**
+     @brief The pilot of each bucket.
+   */
+  uint32_t *pilots;
+
+  /**
+     @brief The slots.
+   */
+  smb_ht_frozen_entry *table;
+
+  /**
+     @brief Keys whose hash another key already has, sorted by hash.
+   */
+  smb_ht_frozen_entry *overflow;
+
+} smb_ht_frozen;
+
+/**
+   @brief An smb_hta which can no longer change, made by hta_freeze().
+
+   This works just like smb_ht_frozen.  Each record is the key's hash (stored
+   unaligned, like in smb_hta), then the key, then the value.
+ */
+typedef struct smb_hta_frozen
+{
+  /**
+     @brief The number of keys in the table.
+   */
+  unsigned int length;
+
+  /**
+     @brief The number of slots, one for every key not in the overflow.
+   */
+  unsigned int allocated;
+
+  /**
+     @brief The number of buckets (and pilots).
+   */
+  unsigned int nbuckets;
+
+  /**
+     @brief The number of keys in the overflow.
+   */
+  unsigned int noverflow;
+
+  /**
+     @brief Size of keys
+   */
+  unsigned int key_size;
+
+  /**
+     @brief Size of values
+   */
+  unsigned int value_size;
+
+  /**
+     @brief The seed mixed into every hash, chosen while building.
+   */
+  uint64_t seed;
+
+  /**
+     @brief The hash function of the original table.
+   */
+  HTA_HASH hash;
+
+  /**
+     @brief The comparison function of the original table.
+   */
+  HTA_COMP equal;
+
+  /**
+     @brief The pilot of each bucket.
+   */
+  uint32_t *pilots;
+
+  /**
+     @brief The records, one per slot.
+   */
+  void *table;
+
+  /**
+     @brief Records whose hash another record already has, sorted by hash.
+   */
+  void *overflow;
+
+  /**
+     @brief The file mapping the arrays point into, if made by
+     hta_frozen_map().
+   */
+  void *map;
+
+  /**
+     @brief The size of the file mapping.
+   */
+  size_t map_size;
+
+} smb_hta_frozen;
+
+/**
+   @brief Build a frozen copy of a table.
+
+   This takes a little longer than rehashing the table would (under a second
+   for a million keys), and doesn't change the table.  Keys and values are
+   copied, so if they're pointers, what they point to must outlive the frozen
+   table.
+   @param table The table to copy.
+   @param[out] frozen The frozen table to initialize.
+ */
+void ht_freeze(smb_ht const *table, smb_ht_frozen *frozen);
+/**
+   @brief Free the resources used by a frozen table, but not the pointer.
+   @param frozen The table to destroy.
+ */
+void ht_frozen_destroy(smb_ht_frozen *frozen);
+/**
+   @brief Return the value associated with a key.
+   @param frozen The table.
+   @param key The key whose value to retrieve.
+   @param[out] status Status variable.
+   @returns The value associated the key.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+DATA ht_frozen_get(smb_ht_frozen const *frozen, DATA key, smb_status *status);
+/**
+   @brief Return true when a key is contained in the table.
+   @param frozen The table.
+   @param key The key to search for.
+   @returns Whether the key is present.
+ */
+bool ht_frozen_contains(smb_ht_frozen const *frozen, DATA key);
+
+/**
+   @brief Build a frozen copy of a table.
+
+   Like ht_freeze(), this doesn't change the table.  Tables made by
+   hta_init_keys() can't be frozen, since their keys aren't all in their
+   records.  On error, the frozen table is left empty, and may still be
+   destroyed.
+   @param table The table to copy.
+   @param[out] frozen The frozen table to initialize.
+   @param[out] status Status variable.
+   @exception SMB_FORMAT_ERROR If the table was made by hta_init_keys().
+ */
+void hta_freeze(smb_hta const *table, smb_hta_frozen *frozen,
+                smb_status *status);
+/**
+   @brief Free (or unmap) the resources used by a frozen table, but not the
+   pointer.
+   @param frozen The table to destroy.
+ */
+void hta_frozen_destroy(smb_hta_frozen *frozen);
+/**
+   @brief Return the value associated with a key.
+   @param frozen The table.
+   @param key The key whose value to retrieve.
+   @param[out] status Status variable.
+   @returns A pointer to the value, which may not be written to.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+void *hta_frozen_get(smb_hta_frozen const *frozen, void *key,
+                     smb_status *status);
+/**
+   @brief Return true when a key is contained in the table.
+   @param frozen The table.
+   @param key The key to search for.
+   @returns Whether the key is present.
+ */
+bool hta_frozen_contains(smb_hta_frozen const *frozen, void *key);
+/**
+   @brief Write a frozen table to a file that hta_frozen_map() can open.
+
+   Like hta_save(), keys and values are written as they are, so they mustn't
+   contain pointers, and the file only works on the same kind of machine.
+   @param frozen The table to write.
+   @param path The file to write.
+   @param[out] status Status variable.
+   @exception SMB_IO_ERROR If the file couldn't be written.
+ */
+void hta_frozen_save(smb_hta_frozen const *frozen, const char *path,
+                     smb_status *status);
+/**
+   @brief Initialize a frozen table from a file written by hta_frozen_save(),
+   by mapping it read only.
+
+   Nothing is read or built up front, and processes mapping the same file share
+   its pages.
+   @param frozen The table to initialize.
+   @param path The file to map.
+   @param hash_func The hash function the table was built with.
+   @param equal A comparison function for keys.
+   @param key_size Size of keys, which must match the file.
+   @param value_size Size of values, which must match the file.
+   @param[out] status Status variable.
+   @exception SMB_IO_ERROR If the file couldn't be opened or mapped.
+   @exception SMB_FORMAT_ERROR If the file isn't a frozen table saved on this
+   kind of machine, the sizes don't match, or the hash function doesn't give
+   the stored hashes.
+ */
+void hta_frozen_map(smb_hta_frozen *frozen, const char *path,
+                    HTA_HASH hash_func, HTA_COMP equal, unsigned int key_size,
+                    unsigned int value_size, smb_status *status);
+
+#endif // LIBSTEPHEN_HTF_H
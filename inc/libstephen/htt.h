@@ -0,0 +1,247 @@
+/***************************************************************************//**
+
+  @file         libstephen/htt.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Hash tables specialized for a key and value type by a macro.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_HTT_H
+#define LIBSTEPHEN_HTT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "base.h"
+#include "hash.h" /* ht_fast_string_hash */
+#include "ht.h"   /* ht_home, ht_probe, sizes */
+
+/**
+   @brief Hash an integer key of any size for SMB_HT_DECLARE().
+
+   This only folds 64 bits down to 32, since ht_home() scrambles hashes for
+   power of two tables anyway.
+ */
+#define SMB_HT_INT_HASH(key) \
+  ((unsigned int) ((uint64_t) (key) ^ ((uint64_t) (key) >> 32)))
+/**
+   @brief Compare integer (or pointer) keys for SMB_HT_DECLARE().
+ */
+#define SMB_HT_INT_EQ(left, right) ((left) == (right))
+/**
+   @brief Hash a string key for SMB_HT_DECLARE(), with ht_fast_string_hash().
+ */
+#define SMB_HT_STR_HASH(key) ht_fast_string_hash(PTR((void *) (key)))
+/**
+   @brief Compare string keys for SMB_HT_DECLARE().
+ */
+#define SMB_HT_STR_EQ(left, right) (strcmp((left), (right)) == 0)
+
+/**
+   @brief Define a hash table type for one key and value type.
+
+   smb_ht calls its hash and comparison functions through pointers, on DATA,
+   so the compiler can't inline them, and every key and value takes 8 bytes.
+   This generates a table type called name, with static inline functions
+   name_init(), name_destroy(), name_insert(), name_upsert(), name_get(),
+   name_contains(), name_remove(), name_reserve() and name_next(), which take
+   and return key_type and val_type directly, and call hash_expr and eq_expr
+   with no indirection.  They behave like the smb_ht functions of the same
+   names.
+
+   The tables use the HT_POW2 policy, and share ht_home(), ht_probe() and the
+   sizing functions with smb_ht.  Like smb_ht, they keep each key's hash, so
+   rehashing doesn't call hash_expr, and probes only call eq_expr on keys
+   whose hash matches.
+   Iterate over one like this:
+
+       for (i = name_next(t, 0); i < t->allocated; i = name_next(t, i + 1))
+         use(t->table[i].key, t->table[i].value);
+
+   Use it once per type, at file scope:
+
+       SMB_HT_DECLARE(ht_int_dbl, int, double, SMB_HT_INT_HASH, SMB_HT_INT_EQ)
+
+   @param name The name of the table type, and prefix of its functions.
+   @param key_type The key type, which must be assignable.
+   @param val_type The value type, which must be assignable.
+   @param hash_expr A function or macro taking a key_type and returning an
+   unsigned int hash.
+   @param eq_expr A function or macro taking two key_type and returning true
+   if they're equal.
+ */
+#define SMB_HT_DECLARE(name, key_type, val_type, hash_expr, eq_expr)           \
+  typedef struct name##_bckt                                                   \
+  {                                                                            \
+    key_type key;                                                              \
+    val_type value;                                                            \
+    unsigned int hash;                                                         \
+    unsigned char mark;                                                        \
+  } name##_bckt;                                                               \
+                                                                               \
+  typedef struct name                                                          \
+  {                                                                            \
+    unsigned int length;                                                       \
+    unsigned int allocated;                                                    \
+    unsigned int graves;                                                       \
+    name##_bckt *table;                                                        \
+  } name;                                                                      \
+                                                                               \
+  static inline void name##_init(name *table)                                  \
+  {                                                                            \
+    table->length = 0;                                                         \
+    table->graves = 0;                                                         \
+    table->allocated = ht_initial_size(HT_POW2);                               \
+    table->table = smb_new(name##_bckt, table->allocated);                     \
+    memset(table->table, 0, table->allocated * sizeof(name##_bckt));           \
+  }                                                                            \
+                                                                               \
+  static inline void name##_destroy(name *table)                               \
+  {                                                                            \
+    smb_free(table->table);                                                    \
+  }                                                                            \
+                                                                               \
+  /* The key's slot, or else where it goes, like ht_find_retrieve(). */        \
+  static inline unsigned int name##_find(const name *table, key_type key,      \
+                                         unsigned int hash)                    \
+  {                                                                            \
+    unsigned int index = ht_home(hash, table->allocated, HT_POW2);             \
+    unsigned int j = 1, grave = 0;                                             \
+    bool found_grave = false;                                                  \
+                                                                               \
+    while (table->table[index].mark != HT_EMPTY &&                             \
+           !(table->table[index].mark == HT_FULL &&                            \
+             table->table[index].hash == hash &&                               \
+             eq_expr(table->table[index].key, key))) {                         \
+      if (table->table[index].mark == HT_GRAVE && !found_grave) {              \
+        grave = index;                                                         \
+        found_grave = true;                                                    \
+      }                                                                        \
+      index = ht_probe(index, j++, table->allocated, HT_POW2);                 \
+    }                                                                          \
+    if (found_grave && table->table[index].mark == HT_EMPTY) {                 \
+      return grave;                                                            \
+    }                                                                          \
+    return index;                                                              \
+  }                                                                            \
+                                                                               \
+  static inline void name##_rehash(name *table, unsigned int allocated)        \
+  {                                                                            \
+    name##_bckt *old = table->table;                                           \
+    unsigned int i, j, index, old_allocated = table->allocated;                \
+                                                                               \
+    table->graves = 0;                                                         \
+    table->allocated = allocated;                                              \
+    table->table = smb_new(name##_bckt, allocated);                            \
+    memset(table->table, 0, allocated * sizeof(name##_bckt));                  \
+    for (i = 0; i < old_allocated; i++) {                                      \
+      if (old[i].mark == HT_FULL) {                                            \
+        index = ht_home(old[i].hash, allocated, HT_POW2);                      \
+        for (j = 1; table->table[index].mark == HT_FULL; j++) {                \
+          index = ht_probe(index, j, allocated, HT_POW2);                      \
+        }                                                                      \
+        table->table[index] = old[i];                                          \
+      }                                                                        \
+    }                                                                          \
+    smb_free(old);                                                             \
+  }                                                                            \
+                                                                               \
+  static inline void name##_reserve(name *table, unsigned int n)               \
+  {                                                                            \
+    unsigned int size = ht_reserve_size(table->allocated, n, HT_POW2,          \
+                                        HASH_TABLE_MAX_LOAD_FACTOR);           \
+    if (size != table->allocated ||                                            \
+        n + table->graves > table->allocated * HASH_TABLE_MAX_LOAD_FACTOR) {   \
+      name##_rehash(table, size);                                              \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static inline val_type *name##_upsert(name *table, key_type key,             \
+                                        bool *inserted)                        \
+  {                                                                            \
+    unsigned int index, hash = hash_expr(key);                                 \
+    if (table->length + table->graves >=                                       \
+        table->allocated * HASH_TABLE_MAX_LOAD_FACTOR) {                       \
+      name##_rehash(table, ht_rehash_size(table->allocated, table->length,     \
+                                          HT_POW2,                             \
+                                          HASH_TABLE_MAX_LOAD_FACTOR));        \
+    }                                                                          \
+    if (inserted) {                                                            \
+      *inserted = false;                                                       \
+    }                                                                          \
+    index = name##_find(table, key, hash);                                     \
+    if (table->table[index].mark == HT_FULL) {                                 \
+      return &table->table[index].value;                                       \
+    }                                                                          \
+    if (table->table[index].mark == HT_GRAVE) {                                \
+      table->graves--;                                                         \
+    }                                                                          \
+    table->table[index].key = key;                                             \
+    table->table[index].hash = hash;                                           \
+    table->table[index].mark = HT_FULL;                                        \
+    memset(&table->table[index].value, 0, sizeof(val_type));                   \
+    table->length++;                                                           \
+    if (inserted) {                                                            \
+      *inserted = true;                                                        \
+    }                                                                          \
+    return &table->table[index].value;                                         \
+  }                                                                            \
+                                                                               \
+  static inline void name##_insert(name *table, key_type key, val_type value)  \
+  {                                                                            \
+    *name##_upsert(table, key, NULL) = value;                                  \
+  }                                                                            \
+                                                                               \
+  static inline val_type *name##_get(const name *table, key_type key,          \
+                                  smb_status *status)                          \
+  {                                                                            \
+    unsigned int index = name##_find(table, key, hash_expr(key));              \
+    *status = SMB_SUCCESS;                                                     \
+    if (table->table[index].mark != HT_FULL) {                                 \
+      *status = SMB_NOT_FOUND_ERROR;                                           \
+      return NULL;                                                             \
+    }                                                                          \
+    return &table->table[index].value;                                         \
+  }                                                                            \
+                                                                               \
+  static inline bool name##_contains(const name *table, key_type key)          \
+  {                                                                            \
+    unsigned int index = name##_find(table, key, hash_expr(key));              \
+    return table->table[index].mark == HT_FULL;                                \
+  }                                                                            \
+                                                                               \
+  static inline void name##_remove(name *table, key_type key,                  \
+                                   smb_status *status)                         \
+  {                                                                            \
+    unsigned int index = name##_find(table, key, hash_expr(key)), size;        \
+    *status = SMB_SUCCESS;                                                     \
+    if (table->table[index].mark != HT_FULL) {                                 \
+      *status = SMB_NOT_FOUND_ERROR;                                           \
+      return;                                                                  \
+    }                                                                          \
+    table->table[index].mark = HT_GRAVE;                                       \
+    table->length--;                                                           \
+    table->graves++;                                                           \
+    size = ht_shrink_size(table->allocated, table->length, HT_POW2,            \
+                          HASH_TABLE_MAX_LOAD_FACTOR);                         \
+    if (size != table->allocated) {                                            \
+      name##_rehash(table, size);                                              \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static inline unsigned int name##_next(const name *table, unsigned int i)    \
+  {                                                                            \
+    while (i < table->allocated && table->table[i].mark != HT_FULL) {          \
+      i++;                                                                     \
+    }                                                                          \
+    return i;                                                                  \
+  }
+
+#endif // LIBSTEPHEN_HTT_H
@@ -0,0 +1,201 @@
+/***************************************************************************//**
+
+  @file         libstephen/od.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        An insertion ordered, compact hash table.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_OD_H
+#define LIBSTEPHEN_OD_H
+
+#include <stdint.h>
+
+#include "base.h"  /* DATA, DATA_ACTION */
+#include "list.h"  /* smb_iter */
+#include "ht.h"    /* HASH_FUNCTION */
+
+/**
+   @brief The smallest number of index slots an ordered dict has.
+ */
+#define OD_INITIAL_SIZE 8
+
+/**
+   @brief One key, value pair, stored in insertion order.
+ */
+typedef struct smb_od_entry
+{
+  /**
+     @brief The key of this entry.
+   */
+  DATA key;
+
+  /**
+     @brief The value of this entry.
+   */
+  DATA value;
+
+  /**
+     @brief The hash of the key.
+   */
+  unsigned int hash;
+
+  /**
+     @brief False once the entry has been removed.
+   */
+  bool live;
+
+} smb_od_entry;
+
+/**
+   @brief A hash table which remembers the order keys were inserted in.
+
+   Like Python's dict (since 3.6), entries are kept in a dense array, in the
+   order they were inserted, and the hash table itself holds only the indices
+   of entries.  Those are 1, 2 or 4 bytes each, depending on how many entries
+   there can be.  So, iterating is a scan over an array with no holes (except
+   for removed entries, until the next resize), and each entry takes less
+   memory than in an smb_ht, which needs twice as many slots as keys.
+ */
+typedef struct smb_od
+{
+  /**
+     @brief The number of items in the table.
+   */
+  unsigned int length;
+
+  /**
+     @brief The number of entries used, including removed ones.
+   */
+  unsigned int nentries;
+
+  /**
+     @brief The number of slots in the index table (a power of two).
+   */
+  unsigned int size;
+
+  /**
+     @brief Bytes per index: 1, 2 or 4.
+   */
+  unsigned int width;
+
+  /**
+     @brief The hash function for this table.
+   */
+  HASH_FUNCTION hash;
+
+  /**
+     @brief Function to use to compare equality.
+   */
+  DATA_COMPARE equal;
+
+  /**
+     @brief The index table, of size slots, each width bytes.
+   */
+  void *indices;
+
+  /**
+     @brief The entries, with room for two thirds of size.
+   */
+  smb_od_entry *entries;
+
+} smb_od;
+
+/**
+   @brief Initialize an ordered dict in memory already allocated.
+   @param table A pointer to the table to initialize.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for DATA.
+ */
+void od_init(smb_od *table, HASH_FUNCTION hash_func, DATA_COMPARE equal);
+/**
+   @brief Allocate and initialize an ordered dict.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for DATA.
+   @returns A pointer to the new table.
+ */
+smb_od *od_create(HASH_FUNCTION hash_func, DATA_COMPARE equal);
+/**
+   @brief Free resources used by the table, but not the pointer itself.
+   Perform an action on each value first.
+   @param table The table to destroy.
+   @param deleter The action to perform on each value (may be NULL).
+ */
+void od_destroy_act(smb_od *table, DATA_ACTION deleter);
+/**
+   @brief Free resources used by the table, but not the pointer itself.
+   @param table The table to destroy.
+ */
+void od_destroy(smb_od *table);
+/**
+   @brief Free the table and its resources, performing an action on each value
+   first.
+   @param table The table to free.
+   @param deleter The action to perform on each value (may be NULL).
+ */
+void od_delete_act(smb_od *table, DATA_ACTION deleter);
+/**
+   @brief Free the table and its resources.
+   @param table The table to free.
+ */
+void od_delete(smb_od *table);
+
+/**
+   @brief Insert data into the table.
+
+   A new key goes after every key already in the table.  Overwriting the value
+   of a key doesn't move it.
+   @param table A pointer to the table.
+   @param key The key to insert.
+   @param value The value to insert at the key.
+ */
+void od_insert(smb_od *table, DATA key, DATA value);
+/**
+   @brief Remove a key, value pair from the table.
+   @param table A pointer to the table.
+   @param key The key to delete.
+   @param deleter The action to perform on the value before removing it.
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+void od_remove_act(smb_od *table, DATA key, DATA_ACTION deleter,
+                   smb_status *status);
+/**
+   @brief Remove a key, value pair from the table.
+   @param table A pointer to the table.
+   @param key The key to delete.
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+void od_remove(smb_od *table, DATA key, smb_status *status);
+/**
+   @brief Return the value associated with a key.
+   @param table A pointer to the table.
+   @param key The key whose value to retrieve.
+   @param[out] status Status variable.
+   @returns The value associated the key.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+DATA od_get(smb_od const *table, DATA key, smb_status *status);
+/**
+   @brief Return true when a key is contained in the table.
+   @param table A pointer to the table.
+   @param key The key to search for.
+   @returns Whether the key is present.
+ */
+bool od_contains(smb_od const *table, DATA key);
+/**
+   @brief Return an iterator over the keys of the table, in insertion order.
+   @param table A pointer to the table.
+   @returns An iterator struct.
+ */
+smb_iter od_get_iter(const smb_od *table);
+
+#endif // LIBSTEPHEN_OD_H
@@ -16,10 +16,13 @@
 #ifndef SMB_PIKE_REGEX_H
 #define SMB_PIKE_REGEX_H
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <wchar.h>
 
+#include "libstephen/cb.h"
+
 // DEFINITIONS
 
 /// @cond HIDDEN_SYMBOLS
@@ -30,6 +33,23 @@
  */
 typedef struct Instr Instr;
 struct Instr;
+/**
+   A compact, packed form of a program, which is what the virtual machine
+   actually executes.  Again, client code doesn't need the details.
+ */
+typedef struct Prog Prog;
+struct Prog;
+/**
+   Scratch space for the backtracking matcher, kept by a Matcher.
+ */
+typedef struct BitState BitState;
+struct BitState;
+
+/**
+   Native code for a program, made by remjit().
+ */
+typedef struct Jit Jit;
+struct Jit;
 /// @endcond HIDDEN_SYMBOLS
 
 /**
@@ -51,6 +71,65 @@ struct Regex {
      Pointer to instruction buffer.
    */
   Instr *i;
+  /**
+     Packed copy of the instructions, created by recomp() and reread().  If you
+     modify the instruction buffer, this will not reflect your changes.
+   */
+  Prog *p;
+};
+
+/**
+   This typedef is for convenience.  See the documentation for struct Matcher.
+ */
+typedef struct Matcher Matcher;
+/**
+   Everything needed to run one regex many times without allocating.
+
+   Functions that take a Regex set up their scratch space on every call.  When
+   the same regex is run over a lot of text, like splitting every line of a
+   log, initialize a Matcher once with reminit() and pass it in instead.
+ */
+struct Matcher {
+  /**
+     Program being run.
+   */
+  const Prog *p;
+  /**
+     Program packed by reminit(), if the regex didn't have one.
+   */
+  Prog *own;
+  /**
+     Captures from the most recent successful search.
+   */
+  size_t *saved;
+  /**
+     Backtracker scratch space.
+   */
+  BitState *bt;
+
+  /**
+     Native code for the program, if remjit() made any.
+   */
+  Jit *jit;
+};
+
+/**
+   This typedef is for convenience.  See the documentation for struct Slice.
+ */
+typedef struct Slice Slice;
+/**
+   A piece of a string, given by its offset and length, so that nothing needs
+   to be copied.
+ */
+struct Slice {
+  /**
+     Index of the first character.
+   */
+  size_t offset;
+  /**
+     Number of characters.
+   */
+  size_t length;
 };
 
 /**
@@ -122,6 +201,16 @@ Regex refread(FILE *f);
    @param f The file to write to.
  */
 void rewrite(Regex r, FILE *f);
+/**
+   Writes a program as C source code, so that a regex which is known at build
+   time can be compiled into your program, and cost nothing at startup.  The
+   generated code defines a `const Regex` with the given name, which you can
+   declare elsewhere with `extern const Regex name;`.  Don't refree() it!
+   @param r The regex to write.
+   @param name Name of the generated variable (a valid C identifier).
+   @param f The file to write to.
+ */
+void rewritec(Regex r, const char *name, FILE *f);
 /**
    Free a Regex object.  You must do this when you're done with it.
    @param r Regex to free.
@@ -158,6 +247,177 @@ ssize_t reexec(Regex r, const char *input, size_t **saved);
    @returns Length of match, or -1 if no match.
 */
 ssize_t reexecw(Regex r, const wchar_t *input, size_t **saved);
+/**
+   Search for the first match of a regex anywhere in a string.  This finds the
+   leftmost match, and of the matches starting there, the same one that
+   reexec() would find.  Capture indices are relative to the start of the
+   input, not the start of the match.
+   @param r Compiled regular expression bytecode to execute.
+   @param input Text to search.
+   @param start Out pointer for the index the match starts at (may be NULL).
+   @param saved Out pointer for captured indices.
+   @returns Length of match, or -1 if no match.
+ */
+ssize_t research(Regex r, const char *input, size_t *start, size_t **saved);
+/**
+   Search for the first match of a regex anywhere in a wide string.
+   @param r Compiled regular expression bytecode to execute.
+   @param input Text to search.
+   @param start Out pointer for the index the match starts at (may be NULL).
+   @param saved Out pointer for captured indices.
+   @returns Length of match, or -1 if no match.
+ */
+ssize_t researchw(Regex r, const wchar_t *input, size_t *start,
+                  size_t **saved);
+/**
+   Replace every match of a regex in a string, appending the result to a cbuf.
+
+   The input is searched once from start to finish.  Text between matches is
+   copied to the output unchanged, and each match is replaced by repl, where
+   `$0` is the whole match, `$1` through `$9` are captures, `${N}` is capture
+   N, and `$$` is a dollar sign.  An empty match doesn't stop the search; the
+   next character is copied and the search continues after it.
+   @param r Compiled regular expression.
+   @param input Text to substitute in.
+   @param repl Replacement text.
+   @param out Buffer to append the result to.
+   @returns The number of substitutions made.
+ */
+size_t resub(Regex r, const char *input, const char *repl, cbuf *out);
+/**
+   Replace at most max matches of a regex in a string.  See resub().
+   @param r Compiled regular expression.
+   @param input Text to substitute in.
+   @param repl Replacement text.
+   @param max Maximum number of substitutions to make.
+   @param out Buffer to append the result to.
+   @returns The number of substitutions made.
+ */
+size_t resubn(Regex r, const char *input, const char *repl, size_t max,
+              cbuf *out);
+/**
+   Replace every match of a regex in a wide string.  See resub().
+   @param r Compiled regular expression.
+   @param input Text to substitute in.
+   @param repl Replacement text.
+   @param out Buffer to append the result to.
+   @returns The number of substitutions made.
+ */
+size_t resubw(Regex r, const wchar_t *input, const wchar_t *repl, wcbuf *out);
+/**
+   Replace at most max matches of a regex in a wide string.  See resub().
+   @param r Compiled regular expression.
+   @param input Text to substitute in.
+   @param repl Replacement text.
+   @param max Maximum number of substitutions to make.
+   @param out Buffer to append the result to.
+   @returns The number of substitutions made.
+ */
+size_t resubnw(Regex r, const wchar_t *input, const wchar_t *repl, size_t max,
+               wcbuf *out);
+/**
+   Set up a Matcher for a regex.  The regex must outlive the Matcher.
+   @param m Matcher to initialize.
+   @param r Compiled regular expression.
+ */
+void reminit(Matcher *m, Regex r);
+/**
+   Free the memory held by a Matcher.
+   @param m Matcher to destroy.
+ */
+void remdestroy(Matcher *m);
+/**
+   Compile a Matcher's program to native code, which rematch() and friends use
+   from then on for narrow strings short enough for the backtracker.  This is
+   only worth it for a regex that will be run a lot.  Native code is only
+   generated on x86-64, and not if libstephen was built with the regex_jit
+   option turned off, or if the system won't allow executable memory.  In any
+   of those cases the Matcher keeps using the interpreters, which give exactly
+   the same results.
+   @param m Matcher to compile.
+   @returns True if the Matcher now runs native code.
+ */
+bool remjit(Matcher *m);
+/**
+   Match a regex against the start of a string, like reexec(), using a Matcher.
+   @param m Matcher for the regex.
+   @param input Text to match.
+   @returns Length of match, or -1 if no match.  On a match, the captured
+   indices are in m->saved, until the Matcher is used again.
+ */
+ssize_t rematch(Matcher *m, const char *input);
+/**
+   Match a regex against the start of a wide string.  See rematch().
+   @param m Matcher for the regex.
+   @param input Text to match.
+   @returns Length of match, or -1 if no match.
+ */
+ssize_t rematchw(Matcher *m, const wchar_t *input);
+/**
+   Match a regex against the start of many strings at once.
+
+   The work is split between nthreads threads, each with its own Matcher, all
+   running the regex's program.  Nothing is written to the regex, so it may be
+   shared with other threads while this runs.
+   @param r Compiled regular expression.
+   @param inputs Array of strings to match.
+   @param n Number of strings.
+   @param nthreads Number of threads to use, or 0 for one per online CPU.
+   @param[out] results Array of n lengths, filled in as by reexec().
+ */
+void rebatch(Regex r, const char *const *inputs, size_t n, int nthreads,
+             ssize_t *results);
+/**
+   Split a string into fields separated by matches of a regex.
+
+   The input is walked once, and each field is reported as a Slice of the
+   input.  Matches of length zero never separate fields.  With a limit of max
+   fields, the last field holds the remainder of the input, delimiters and all.
+   Only the first nout slices are stored, but the count of all of them is
+   returned, so a short array can be grown and the split retried.
+   @param m Matcher for the delimiter regex.
+   @param input Text to split.
+   @param max Maximum number of fields, or 0 for no limit.
+   @param out Array to store the fields in.
+   @param nout Size of the out array.
+   @returns The number of fields in the input.
+ */
+size_t resplit(Matcher *m, const char *input, size_t max, Slice *out,
+               size_t nout);
+/**
+   Split a wide string into fields.  See resplit().
+   @param m Matcher for the delimiter regex.
+   @param input Text to split.
+   @param max Maximum number of fields, or 0 for no limit.
+   @param out Array to store the fields in.
+   @param nout Size of the out array.
+   @returns The number of fields in the input.
+ */
+size_t resplitw(Matcher *m, const wchar_t *input, size_t max, Slice *out,
+                size_t nout);
+/**
+   Split a string into fields, calling a function on each one.  See resplit().
+   @param m Matcher for the delimiter regex.
+   @param input Text to split.
+   @param max Maximum number of fields, or 0 for no limit.
+   @param f Function called with each field, in order.
+   @param data Passed to f.
+   @returns The number of fields in the input.
+ */
+size_t resplitf(Matcher *m, const char *input, size_t max,
+                void (*f)(Slice, void *), void *data);
+/**
+   Split a wide string into fields, calling a function on each one.  See
+   resplit().
+   @param m Matcher for the delimiter regex.
+   @param input Text to split.
+   @param max Maximum number of fields, or 0 for no limit.
+   @param f Function called with each field, in order.
+   @param data Passed to f.
+   @returns The number of fields in the input.
+ */
+size_t resplitfw(Matcher *m, const wchar_t *input, size_t max,
+                 void (*f)(Slice, void *), void *data);
 /**
    Return the number of saved index slots required by a regex.
    @param r The regular expression bytecode.
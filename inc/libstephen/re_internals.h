@@ -18,6 +18,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <wchar.h>
 
 #include "re.h"
@@ -31,7 +32,56 @@ struct Instr {
   wchar_t c;      // character
   size_t s;       // slot for "saving" a string index
   Instr *x, *y;   // targets for jump and split
-  size_t lastidx; // used by Pike VM for fast membership testing
+};
+
+/**
+   @brief Packed instruction, which is what the Pike VM executes.
+
+   Instr is convenient for code generation, but most of it goes unused by any
+   one instruction.  PInstr is 8 bytes, so that large programs stay in cache.
+   The operands depend on the opcode:
+   - Char: arg is the character.
+   - Jump: x is the target, relative to this instruction.
+   - Split: x and arg are the targets, relative to this instruction.
+   - Save: arg is the slot.
+   - Range, NRange: arg is the index of the class in the program's class
+     table.
+ */
+typedef struct PInstr PInstr;
+struct PInstr {
+  unsigned int code : 8; // opcode
+  signed int x : 24;     // first operand
+  int32_t arg;           // second operand
+};
+
+/**
+   @brief A character class used by Range and NRange instructions.
+
+   Membership of every char value is precomputed into a bitmap, so that testing
+   a narrow character is a single bit test.  The ranges themselves are kept for
+   wide characters that don't fit in a char.
+ */
+typedef struct PClass PClass;
+struct PClass {
+  uint32_t bits[8]; // membership, indexed by (unsigned char)
+  size_t start;     // index of the first range in the range table
+  size_t n;         // number of ranges
+};
+
+/**
+   @brief A packed program, with side tables for the packed instructions.
+
+   A program is never modified once it is packed, so the tables may also be
+   static constant data (see rewritec()).
+ */
+struct Prog {
+  size_t n;              // number of instructions
+  size_t nsave;          // number of save instructions
+  const PInstr *code;    // instructions
+  const PClass *classes; // classes, referred to by Range and NRange
+  const char *ranges;    // pairs of characters, referred to by classes
+  size_t nlit;           // number of literals, if that's all it matches
+  const char *lits;      // the literals in priority order, NUL terminated
 };
 
 /**
@@ -131,6 +181,37 @@ PTree *SUB(Lexer *l);
 PTree *reparse(const char *regex);
 PTree *reparsew(const wchar_t *winput);
 
+/* Packing */
+Prog *repack(const Instr *code, size_t n);
+void progfree(Prog *p);
+bool inclass(const Prog *p, PInstr in, wchar_t test);
+char *findlits(const Instr *code, size_t n, size_t *nlit);
+ssize_t litexec(const Prog *p, const char *input, size_t len, bool anchored,
+                size_t *start);
+
+/* Matching */
+#define BACKTRACK_MAX_BITS (256 * 1024)
+#if defined(__x86_64__) && defined(__unix__) && !defined(SMB_RE_NO_JIT)
+#define SMB_RE_JIT
+#endif
+size_t inputlen(struct Input in, size_t max);
+ssize_t pike(const Prog *p, struct Input input, bool anchored, size_t *start,
+             size_t **saved);
+ssize_t backtrack(const Prog *p, struct Input input, size_t len, bool anchored,
+                  size_t *start, size_t **saved);
+BitState *btnew(const Prog *p);
+void btfree(BitState *bt);
+size_t *btcaps(BitState *bt);
+ssize_t btrun(BitState *bt, const Prog *p, struct Input input, size_t len,
+              bool anchored, size_t *start);
+Jit *jitnew(const Prog *p);
+void jitfree(Jit *j);
+size_t *jitcaps(Jit *j);
+ssize_t jitrun(Jit *j, const char *input, size_t len, bool anchored,
+               size_t *start);
+ssize_t remsearch(Matcher *m, struct Input input, size_t len, size_t from,
+                  size_t *start);
+
 /* Utitlites */
 void free_tree(PTree *tree);
 char *char_to_string(char c);
@@ -0,0 +1,297 @@
+/***************************************************************************//**
+
+  @file         ala.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Implementation of "libstephen/ala.h".
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libstephen/ala.h"
+
+/**
+   @brief The number of items a list is allocated with.
+ */
+#define SMB_ALA_BLOCK_SIZE 16
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief Reallocate the list to hold list->allocated items.
+
+   Lists of zero sized items still get a byte, since realloc() may return NULL
+   for zero bytes.
+ */
+static void ala_resize(smb_ala *list)
+{
+  size_t size = (size_t) list->allocated * list->item_size;
+  list->data = smb___renew(list->data, size ? size : 1);
+}
+
+/**
+   @brief Return true when a pointer is into the items of the list.
+ */
+static bool ala_owns(const smb_ala *list, const void *ptr)
+{
+  const char *p = ptr, *data = list->data;
+  return p >= data && p < data + (size_t) list->length * list->item_size;
+}
+
+/**
+   @brief Expand the list to hold at least n items, at least doubling its
+   capacity.
+
+   Items being copied in may be in the list already, so they're passed along
+   and returned where they are after the move.
+ */
+static const void *ala_grow(smb_ala *list, int n, const void *items)
+{
+  int allocated = list->allocated < SMB_ALA_BLOCK_SIZE ? SMB_ALA_BLOCK_SIZE :
+    2 * list->allocated;
+  size_t offset = 0;
+  bool owned = ala_owns(list, items);
+
+  if (owned) {
+    offset = (const char *) items - (char *) list->data;
+  }
+  list->allocated = allocated < n ? n : allocated;
+  ala_resize(list);
+  return owned ? (char *) list->data + offset : items;
+}
+
+/**
+   @brief Copy an item into place, or zero it if there's none.
+ */
+static void *ala_fill(smb_ala *list, int index, const void *item)
+{
+  void *slot = ALA_ITEM(list, index);
+  if (item) {
+    memcpy(slot, item, list->item_size);
+  } else {
+    memset(slot, 0, list->item_size);
+  }
+  return slot;
+}
+
+/*******************************************************************************
+
+                                Public Functions
+
+*******************************************************************************/
+
+void ala_init(smb_ala *list, unsigned int item_size)
+{
+  list->item_size = item_size;
+  list->length = 0;
+  list->allocated = SMB_ALA_BLOCK_SIZE;
+  list->data = NULL;
+  ala_resize(list);
+}
+
+smb_ala *ala_create(unsigned int item_size)
+{
+  smb_ala *list = smb_new(smb_ala, 1);
+  ala_init(list, item_size);
+  return list;
+}
+
+void ala_destroy(smb_ala *list)
+{
+  smb_free(list->data);
+}
+
+void ala_delete(smb_ala *list)
+{
+  ala_destroy(list);
+  smb_free(list);
+}
+
+void ala_reserve(smb_ala *list, int n)
+{
+  if (n > list->allocated) {
+    list->allocated = n;
+    ala_resize(list);
+  }
+}
+
+void ala_shrink_to_fit(smb_ala *list)
+{
+  // Keep room for one item, like al_shrink_to_fit().
+  int allocated = list->length > 0 ? list->length : 1;
+  if (allocated < list->allocated) {
+    list->allocated = allocated;
+    ala_resize(list);
+  }
+}
+
+void *ala_append(smb_ala *list, const void *item)
+{
+  if (list->length >= list->allocated) {
+    item = ala_grow(list, list->length + 1, item);
+  }
+  return ala_fill(list, list->length++, item);
+}
+
+void ala_extend(smb_ala *list, const void *items, int n)
+{
+  if (n <= 0) {
+    return;
+  }
+  if (list->length + n > list->allocated) {
+    items = ala_grow(list, list->length + n, items);
+  }
+  memcpy(ALA_ITEM(list, list->length), items, (size_t) n * list->item_size);
+  list->length += n;
+}
+
+void *ala_insert(smb_ala *list, int index, const void *item)
+{
+  if (index < 0) {
+    index = 0;
+  } else if (index > list->length) {
+    index = list->length;
+  }
+  if (list->length >= list->allocated) {
+    item = ala_grow(list, list->length + 1, item);
+  }
+  // An item in the list from the index on is about to move up one.
+  if (ala_owns(list, item) && (const char *) item >=
+      (char *) ALA_ITEM(list, index)) {
+    item = (const char *) item + list->item_size;
+  }
+
+  memmove(ALA_ITEM(list, index + 1), ALA_ITEM(list, index),
+          (size_t) (list->length - index) * list->item_size);
+  list->length++;
+  return ala_fill(list, index, item);
+}
+
+void *ala_get(const smb_ala *list, int index, smb_status *status)
+{
+  *status = SMB_SUCCESS;
+  if (index < 0 || index >= list->length) {
+    *status = SMB_INDEX_ERROR;
+    return NULL;
+  }
+  return ALA_ITEM(list, index);
+}
+
+void ala_remove(smb_ala *list, int index, smb_status *status)
+{
+  *status = SMB_SUCCESS;
+  if (index < 0 || index >= list->length) {
+    *status = SMB_INDEX_ERROR;
+    return;
+  }
+
+  memmove(ALA_ITEM(list, index), ALA_ITEM(list, index + 1),
+          (size_t) (list->length - index - 1) * list->item_size);
+  list->length--;
+}
+
+void ala_pop_back(smb_ala *list, void *item, smb_status *status)
+{
+  *status = SMB_SUCCESS;
+  if (list->length <= 0) {
+    *status = SMB_INDEX_ERROR;
+    return;
+  }
+
+  list->length--;
+  if (item) {
+    memcpy(item, ALA_ITEM(list, list->length), list->item_size);
+  }
+}
+
+void ala_sort(smb_ala *list, int (*compare)(const void *, const void *))
+{
+  if (list->length > 1 && list->item_size > 0) {
+    qsort(list->data, list->length, list->item_size, compare);
+  }
+}
+
+int ala_length(const smb_ala *list)
+{
+  return list->length;
+}
+
+/*******************************************************************************
+
+                                   Iterator
+
+*******************************************************************************/
+
+/**
+   @brief Return a pointer to the next item of the iterator's list.
+   @param iter The iterator being used.
+   @param[out] status Status variable.
+   @return The next item, as a pointer.
+   @exception SMB_STOP_ITERATION If there are no more items.
+ */
+DATA ala_iter_next(smb_iter *iter, smb_status *status)
+{
+  void *item = ala_get((const smb_ala *)iter->ds, iter->index++, status);
+  if (*status == SMB_INDEX_ERROR) {
+    *status = SMB_STOP_ITERATION;
+  }
+  return PTR(item);
+}
+
+/**
+   @brief Return whether or not the iterator has another item.
+   @param iter The iterator being used.
+   @return Whether or not the iterator has another item.
+ */
+bool ala_iter_has_next(smb_iter *iter)
+{
+  return iter->index < ala_length((const smb_ala *)iter->ds);
+}
+
+/**
+   @brief Free whatever resources are held by the iterator.
+   @param iter The iterator to clean up.
+ */
+void ala_iter_destroy(smb_iter *iter)
+{
+  (void)iter; // unused
+}
+
+/**
+   @brief Free the iterator and its resources.
+   @param iter The iterator to free.
+ */
+void ala_iter_delete(smb_iter *iter)
+{
+  iter->destroy(iter);
+  smb_free(iter);
+}
+
+smb_iter ala_get_iter(const smb_ala *list)
+{
+  smb_iter iter = {
+    // Data values
+    .ds = list,
+    .state = (DATA) { .data_ptr = NULL },
+    .index = 0,
+
+    // Functions
+    .next = &ala_iter_next,
+    .has_next = &ala_iter_has_next,
+    .destroy = &ala_iter_destroy,
+    .delete = &ala_iter_delete
+  };
+  return iter;
+}
@@ -13,13 +13,14 @@
 
 *******************************************************************************/
 
-#include <stdlib.h>      /* memcpy    */
+#include <stdlib.h>
+#include <string.h>      /* memcpy    */
 
 #include "libstephen/al.h"
 
 /**
-   @brief The default size that an array list is allocated with, and is added to
-   the capacity each time it expands.
+   @brief The default size that an array list is allocated with.  Each time it
+   expands, its capacity doubles, so appending n items copies fewer than 2n.
 */
 #define SMB_AL_BLOCK_SIZE 20
 
@@ -30,20 +31,36 @@
 *******************************************************************************/
 
 /**
-   @brief Expands the smb_al by adding anothur chunk of the default size.
+   @brief Expands the smb_al to hold at least n items, at least doubling its
+   capacity.
 
    Note that this is a *private* function, not defined in libstephen.h for a
    reason.
 
    @param list The list to expand.
-   @param[out] status Status variable.
+   @param n The number of items it must hold.
  */
-void al_expand(smb_al *list)
+static void al_grow(smb_al *list, int n)
 {
-  list->allocated = list->allocated + SMB_AL_BLOCK_SIZE;
+  int allocated = list->allocated < SMB_AL_BLOCK_SIZE ? SMB_AL_BLOCK_SIZE :
+    2 * list->allocated;
+  list->allocated = allocated < n ? n : allocated;
   list->data = smb_renew(DATA, list->data, list->allocated);
 }
 
+/**
+   @brief Expands the smb_al by doubling its capacity.
+
+   Note that this is a *private* function, not defined in libstephen.h for a
+   reason.
+
+   @param list The list to expand.
+ */
+void al_expand(smb_al *list)
+{
+  al_grow(list, list->allocated + 1);
+}
+
 /**
    @brief Shifts the elements in the array up one element starting from
    from_index.
@@ -137,6 +154,43 @@ void al_append(smb_al *list, DATA newData)
   }
 }
 
+void al_extend(smb_al *list, const DATA *data, int n)
+{
+  if (n <= 0) {
+    return;
+  }
+  if (list->length + n > list->allocated) {
+    // The items may be in the list, so find them again after growing.
+    if (data >= list->data && data < list->data + list->length) {
+      int offset = data - list->data;
+      al_grow(list, list->length + n);
+      data = list->data + offset;
+    } else {
+      al_grow(list, list->length + n);
+    }
+  }
+  memcpy(list->data + list->length, data, n * sizeof(DATA));
+  list->length += n;
+}
+
+void al_reserve(smb_al *list, int n)
+{
+  if (n > list->allocated) {
+    list->allocated = n;
+    list->data = smb_renew(DATA, list->data, list->allocated);
+  }
+}
+
+void al_shrink_to_fit(smb_al *list)
+{
+  // Keep room for one item, since realloc() may return NULL for zero bytes.
+  int allocated = list->length > 0 ? list->length : 1;
+  if (allocated < list->allocated) {
+    list->allocated = allocated;
+    list->data = smb_renew(DATA, list->data, list->allocated);
+  }
+}
+
 void al_prepend(smb_al *list, DATA newData)
 {
   al_shift_up(list, 0);
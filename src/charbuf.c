@@ -82,6 +82,14 @@ void cb_concat(cbuf *obj, char *buf)
   obj->length += length;
 }
 
+void cb_nconcat(cbuf *obj, const char *str, int n)
+{
+  cb_expand_to_fit(obj, obj->length + n + 1);
+  memcpy(obj->buf + obj->length, str, n);
+  obj->length += n;
+  obj->buf[obj->length] = '\0';
+}
+
 void cb_append(cbuf *obj, char next)
 {
   cb_expand_to_fit(obj, obj->length + 2); // include new character + nul
@@ -191,6 +199,14 @@ void wcb_concat(wcbuf *obj, wchar_t *str)
   obj->length += length;
 }
 
+void wcb_nconcat(wcbuf *obj, const wchar_t *str, int n)
+{
+  wcb_expand_to_fit(obj, obj->length + n + 1);
+  wmemcpy(obj->buf + obj->length, str, n);
+  obj->length += n;
+  obj->buf[obj->length] = L'\0';
+}
+
 void wcb_append(wcbuf *obj, wchar_t next)
 {
   wcb_expand_to_fit(obj, obj->length + 2); // include new character + nul
@@ -0,0 +1,139 @@
+/***************************************************************************//**
+
+  @file         chta.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Implementation of "libstephen/chta.h".
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  Lock striping, rather than lock-free reads: a reader that doesn't lock would
+  need the table to keep every array it might still be probing alive until it
+  finished (hazard pointers, or epochs), and equal() would see half-written
+  keys.  Neither fits tables that store arbitrary blocks of memory.  With
+  reader-writer locks, readers of a stripe never wait on each other, and with
+  enough stripes, writers rarely wait at all.
+
+*******************************************************************************/
+
+#include <string.h>
+
+#include "libstephen/chta.h"
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief Return the stripe a hash belongs to.
+
+   smb_hta scrambles the same hash to pick slots and control bytes, so it's
+   scrambled differently here (with MurmurHash3's finalizer), or every key in a
+   stripe would share some of those bits.
+ */
+static smb_chta_stripe *stripe(smb_chta *table, void *key)
+{
+  unsigned int hash = table->stripes[0].table.hash(key);
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return &table->stripes[hash & (CHTA_STRIPES - 1)];
+}
+
+/*******************************************************************************
+
+                           Public Interface Functions
+
+*******************************************************************************/
+
+void chta_init(smb_chta *table, HTA_HASH hash_func, HTA_COMP equal,
+               unsigned int key_size, unsigned int value_size)
+{
+  unsigned int i;
+  for (i = 0; i < CHTA_STRIPES; i++) {
+    pthread_rwlock_init(&table->stripes[i].lock, NULL);
+    hta_init_policy(&table->stripes[i].table, hash_func, equal, key_size,
+                    value_size, HT_GROUP);
+    hta_set_incremental(&table->stripes[i].table, true);
+  }
+}
+
+smb_chta *chta_create(HTA_HASH hash_func, HTA_COMP equal,
+                      unsigned int key_size, unsigned int value_size)
+{
+  smb_chta *table = smb_new(smb_chta, 1);
+  chta_init(table, hash_func, equal, key_size, value_size);
+  return table;
+}
+
+void chta_destroy(smb_chta *table)
+{
+  unsigned int i;
+  for (i = 0; i < CHTA_STRIPES; i++) {
+    hta_destroy(&table->stripes[i].table);
+    pthread_rwlock_destroy(&table->stripes[i].lock);
+  }
+}
+
+void chta_delete(smb_chta *table)
+{
+  if (!table) {
+    return;
+  }
+
+  chta_destroy(table);
+  smb_free(table);
+}
+
+void chta_insert(smb_chta *table, void *key, void *value)
+{
+  smb_chta_stripe *s = stripe(table, key);
+  pthread_rwlock_wrlock(&s->lock);
+  hta_insert(&s->table, key, value);
+  pthread_rwlock_unlock(&s->lock);
+}
+
+void chta_remove(smb_chta *table, void *key, smb_status *status)
+{
+  smb_chta_stripe *s = stripe(table, key);
+  pthread_rwlock_wrlock(&s->lock);
+  hta_remove(&s->table, key, status);
+  pthread_rwlock_unlock(&s->lock);
+}
+
+void chta_get(smb_chta *table, void *key, void *value, smb_status *status)
+{
+  smb_chta_stripe *s = stripe(table, key);
+  pthread_rwlock_rdlock(&s->lock);
+  void *found = hta_get(&s->table, key, status);
+  if (found && value) {
+    memcpy(value, found, s->table.value_size);
+  }
+  pthread_rwlock_unlock(&s->lock);
+}
+
+bool chta_contains(smb_chta *table, void *key)
+{
+  smb_status status = SMB_SUCCESS;
+  chta_get(table, key, NULL, &status);
+  return status == SMB_SUCCESS;
+}
+
+unsigned int chta_length(smb_chta *table)
+{
+  unsigned int i, length = 0;
+  for (i = 0; i < CHTA_STRIPES; i++) {
+    pthread_rwlock_rdlock(&table->stripes[i].lock);
+    length += table->stripes[i].table.length;
+    pthread_rwlock_unlock(&table->stripes[i].lock);
+  }
+  return length;
+}
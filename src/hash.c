@@ -0,0 +1,234 @@
+/***************************************************************************//**
+
+  @file         hash.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Implementation of "libstephen/hash.h".
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  hash_bytes() follows Wang Yi's wyhash (final version 4), which is in the
+  public domain, and hash_int() is the finalizer of Sebastiano Vigna's
+  SplitMix64.  Multi-byte reads are done with memcpy(), which compilers turn
+  into single unaligned loads.  They're little endian on the machines we care
+  about, so hashes differ on big endian ones, but are just as good.
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libstephen/hash.h"
+#include "libstephen/hta.h"
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+static const uint64_t secret[4] = {
+  0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+  0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull,
+};
+
+static uint64_t hash_seed = 0;
+
+/**
+   @brief Multiply two 64 bit numbers, leaving the low half of the product in a
+   and the high half in b.
+ */
+static void mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+  __uint128_t r = (__uint128_t) *a * *b;
+  *a = (uint64_t) r;
+  *b = (uint64_t) (r >> 64);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), lo = t + (rm1 << 32);
+  uint64_t c = (t < rl) + (lo < t);
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/**
+   @brief Multiply two numbers, and fold the halves of the product together.
+ */
+static uint64_t mix(uint64_t a, uint64_t b)
+{
+  mum(&a, &b);
+  return a ^ b;
+}
+
+static uint64_t read8(const uint8_t *p)
+{
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint64_t read4(const uint8_t *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/**
+   @brief Read 1 to 3 bytes (the first, middle and last) into a number.
+ */
+static uint64_t read3(const uint8_t *p, size_t len)
+{
+  return ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) | p[len - 1];
+}
+
+/**
+   @brief Fold a 64 bit hash down to the size tables use.
+ */
+static unsigned int fold(uint64_t hash)
+{
+  return (unsigned int) (hash ^ (hash >> 32));
+}
+
+/*******************************************************************************
+
+                           Public Interface Functions
+
+*******************************************************************************/
+
+uint64_t hash_bytes(const void *data, size_t len, uint64_t seed)
+{
+  const uint8_t *p = data;
+  uint64_t a, b;
+
+  seed ^= mix(seed ^ secret[0], secret[1]);
+  if (len <= 16) {
+    if (len >= 4) {
+      // Two overlapping pairs of 4 byte reads cover anything from 4 to 16.
+      size_t mid = (len >> 3) << 2;
+      a = (read4(p) << 32) | read4(p + mid);
+      b = (read4(p + len - 4) << 32) | read4(p + len - 4 - mid);
+    } else if (len > 0) {
+      a = read3(p, len);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      // Three independent lanes, so the multiplies can overlap.
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+        see1 = mix(read8(p + 16) ^ secret[2], read8(p + 24) ^ see1);
+        see2 = mix(read8(p + 32) ^ secret[3], read8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    // The last 16 bytes, which may overlap ones already hashed.
+    a = read8(p + i - 16);
+    b = read8(p + i - 8);
+  }
+
+  a ^= secret[1];
+  b ^= seed;
+  mum(&a, &b);
+  return mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+uint64_t hash_string(const char *str, uint64_t seed)
+{
+  return hash_bytes(str ? str : "", str ? strlen(str) : 0, seed);
+}
+
+uint64_t hash_int(uint64_t x, uint64_t seed)
+{
+  x ^= seed;
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+void hash_set_seed(uint64_t seed)
+{
+  hash_seed = seed;
+}
+
+uint64_t hash_get_seed(void)
+{
+  return hash_seed;
+}
+
+void hash_random_seed(void)
+{
+  uint64_t seed = 0;
+  FILE *f = fopen("/dev/urandom", "rb");
+  if (!f || fread(&seed, sizeof(seed), 1, f) != 1) {
+    seed = hash_int((uint64_t) time(NULL), (uint64_t) getpid());
+  }
+  if (f) {
+    fclose(f);
+  }
+  hash_set_seed(seed);
+}
+
+unsigned int ht_fast_string_hash(DATA data)
+{
+  return fold(hash_string(data.data_ptr, hash_seed));
+}
+
+unsigned int ht_int_hash(DATA data)
+{
+  return fold(hash_int((uint64_t) data.data_llint, hash_seed));
+}
+
+/*
+  Keys in an smb_hta are stored unaligned, so they are copied out rather than
+  read through a cast pointer.
+ */
+unsigned int hta_fast_string_hash(void *data)
+{
+  char *key;
+  memcpy(&key, data, sizeof(key));
+  return fold(hash_string(key, hash_seed));
+}
+
+unsigned int hta_int_hash(void *data)
+{
+  int key;
+  memcpy(&key, data, sizeof(key));
+  return fold(hash_int((uint64_t) (int64_t) key, hash_seed));
+}
+
+unsigned int hta_llint_hash(void *data)
+{
+  long long key;
+  memcpy(&key, data, sizeof(key));
+  return fold(hash_int((uint64_t) key, hash_seed));
+}
+
+unsigned int hta_bytes_hash(void *data)
+{
+  smb_hta_bytes *key = data;
+  return fold(hash_bytes(key->data, key->length, hash_seed));
+}
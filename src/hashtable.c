@@ -13,6 +13,7 @@
 
 *******************************************************************************/
 
+#include <limits.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -82,14 +83,103 @@ int ht_next_size(int current)
   return ht_primes[curridx + 1];
 }
 
+unsigned int ht_initial_size(smb_ht_policy policy)
+{
+  return policy == HT_PRIME ? HASH_TABLE_INITIAL_SIZE : HASH_TABLE_INITIAL_POW2;
+}
+
+unsigned int ht_grow_size(unsigned int current, smb_ht_policy policy)
+{
+  return policy == HT_PRIME ? (unsigned int) ht_next_size(current) : current * 2;
+}
+
+/**
+   @brief Return the size to rehash a table to, once its used slots (keys and
+   grave stones) pass the maximum load factor.
+
+   If fewer than half of those slots are keys, clearing out the graves makes
+   enough room, so the size stays the same.  Otherwise the table grows.
+ */
+unsigned int ht_rehash_size(unsigned int allocated, unsigned int length,
+                            smb_ht_policy policy, double max_load)
+{
+  if (length >= allocated * max_load / 2) {
+    return ht_grow_size(allocated, policy);
+  }
+  return allocated;
+}
+
+/**
+   @brief Return the size to shrink a table to after a removal.
+
+   Tables shrink once they are less than a quarter of the way to their maximum
+   load, so that a table which just grew or shrank must change by a lot before
+   it is resized again.  They never shrink below the initial size.
+   @returns The smaller size, or allocated to leave the table alone.
+ */
+unsigned int ht_shrink_size(unsigned int allocated, unsigned int length,
+                            smb_ht_policy policy, double max_load)
+{
+  if (allocated <= ht_initial_size(policy) ||
+      length >= allocated * max_load / 4) {
+    return allocated;
+  }
+  if (policy == HT_PRIME) {
+    return ht_primes[binary_search(ht_primes, nelem(ht_primes), allocated) - 1];
+  }
+  return allocated / 2;
+}
+
+/**
+   @brief Return the size a table needs to hold n keys without rehashing.
+   @returns The larger size, or allocated if it's already big enough.
+ */
+unsigned int ht_reserve_size(unsigned int allocated, unsigned int n,
+                             smb_ht_policy policy, double max_load)
+{
+  while (n > allocated * max_load) {
+    allocated = ht_grow_size(allocated, policy);
+  }
+  return allocated;
+}
+
+/**
+   @brief Return whether a table of a policy could have this many slots.
+
+   HT_PRIME tables are always one of the primes above, and the others are
+   always powers of two, which their probe sequences rely on.
+ */
+bool ht_valid_size(unsigned int allocated, smb_ht_policy policy)
+{
+  if (policy == HT_PRIME) {
+    int idx = binary_search(ht_primes, nelem(ht_primes), allocated);
+    return idx < (int) nelem(ht_primes) && ht_primes[idx] == allocated;
+  }
+  return allocated != 0 && (allocated & (allocated - 1)) == 0;
+}
+
+/**
+   @brief Return whether a slot holds a key.
+
+   The stored hashes are compared first, so equal() is only called on a key
+   that probably matches.
+ */
+static bool ht_slot_holds(const smb_ht *obj, unsigned int index, DATA key,
+                          unsigned int hash)
+{
+  const smb_ht_bckt *b = &obj->table[index];
+  return b->mark == HT_FULL && b->hash == hash && obj->equal(key, b->key) == 0;
+}
+
 /**
    @brief Find the proper index for insertion into the table.
    @param obj Hash table object.
    @param key Key we're inserting.
+   @param hash The key's hash.
  */
-unsigned int ht_find_insert(const smb_ht *obj, DATA key)
+unsigned int ht_find_insert(const smb_ht *obj, DATA key, unsigned int hash)
 {
-  unsigned int index = obj->hash(key) % obj->allocated;
+  unsigned int index = ht_home(hash, obj->allocated, obj->policy);
   unsigned int j = 1;
 
   // Continue searching until we either find a non-full slot, or we find the key
@@ -97,12 +187,9 @@ unsigned int ht_find_insert(const smb_ht *obj, DATA key)
   // until (cell.mark != full || cell.key == key)
   // while (cell.mark == full && cell.key != key)
   while (obj->table[index].mark == HT_FULL &&
-         obj->equal(key, obj->table[index].key) != 0) {
-    // This is quadratic probing, but I'm avoiding squaring numbers:
-    // j:     1, 3, 5, 7,  9, 11, ..
-    // index: 0, 1, 4, 9, 16, 25, 36
-    index = (index + j) % obj->allocated;
-    j += 2;
+         !ht_slot_holds(obj, index, key, hash)) {
+    // This is quadratic probing, see ht_probe().
+    index = ht_probe(index, j++, obj->allocated, obj->policy);
   }
 
   return index;
@@ -110,69 +197,196 @@ unsigned int ht_find_insert(const smb_ht *obj, DATA key)
 
 /**
    @brief Find the proper index for retrieval from the table.
+
+   If the key isn't found, this is where it should be inserted: the first grave
+   stone passed on the way, or else the empty slot that ended the search.  So,
+   inserting only needs to probe once.
    @param obj Hash table object.
    @param key Key we're looking up.
+   @param hash The key's hash.
  */
-unsigned int ht_find_retrieve(const smb_ht *obj, DATA key)
+unsigned int ht_find_retrieve(const smb_ht *obj, DATA key, unsigned int hash)
 {
-  unsigned int index = obj->hash(key) % obj->allocated;
-  unsigned int j = 1;
+  unsigned int index = ht_home(hash, obj->allocated, obj->policy);
+  unsigned int j = 1, grave = 0;
+  bool found_grave = false;
 
   // Continue searching until we either find an empty slot, or we find the key
   // we're trying to insert.
   // until (cell.mark == empty || cell.key == key)
   // while (cell.mark != empty && cell.key != key)
   while (obj->table[index].mark != HT_EMPTY &&
-         obj->equal(key, obj->table[index].key) != 0) {
-    // This is quadratic probing, but I'm avoiding squaring numbers:
-    // j:     1, 3, 5, 7,  9, 11, ..
-    // index: 0, 1, 4, 9, 16, 25, 36
-    index = (index + j) % obj->allocated;
-    j += 2;
+         !ht_slot_holds(obj, index, key, hash)) {
+    if (obj->table[index].mark == HT_GRAVE && !found_grave) {
+      grave = index;
+      found_grave = true;
+    }
+    // This is quadratic probing, see ht_probe().
+    index = ht_probe(index, j++, obj->allocated, obj->policy);
+  }
+  HT_COUNT(obj, probes, j);
+
+  if (found_grave && obj->table[index].mark == HT_EMPTY) {
+    return grave;
   }
   return index;
 }
 
 /**
-   @brief Expand the hash table, adding increment to the capacity of the table.
+   @brief Find the table and slot holding a key.
+
+   During an incremental rehash, keys that haven't been moved yet are still in
+   the old table.
+   @param table Hash table object.
+   @param key Key we're looking up.
+   @param hash The key's hash.
+   @param[out] index Where to put the slot the key is in.
+   @returns The table holding the key (table or table->old), or NULL.
+ */
+static smb_ht *ht_lookup(const smb_ht *table, DATA key, unsigned int hash,
+                         unsigned int *index)
+{
+  HT_COUNT(table, lookups, 1);
+  *index = ht_find_retrieve(table, key, hash);
+  if (table->table[*index].mark == HT_FULL) {
+    HT_COUNT(table, hits, 1);
+    return (smb_ht *) table;
+  }
+  if (table->old) {
+    *index = ht_find_retrieve(table->old, key, hash);
+    if (table->old->table[*index].mark == HT_FULL) {
+      HT_COUNT(table, hits, 1);
+      return table->old;
+    }
+  }
+  return NULL;
+}
+
+/**
+   @brief Fill a free slot, without counting the key.
+ */
+static void ht_fill(smb_ht *table, unsigned int index, DATA key, DATA value,
+                    unsigned int hash)
+{
+  if (table->table[index].mark == HT_GRAVE) {
+    table->graves--;
+  }
+  table->table[index].key = key;
+  table->table[index].value = value;
+  table->table[index].hash = hash;
+  table->table[index].mark = HT_FULL;
+}
 
-   @param table The table to expand.
+/**
+   @brief Put a key which isn't in the table into it, without counting it.
  */
-void ht_resize(smb_ht *table)
+static void ht_place(smb_ht *table, DATA key, DATA value, unsigned int hash)
 {
-  smb_ht_bckt *old_table;
-  unsigned int index, old_allocated;
+  ht_fill(table, ht_find_insert(table, key, hash), key, value, hash);
+}
 
-  // Step one: allocate new space for the table
-  old_table = table->table;
-  old_allocated = table->allocated;
-  table->length = 0;
-  table->allocated = ht_next_size(old_allocated);
-  table->table = smb_new(smb_ht_bckt, table->allocated);
+/**
+   @brief Move up to the given number of slots out of the old table, and free
+   it once they're all moved.
+
+   Moved slots become grave stones, so that neither lookups in the old table
+   nor its own probe sequences are thrown off.
+ */
+static void ht_migrate(smb_ht *table, unsigned int slots)
+{
+  smb_ht *old = table->old;
+  unsigned int end = old->allocated - table->migrated <= slots ?
+    old->allocated : table->migrated + slots;
+
+  for (; table->migrated < end; table->migrated++) {
+    smb_ht_bckt *b = &old->table[table->migrated];
+    if (b->mark == HT_FULL) {
+      ht_place(table, b->key, b->value, b->hash);
+      b->mark = HT_GRAVE;
+      old->length--;
+    }
+  }
 
-  // Zero out the new block too.
+  if (table->migrated == old->allocated) {
+    table->probes += old->probes;
+    smb_free(old->table);
+    smb_free(old);
+    table->old = NULL;
+  }
+}
+
+/**
+   @brief Move every key into a new table of the given size, which also clears
+   out any grave stones.
+
+   The current table becomes the old one.  Unless the table is incremental, the
+   keys are all moved right away.
+   @param table The table to rehash.
+   @param allocated The new number of slots.
+ */
+void ht_rehash(smb_ht *table, unsigned int allocated)
+{
+  // Step one: finish the last rehash, and set this table aside as the old one.
+  if (table->old) {
+    ht_migrate(table, UINT_MAX);
+  }
+  table->old = smb_new(smb_ht, 1);
+  *table->old = *table;
+  table->old->old = NULL;
+  table->old->probes = 0;
+  table->migrated = 0;
+  table->resizes++;
+
+  // Step two: allocate new space for the table, zeroed out.
+  table->graves = 0;
+  table->allocated = allocated;
+  table->table = smb_new(smb_ht_bckt, table->allocated);
   memset((void*)table->table, 0, table->allocated * sizeof(smb_ht_bckt));
 
-  // Step two, add the old items to the new table.
-  for (index = 0; index < old_allocated; index++) {
-    if (old_table[index].mark == HT_FULL) {
-      ht_insert(table, old_table[index].key, old_table[index].value);
-    }
+  // Step three: move the items over, now or later.
+  if (!table->incremental) {
+    ht_migrate(table, UINT_MAX);
+  }
+}
+
+/**
+   @brief Return how many slots a lookup of a full slot's key probes.
+ */
+static unsigned int ht_probe_length(const smb_ht *table, unsigned int index)
+{
+  unsigned int slot = ht_home(table->table[index].hash, table->allocated,
+                              table->policy);
+  unsigned int n = 1;
+  while (slot != index && n <= table->allocated) {
+    slot = ht_probe(slot, n++, table->allocated, table->policy);
   }
+  return n;
+}
 
-  // Step three: free old data.
-  smb_free(old_table);
+/**
+   @brief Add the probe lengths and memory of one table to stats.
+ */
+static void ht_stats_add(const smb_ht *table, smb_ht_stats *stats)
+{
+  unsigned int i;
+  for (i = 0; i < table->allocated; i++) {
+    if (table->table[i].mark == HT_FULL) {
+      ht_stats_probe(stats, ht_probe_length(table, i));
+    }
+  }
+  stats->bytes += sizeof(smb_ht) + table->allocated * sizeof(smb_ht_bckt);
 }
 
 /**
-   @brief Return the load factor of a hash table.
+   @brief Return the load factor of a hash table, counting grave stones, since
+   probes have to step over them too.
 
    @param table The table to find the load factor of.
    @returns The load factor of the hash table.
  */
 double ht_load_factor(smb_ht *table)
 {
-  return ((double) table->length) / ((double) table->allocated);
+  return ((double) table->length + table->graves) / ((double) table->allocated);
 }
 
 /*******************************************************************************
@@ -182,18 +396,39 @@ double ht_load_factor(smb_ht *table)
 *******************************************************************************/
 
 void ht_init(smb_ht *table, HASH_FUNCTION hash_func, DATA_COMPARE equal)
+{
+  ht_init_policy(table, hash_func, equal, HT_PRIME);
+}
+
+void ht_init_policy(smb_ht *table, HASH_FUNCTION hash_func, DATA_COMPARE equal,
+                    smb_ht_policy policy)
 {
   // Initialize values
   table->length = 0;
-  table->allocated = HASH_TABLE_INITIAL_SIZE;
+  table->graves = 0;
+  table->allocated = ht_initial_size(policy);
+  table->policy = policy;
   table->hash = hash_func;
   table->equal = equal;
+  table->old = NULL;
+  table->migrated = 0;
+  table->incremental = false;
+  table->resizes = 0;
+  table->lookups = table->hits = table->probes = 0;
 
   // Create the bucket list
-  table->table = smb_new(smb_ht_bckt, HASH_TABLE_INITIAL_SIZE);
+  table->table = smb_new(smb_ht_bckt, table->allocated);
 
   // Zero out the entries in the table so we don't get segmentation faults.
-  memset((void*)table->table, 0, HASH_TABLE_INITIAL_SIZE * sizeof(smb_ht_bckt));
+  memset((void*)table->table, 0, table->allocated * sizeof(smb_ht_bckt));
+}
+
+void ht_set_incremental(smb_ht *table, bool incremental)
+{
+  table->incremental = incremental;
+  if (!incremental && table->old) {
+    ht_migrate(table, UINT_MAX);
+  }
 }
 
 smb_ht *ht_create(HASH_FUNCTION hash_func, DATA_COMPARE equal)
@@ -218,8 +453,12 @@ void ht_destroy_act(smb_ht *table, DATA_ACTION deleter)
     }
   }
 
-  // Delete the table.
+  // Delete the table, and the one it's rehashing from.
   smb_free(table->table);
+  if (table->old) {
+    ht_destroy_act(table->old, deleter);
+    smb_free(table->old);
+  }
 }
 
 void ht_destroy(smb_ht *table)
@@ -242,49 +481,106 @@ void ht_delete(smb_ht *table)
   ht_delete_act(table, NULL);
 }
 
-void ht_insert(smb_ht *table, DATA key, DATA value)
+void ht_reserve(smb_ht *table, unsigned int n)
 {
-  unsigned int index;
+  unsigned int size = ht_reserve_size(table->allocated, n, table->policy,
+                                      HASH_TABLE_MAX_LOAD_FACTOR);
+  // Graves would use up the room too, so clear them if need be.
+  if (size != table->allocated ||
+      n + table->graves > table->allocated * HASH_TABLE_MAX_LOAD_FACTOR) {
+    ht_rehash(table, size);
+  }
+}
+
+/**
+   @brief Return the value of a key whose hash is known, inserting the key if
+   need be.  See ht_upsert().
+ */
+static DATA *ht_upsert_hash(smb_ht *table, DATA key, unsigned int hash,
+                            bool *inserted)
+{
+  unsigned int index, old_index;
+  if (table->old) {
+    ht_migrate(table, HASH_TABLE_MIGRATE_SLOTS);
+  }
   if (ht_load_factor(table) >= HASH_TABLE_MAX_LOAD_FACTOR) {
-    ht_resize(table);
+    ht_rehash(table, ht_rehash_size(table->allocated, table->length,
+                                    table->policy, HASH_TABLE_MAX_LOAD_FACTOR));
+  }
+  if (inserted) {
+    *inserted = false;
   }
 
-  // First, probe for the key as if we're trying to return it.  If we find it,
-  // we update the existing key.
-  index = ht_find_retrieve(table, key);
+  // Probe for the key once.  If we find it, we return its value.
+  HT_COUNT(table, lookups, 1);
+  index = ht_find_retrieve(table, key, hash);
   if (table->table[index].mark == HT_FULL) {
-    table->table[index].value = value;
-    return;
+    HT_COUNT(table, hits, 1);
+    return &table->table[index].value;
+  }
+  if (table->old) {
+    old_index = ht_find_retrieve(table->old, key, hash);
+    if (table->old->table[old_index].mark == HT_FULL) {
+      HT_COUNT(table, hits, 1);
+      return &table->old->table[old_index].value;
+    }
   }
 
-  // If we don't find the key, then we find the first open slot or gravestone.
-  index = ht_find_insert(table, key);
-  table->table[index].key = key;
-  table->table[index].value = value;
-  table->table[index].mark = HT_FULL;
+  // If we don't find the key, the probe stopped at the slot it belongs in.
+  ht_fill(table, index, key, LLINT(0), hash);
   table->length++;
+  if (inserted) {
+    *inserted = true;
+  }
+  return &table->table[index].value;
+}
+
+DATA *ht_upsert(smb_ht *table, DATA key, bool *inserted)
+{
+  return ht_upsert_hash(table, key, table->hash(key), inserted);
+}
+
+void ht_insert(smb_ht *table, DATA key, DATA value)
+{
+  *ht_upsert(table, key, NULL) = value;
 }
 
 void ht_remove_act(smb_ht *table, DATA key, DATA_ACTION deleter,
                    smb_status *status)
 {
   *status = SMB_SUCCESS;
-  unsigned int index = ht_find_retrieve(table, key);
+  unsigned int index;
+  smb_ht *in = ht_lookup(table, key, table->hash(key), &index);
 
-  // If the returned slot isn't full, that means we couldn't find it.
-  if (table->table[index].mark != HT_FULL) {
+  // If we didn't find a full slot, that means we couldn't find it.
+  if (!in) {
     *status = SMB_NOT_FOUND_ERROR;
     return;
   }
 
   // Perform the action if there is one.
   if (deleter) {
-    deleter(table->table[index].value);
+    deleter(in->table[index].value);
   }
 
   // Mark the slot with a "grave stone", indicating it is deleted.
-  table->table[index].mark = HT_GRAVE;
-  table->length--;
+  in->table[index].mark = HT_GRAVE;
+  in->length--;
+  in->graves++;
+  if (in != table) {
+    table->length--;
+  }
+
+  // Don't start shrinking until the last rehash is done.
+  if (table->old) {
+    ht_migrate(table, HASH_TABLE_MIGRATE_SLOTS);
+    return;
+  }
+  unsigned int size = ht_shrink_size(table->allocated, table->length,
+                                     table->policy, HASH_TABLE_MAX_LOAD_FACTOR);
+  if (size != table->allocated) {
+    ht_rehash(table, size);
+  }
 }
 
 void ht_remove(smb_ht *table, DATA key, smb_status *status)
@@ -295,23 +591,39 @@ void ht_remove(smb_ht *table, DATA key, smb_status *status)
 DATA ht_get(smb_ht const *table, DATA key, smb_status *status)
 {
   *status = SMB_SUCCESS;
-  unsigned int index = ht_find_retrieve(table, key);
+  unsigned int index;
+  const smb_ht *in = ht_lookup(table, key, table->hash(key), &index);
 
-  // If the slot is not marked full, we didn't find the key.
-  if (table->table[index].mark != HT_FULL) {
+  // If no slot was marked full, we didn't find the key.
+  if (!in) {
     *status = SMB_NOT_FOUND_ERROR;
     return PTR(NULL);
   }
 
   // Otherwise, return the key.
-  return table->table[index].value;
+  return in->table[index].value;
 }
 
 bool ht_contains(smb_ht const *table, DATA key)
 {
-  smb_status status = SMB_SUCCESS;
-  ht_get(table, key, &status);
-  return status == SMB_SUCCESS;
+  unsigned int index;
+  return ht_lookup(table, key, table->hash(key), &index) != NULL;
+}
+
+/**
+   @brief Return a slot of the table, counting the old table's slots as if they
+   came after the current table's, or NULL past the end.
+ */
+static const smb_ht_bckt *ht_iter_slot(const smb_ht *ht, long long int i)
+{
+  if (i < ht->allocated) {
+    return &ht->table[i];
+  }
+  i -= ht->allocated;
+  if (ht->old && i < ht->old->allocated) {
+    return &ht->old->table[i];
+  }
+  return NULL;
 }
 
 DATA ht_iter_next(smb_iter *iter, smb_status *status)
@@ -319,10 +631,11 @@ DATA ht_iter_next(smb_iter *iter, smb_status *status)
   *status = SMB_SUCCESS;
   long long int i = iter->state.data_llint + 1;
   const smb_ht *ht = iter->ds;
+  const smb_ht_bckt *b;
 
   // Move up until we either run off the table, or find a bucket that contains
   // something.
-  while (i < ht->allocated && ht->table[i].mark != HT_FULL) {
+  while ((b = ht_iter_slot(ht, i)) != NULL && b->mark != HT_FULL) {
     i++;
   }
 
@@ -330,13 +643,13 @@ DATA ht_iter_next(smb_iter *iter, smb_status *status)
   iter->state.data_llint = i;
 
   // If we hit the end of the table, stop iterating.
-  if (i >= ht->allocated) {
+  if (!b) {
     *status = SMB_STOP_ITERATION;
     return LLINT(0);
   } else {
     // Otherwise, return the key we found.
     iter->index++; // count the number of items we've found so far
-    return ht->table[i].key;
+    return b->key;
   }
 }
 
@@ -357,6 +670,93 @@ void ht_iter_delete(smb_iter *iter)
   free(iter);
 }
 
+/**
+   @brief Return the next full slot at or after slot *i, counting the old
+   table's slots as if they came after the table's own, and move *i past it.
+   @returns The slot, or NULL if there are no more.
+ */
+static const smb_ht_bckt *ht_next_slot(const smb_ht *table, unsigned int *i)
+{
+  const smb_ht_bckt *b;
+  while ((b = ht_iter_slot(table, *i)) != NULL && b->mark != HT_FULL) {
+    (*i)++;
+  }
+  (*i)++;
+  return b;
+}
+
+void ht_union(smb_ht *out, smb_ht const *a, smb_ht const *b)
+{
+  const smb_ht *larger = a->length >= b->length ? a : b;
+  const smb_ht *smaller = larger == a ? b : a;
+  const smb_ht_bckt *s;
+  unsigned int i;
+  bool inserted;
+  DATA *value;
+
+  // The stored hashes are reused, so no key is hashed again.
+  ht_init_policy(out, a->hash, a->equal, a->policy);
+  ht_reserve(out, a->length + b->length);
+  for (i = 0; (s = ht_next_slot(larger, &i)) != NULL;) {
+    *ht_upsert_hash(out, s->key, s->hash, NULL) = s->value;
+  }
+  for (i = 0; (s = ht_next_slot(smaller, &i)) != NULL;) {
+    value = ht_upsert_hash(out, s->key, s->hash, &inserted);
+    if (inserted || smaller == a) {
+      *value = s->value;
+    }
+  }
+}
+
+void ht_intersection(smb_ht *out, smb_ht const *a, smb_ht const *b)
+{
+  const smb_ht *larger = a->length >= b->length ? a : b;
+  const smb_ht *smaller = larger == a ? b : a;
+  const smb_ht_bckt *s;
+  const smb_ht *in;
+  unsigned int i, index;
+
+  ht_init_policy(out, a->hash, a->equal, a->policy);
+  ht_reserve(out, smaller->length);
+  for (i = 0; (s = ht_next_slot(smaller, &i)) != NULL;) {
+    in = ht_lookup(larger, s->key, s->hash, &index);
+    if (in) {
+      *ht_upsert_hash(out, s->key, s->hash, NULL) =
+        smaller == a ? s->value : in->table[index].value;
+    }
+  }
+}
+
+void ht_difference(smb_ht *out, smb_ht const *a, smb_ht const *b)
+{
+  const smb_ht_bckt *s;
+  unsigned int i, index;
+
+  ht_init_policy(out, a->hash, a->equal, a->policy);
+  ht_reserve(out, a->length);
+  for (i = 0; (s = ht_next_slot(a, &i)) != NULL;) {
+    if (!ht_lookup(b, s->key, s->hash, &index)) {
+      *ht_upsert_hash(out, s->key, s->hash, NULL) = s->value;
+    }
+  }
+}
+
+bool ht_is_subset(smb_ht const *a, smb_ht const *b)
+{
+  const smb_ht_bckt *s;
+  unsigned int i, index;
+
+  if (a->length > b->length) {
+    return false;
+  }
+  for (i = 0; (s = ht_next_slot(a, &i)) != NULL;) {
+    if (!ht_lookup(b, s->key, s->hash, &index)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 smb_iter ht_get_iter(const smb_ht *ht)
 {
   smb_iter iter = {
@@ -374,6 +774,56 @@ smb_iter ht_get_iter(const smb_ht *ht)
   return iter;
 }
 
+void ht_stats_probe(smb_ht_stats *stats, unsigned int length)
+{
+  unsigned int bucket = length < HT_STATS_PROBES ? length : HT_STATS_PROBES;
+  stats->probe_lengths[bucket - 1]++;
+  if (length > stats->max_probe_length) {
+    stats->max_probe_length = length;
+  }
+}
+
+void ht_stats(smb_ht const *table, smb_ht_stats *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+  stats->length = table->length;
+  stats->allocated = table->allocated;
+  stats->graves = table->graves;
+  stats->resizes = table->resizes;
+  stats->lookups = table->lookups;
+  stats->hits = table->hits;
+  stats->probes = table->probes;
+  ht_stats_add(table, stats);
+  if (table->old) {
+    stats->allocated += table->old->allocated;
+    stats->graves += table->old->graves;
+    stats->probes += table->old->probes;
+    ht_stats_add(table->old, stats);
+  }
+}
+
+void ht_print_stats(FILE *f, smb_ht_stats const *stats)
+{
+  unsigned int i;
+  fprintf(f, "%u keys, %u slots (%.1f%% full), %u graves, %lu resizes, "
+          "%zu bytes\n", stats->length, stats->allocated,
+          100.0 * stats->length / stats->allocated, stats->graves,
+          stats->resizes, stats->bytes);
+  fprintf(f, "probe lengths:");
+  for (i = 0; i < HT_STATS_PROBES; i++) {
+    if (stats->probe_lengths[i]) {
+      fprintf(f, " %u%s:%u", i + 1, i + 1 == HT_STATS_PROBES ? "+" : "",
+              stats->probe_lengths[i]);
+    }
+  }
+  fprintf(f, ", max %u\n", stats->max_probe_length);
+  if (stats->lookups) {
+    fprintf(f, "%lu lookups, %.1f%% hits, %.2f probes per lookup\n",
+            stats->lookups, 100.0 * stats->hits / stats->lookups,
+            (double) stats->probes / stats->lookups);
+  }
+}
+
 unsigned int ht_string_hash(DATA data)
 {
   char *theString = (char *)data.data_ptr;
@@ -400,4 +850,8 @@ void ht_print(smb_ht const *table, int full_mode)
              table->table[i].value.data_llint);
     }
   }
+  if (table->old) {
+    printf("rehashing from %u slots:\n", table->old->allocated);
+    ht_print(table->old, full_mode);
+  }
 }
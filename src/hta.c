@@ -15,14 +15,89 @@
   the observation that using DATA is inflexible compared to simply storing
   blocks of memory.
 
+  Tables with the HT_GROUP policy also keep a control byte per slot in an array
+  of its own, in the style of Abseil's SwissTable.  A full slot's control byte
+  holds 7 bits of its key's hash, and the others are HTA_CTRL_EMPTY or
+  HTA_CTRL_GRAVE, which both have the high bit set.  Probing checks a whole
+  group of 16 control bytes at once (with SSE2 where it's available), and only
+  calls equal() on slots whose hash bits match, so a lookup rarely touches a
+  record that isn't the one it's looking for.  The mark at the start of each
+  record is still kept up to date, so the rest of the code needn't care which
+  layout a table uses.
+
+  Tables made by hta_init_keys() store an smb_hta_key in each record, and
+  compare keys themselves instead of calling equal(), since that needs the
+  arena.  Keys being moved by a rehash are already stored, so they're copied
+  as they are, and the arena is shared with the old table until it's gone.
+
 *******************************************************************************/
 
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
+#include "libstephen/hash.h"
 #include "libstephen/ht.h"
 #include "libstephen/hta.h"
 
+/*
+  Group probing stays short at much higher loads than probing slot by slot, so
+  HT_GROUP tables fill up to 7/8 before growing, like SwissTable.
+ */
+#define HTA_GROUP_MAX_LOAD_FACTOR 0.875
+
+/*
+  Files written by hta_save() start with this header, padded to
+  HTA_FILE_HEADER_SIZE bytes.  The records follow, and then the control bytes,
+  if the table has them.
+ */
+#define HTA_FILE_MAGIC "smbhta1"
+#define HTA_FILE_HEADER_SIZE 64
+#define HTA_FILE_BYTE_ORDER 0x01020304u
+
+/*
+  Hash functions a file can name.  Any other function is trusted to be the one
+  the table was saved with.
+ */
+#define HTA_FILE_HASH_OTHER 0
+#define HTA_FILE_HASH_INT 1
+#define HTA_FILE_HASH_LLINT 2
+
+/*
+  How many keys hta_map() rehashes to check that the hash function matches.
+ */
+#define HTA_FILE_CHECK_KEYS 8
+
+/*
+  How many bytes of a key in the arena are also kept in its slot.
+ */
+#define HTA_KEY_PREFIX (HTA_INLINE_KEY - sizeof(uint64_t))
+
+struct hta_file_header {
+  char magic[8];
+  uint32_t byte_order;
+  uint32_t key_size;
+  uint32_t value_size;
+  uint32_t record_size;
+  uint32_t policy;
+  uint32_t hash_id;
+  uint32_t length;
+  uint32_t allocated;
+  uint32_t graves;
+  uint32_t has_ctrl;
+  uint64_t seed;
+};
+
 /*******************************************************************************
 
                                Private Functions
@@ -39,14 +114,324 @@ unsigned int convert_idx(const smb_hta *obj, unsigned int orig)
   return orig * item_size(obj);
 }
 
+/**
+   @brief Return the hash stored in a record.
+ */
+static unsigned int slot_hash(const smb_hta *obj, unsigned int bufidx)
+{
+  unsigned int hash;
+  memcpy(&hash, obj->table + bufidx + HTA_HASH_OFFSET, sizeof(hash));
+  return hash;
+}
+
+/**
+   @brief Return the length of a key stored by a table made by hta_init_keys().
+ */
+static unsigned int key_length(const void *stored)
+{
+  unsigned int length;
+  memcpy(&length, stored, sizeof(length));
+  return length;
+}
+
+/**
+   @brief Return the bytes of a key stored by a table made by hta_init_keys().
+ */
+static smb_hta_bytes key_bytes(const smb_hta *obj, const void *stored)
+{
+  const char *data = (const char *) stored + offsetof(smb_hta_key, data);
+  smb_hta_bytes bytes;
+  uint64_t offset;
+
+  bytes.length = key_length(stored);
+  bytes.data = data;
+  if (bytes.length > HTA_INLINE_KEY) {
+    memcpy(&offset, data + HTA_KEY_PREFIX, sizeof(offset));
+    bytes.data = obj->arena->data + offset;
+  }
+  return bytes;
+}
+
+/**
+   @brief Return whether a stored key has the same bytes as a key.
+
+   Short keys are compared in the slot, and long ones only go to the arena
+   when their prefix matches.
+ */
+static bool key_equal(const smb_hta *obj, const void *stored,
+                      const smb_hta_bytes *key)
+{
+  const char *data = (const char *) stored + offsetof(smb_hta_key, data);
+  unsigned int length = key_length(stored);
+
+  if (length != key->length) {
+    return false;
+  } else if (length == 0) {
+    return true;
+  } else if (length <= HTA_INLINE_KEY) {
+    return memcmp(data, key->data, length) == 0;
+  }
+  return memcmp(data, key->data, HTA_KEY_PREFIX) == 0 &&
+    memcmp(key_bytes(obj, stored).data, key->data, length) == 0;
+}
+
+/**
+   @brief Store a key for a table made by hta_init_keys(), appending it to the
+   arena if it's too long to go in the slot.
+ */
+static void key_store(smb_hta *obj, smb_hta_key *stored,
+                      const smb_hta_bytes *key)
+{
+  smb_hta_arena *arena = obj->arena;
+  uint64_t offset = arena->length;
+
+  memset(stored, 0, sizeof(*stored));
+  stored->length = key->length;
+  if (key->length == 0) {
+    return;
+  } else if (key->length <= HTA_INLINE_KEY) {
+    memcpy(stored->data, key->data, key->length);
+    return;
+  }
+
+  if (arena->length + key->length > arena->allocated) {
+    arena->allocated = 2 * arena->allocated + key->length;
+    arena->data = smb_renew(char, arena->data, arena->allocated);
+  }
+  memcpy(arena->data + arena->length, key->data, key->length);
+  arena->length += key->length;
+  memcpy(stored->data, key->data, HTA_KEY_PREFIX);
+  memcpy(stored->data + HTA_KEY_PREFIX, &offset, sizeof(offset));
+}
+
+/**
+   @brief Copy the live keys of a table's arena into a new one, once removed
+   keys take up half of it.
+
+   This is only done with no old table, since every stored offset changes.
+ */
+static void arena_compact(smb_hta *obj)
+{
+  smb_hta_arena *arena = obj->arena;
+  size_t length = 0;
+  unsigned int i, bufidx;
+  uint64_t offset;
+  smb_hta_bytes bytes;
+  char *data, *stored;
+
+  if (arena->dead == 0 || arena->dead < arena->length / 2) {
+    return;
+  }
+  data = smb_new(char, arena->length - arena->dead + 1);
+  for (i = 0; i < obj->allocated; i++) {
+    bufidx = convert_idx(obj, i);
+    stored = obj->table + bufidx + HTA_KEY_OFFSET;
+    if (HTA_MARK(obj, bufidx) == HT_FULL &&
+        key_length(stored) > HTA_INLINE_KEY) {
+      bytes = key_bytes(obj, stored);
+      memcpy(data + length, bytes.data, bytes.length);
+      offset = length;
+      memcpy(stored + offsetof(smb_hta_key, data) + HTA_KEY_PREFIX, &offset,
+             sizeof(offset));
+      length += bytes.length;
+    }
+  }
+  smb_free(arena->data);
+  arena->data = data;
+  arena->allocated = arena->length - arena->dead + 1;
+  arena->length = length;
+  arena->dead = 0;
+}
+
+/**
+   @brief Return whether a full slot holds a key.
+
+   The stored hashes are compared first, so equal() is only called on a key
+   that probably matches.
+ */
+static bool slot_holds(const smb_hta *obj, unsigned int bufidx, void *key,
+                       unsigned int hash)
+{
+  if (slot_hash(obj, bufidx) != hash) {
+    return false;
+  } else if (obj->arena) {
+    return key_equal(obj, obj->table + bufidx + HTA_KEY_OFFSET, key);
+  }
+  return obj->equal(key, obj->table + bufidx + HTA_KEY_OFFSET) == 0;
+}
+
+/**
+   @brief Return a bit for each byte in a group that equals a value.
+ */
+static unsigned int group_match(const uint8_t *group, uint8_t value)
+{
+#ifdef __SSE2__
+  __m128i g = _mm_loadu_si128((const __m128i *) group);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char) value)));
+#else
+  unsigned int mask = 0;
+  for (unsigned int i = 0; i < HTA_GROUP_SIZE; i++) {
+    mask |= (unsigned int) (group[i] == value) << i;
+  }
+  return mask;
+#endif
+}
+
+/**
+   @brief Return a bit for each byte in a group that is empty or a grave.
+ */
+static unsigned int group_free(const uint8_t *group)
+{
+#ifdef __SSE2__
+  // The high bit of each byte is exactly what movemask collects.
+  return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) group));
+#else
+  unsigned int mask = 0;
+  for (unsigned int i = 0; i < HTA_GROUP_SIZE; i++) {
+    mask |= (unsigned int) (group[i] >> 7) << i;
+  }
+  return mask;
+#endif
+}
+
+/**
+   @brief Return the index of the lowest set bit of a nonzero mask.
+ */
+static unsigned int lowest(unsigned int mask)
+{
+#ifdef __GNUC__
+  return __builtin_ctz(mask);
+#else
+  unsigned int i = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+/**
+   @brief Scramble a hash, like ht_home() does for power of two tables.
+ */
+static unsigned int group_hash(unsigned int hash)
+{
+  return hash * 2654435769u;
+}
+
+/**
+   @brief Return the 7 bits of a scrambled hash stored in a control byte.
+ */
+static uint8_t group_tag(unsigned int mixed)
+{
+  return mixed >> 25;
+}
+
+/**
+   @brief Return the first group to probe for a scrambled hash.
+ */
+static unsigned int group_home(unsigned int mixed, unsigned int ngroups)
+{
+  return (mixed ^ (mixed >> 15)) & (ngroups - 1);
+}
+
+/**
+   @brief Find a key in a table with control bytes.
+
+   Groups are probed in the same triangular order as power of two tables probe
+   slots, which visits every group.
+   @param obj Hash table object.
+   @param key Key to look for.
+   @param hash The key's hash.
+   @param insert True if the key is known not to be in the table, so the first
+   free slot will do.
+   @returns The key's index, or if it isn't found, the first free slot on the
+   way.
+ */
+static unsigned int group_find(const smb_hta *obj, void *key, unsigned int hash,
+                               bool insert)
+{
+  unsigned int mixed = group_hash(hash);
+  unsigned int ngroups = obj->allocated / HTA_GROUP_SIZE;
+  unsigned int g = group_home(mixed, ngroups);
+  uint8_t tag = group_tag(mixed);
+  unsigned int j, mask, index, grave = 0;
+  bool found_grave = false;
+
+  for (j = 1; j <= ngroups; j++) {
+    const uint8_t *group = obj->ctrl + g * HTA_GROUP_SIZE;
+    if (insert) {
+      mask = group_free(group);
+      if (mask) {
+        return g * HTA_GROUP_SIZE + lowest(mask);
+      }
+    } else {
+      for (mask = group_match(group, tag); mask; mask &= mask - 1) {
+        index = g * HTA_GROUP_SIZE + lowest(mask);
+        if (slot_holds(obj, convert_idx(obj, index), key, hash)) {
+          HT_COUNT(obj, probes, j);
+          return index;
+        }
+      }
+      mask = group_free(group);
+      if (mask && !found_grave) {
+        grave = g * HTA_GROUP_SIZE + lowest(mask);
+        found_grave = true;
+      }
+      // An empty slot means the key would have been placed by now, so it goes
+      // in the first free slot we saw.
+      if (group_match(group, HTA_CTRL_EMPTY)) {
+        HT_COUNT(obj, probes, j);
+        return grave;
+      }
+    }
+    g = (g + j) & (ngroups - 1);
+  }
+
+  // Every group was full of keys and graves.  The table is never full, so
+  // there was a grave, which will do.
+  HT_COUNT(obj, probes, ngroups);
+  return grave;
+}
+
+/**
+   @brief Set the control byte for a slot, if the table has them.
+ */
+static void set_ctrl(smb_hta *obj, unsigned int index, unsigned int hash,
+                     int8_t mark)
+{
+  if (obj->ctrl) {
+    obj->ctrl[index] = mark == HT_FULL ? group_tag(group_hash(hash))
+                                       : HTA_CTRL_GRAVE;
+  }
+}
+
+/**
+   @brief Return whether a slot holds a key.
+
+   With control bytes, this doesn't need to touch the record at all, which
+   matters most when a lookup misses.
+ */
+static bool slot_full(const smb_hta *obj, unsigned int index)
+{
+  if (obj->ctrl) {
+    return !(obj->ctrl[index] & 0x80);
+  }
+  return HTA_MARK(obj, convert_idx(obj, index)) == HT_FULL;
+}
+
 /**
    @brief Find the proper index for insertion into the table.
    @param obj Hash table object.
    @param key Key we're inserting.
+   @param hash The key's hash.
  */
-unsigned int hta_find_insert(const smb_hta *obj, void *key)
+unsigned int hta_find_insert(const smb_hta *obj, void *key, unsigned int hash)
 {
-  unsigned int index = obj->hash(key) % obj->allocated;
+  if (obj->ctrl) {
+    return group_find(obj, key, hash, true);
+  }
+  unsigned int index = ht_home(hash, obj->allocated, obj->policy);
   unsigned int bufidx = convert_idx(obj, index);
   unsigned int j = 1;
 
@@ -55,12 +440,9 @@ unsigned int hta_find_insert(const smb_hta *obj, void *key)
   // until (cell.mark != full || cell.key == key)
   // while (cell.mark == full && cell.key != key)
   while (HTA_MARK(obj, bufidx) == HT_FULL &&
-         obj->equal(key, obj->table + bufidx + HTA_KEY_OFFSET) != 0) {
-    // This is quadratic probing, but I'm avoiding squaring numbers:
-    // j:     1, 3, 5, 7,  9, 11, ..
-    // index: 0, 1, 4, 9, 16, 25, 36
-    index = (index + j) % obj->allocated;
-    j += 2;
+         !slot_holds(obj, bufidx, key, hash)) {
+    // This is quadratic probing, see ht_probe().
+    index = ht_probe(index, j++, obj->allocated, obj->policy);
     bufidx = convert_idx(obj, index);
   }
 
@@ -69,71 +451,314 @@ unsigned int hta_find_insert(const smb_hta *obj, void *key)
 
 /**
    @brief Find the proper index for retrieval from the table.
+
+   Like ht_find_retrieve(), if the key isn't found, this is where it should be
+   inserted.
    @param obj Hash table object.
    @param key Key we're looking up.
+   @param hash The key's hash.
  */
-unsigned int hta_find_retrieve(const smb_hta *obj, void *key)
+unsigned int hta_find_retrieve(const smb_hta *obj, void *key, unsigned int hash)
 {
-  unsigned int index = obj->hash(key) % obj->allocated;
+  if (obj->ctrl) {
+    return group_find(obj, key, hash, false);
+  }
+  unsigned int index = ht_home(hash, obj->allocated, obj->policy);
   unsigned int bufidx = convert_idx(obj, index);
-  unsigned int j = 1;
+  unsigned int j = 1, grave = 0;
+  bool found_grave = false;
 
   // Continue searching until we either find an empty slot, or we find the key
   // we're trying to insert.
   // until (cell.mark == empty || cell.key == key)
   // while (cell.mark != empty && cell.key != key)
   while (HTA_MARK(obj, bufidx) != HT_EMPTY &&
-         obj->equal(key, obj->table + bufidx + HTA_KEY_OFFSET) != 0) {
-    // This is quadratic probing, but I'm avoiding squaring numbers:
-    // j:     1, 3, 5, 7,  9, 11, ..
-    // index: 0, 1, 4, 9, 16, 25, 36
-    index = (index + j) % obj->allocated;
-    j += 2;
+         !(HTA_MARK(obj, bufidx) == HT_FULL &&
+           slot_holds(obj, bufidx, key, hash))) {
+    if (HTA_MARK(obj, bufidx) == HT_GRAVE && !found_grave) {
+      grave = index;
+      found_grave = true;
+    }
+    // This is quadratic probing, see ht_probe().
+    index = ht_probe(index, j++, obj->allocated, obj->policy);
     bufidx = convert_idx(obj, index);
   }
+  HT_COUNT(obj, probes, j);
 
+  if (found_grave && HTA_MARK(obj, bufidx) == HT_EMPTY) {
+    return grave;
+  }
   return index;
 }
 
 /**
-   @brief Expand the hash table, adding increment to the capacity of the table.
+   @brief Find the table and slot holding a key.
+
+   During an incremental rehash, keys that haven't been moved yet are still in
+   the old table.
+   @param table Hash table object.
+   @param key Key we're looking up.
+   @param hash The key's hash.
+   @param[out] index Where to put the slot the key is in.
+   @returns The table holding the key (table or table->old), or NULL.
+ */
+static smb_hta *hta_lookup(const smb_hta *table, void *key, unsigned int hash,
+                           unsigned int *index)
+{
+  HT_COUNT(table, lookups, 1);
+  *index = hta_find_retrieve(table, key, hash);
+  if (slot_full(table, *index)) {
+    HT_COUNT(table, hits, 1);
+    return (smb_hta *) table;
+  }
+  if (table->old) {
+    *index = hta_find_retrieve(table->old, key, hash);
+    if (slot_full(table->old, *index)) {
+      HT_COUNT(table, hits, 1);
+      return table->old;
+    }
+  }
+  return NULL;
+}
+
+/**
+   @brief Fill a free slot with a key, without counting it.
+   @param key The key as it's stored, which for a table made by hta_init_keys()
+   is an smb_hta_key.
+   @returns A pointer to the slot's value.
+ */
+static void *hta_fill(smb_hta *table, unsigned int index, void *key,
+                      unsigned int hash)
+{
+  unsigned int bufidx = convert_idx(table, index);
+  if (HTA_MARK(table, bufidx) == HT_GRAVE) {
+    table->graves--;
+  }
+  HTA_MARK(table, bufidx) = HT_FULL;
+  set_ctrl(table, index, hash, HT_FULL);
+  memcpy(table->table + bufidx + HTA_HASH_OFFSET, &hash, sizeof(hash));
+  memcpy(table->table + bufidx + HTA_KEY_OFFSET, key, table->key_size);
+  return table->table + bufidx + HTA_KEY_OFFSET + table->key_size;
+}
+
+/**
+   @brief Put a stored key which isn't in the table into it, without counting
+   it.
+ */
+static void hta_place(smb_hta *table, void *key, void *value, unsigned int hash)
+{
+  smb_hta_bytes bytes;
+  void *probe = key;
+  if (table->arena) {
+    bytes = key_bytes(table, key);
+    probe = &bytes;
+  }
+  memcpy(hta_fill(table, hta_find_insert(table, probe, hash), key, hash), value,
+         table->value_size);
+}
+
+/**
+   @brief Move up to the given number of slots out of the old table, and free
+   it once they're all moved.
 
-   @param table The table to expand.
+   Moved slots become grave stones, so lookups in the old table skip them.
  */
-void hta_resize(smb_hta *table)
+static void hta_migrate(smb_hta *table, unsigned int slots)
 {
-  void *old_table;
-  unsigned int index, old_allocated, bufidx;
+  smb_hta *old = table->old;
+  unsigned int end = old->allocated - table->migrated <= slots ?
+    old->allocated : table->migrated + slots;
+  unsigned int bufidx;
 
-  // Step one: allocate new space for the table
-  old_table = table->table;
-  old_allocated = table->allocated;
-  table->length = 0;
-  table->allocated = ht_next_size(old_allocated);
+  for (; table->migrated < end; table->migrated++) {
+    bufidx = convert_idx(old, table->migrated);
+    if (HTA_MARK(old, bufidx) == HT_FULL) {
+      void *key = old->table + bufidx + HTA_KEY_OFFSET;
+      hta_place(table, key, key + old->key_size, slot_hash(old, bufidx));
+      HTA_MARK(old, bufidx) = HT_GRAVE;
+      set_ctrl(old, table->migrated, 0, HT_GRAVE);
+      old->length--;
+    }
+  }
+
+  if (table->migrated == old->allocated) {
+    table->probes += old->probes;
+    old->arena = NULL;
+    hta_destroy(old);
+    smb_free(old);
+    table->old = NULL;
+    if (table->arena) {
+      arena_compact(table);
+    }
+  }
+}
+
+/**
+   @brief Move every key into a new table of the given size, which also clears
+   out any grave stones.
+
+   The current table becomes the old one.  Unless the table is incremental, the
+   keys are all moved right away.
+   @param table The table to rehash.
+   @param allocated The new number of slots.
+ */
+void hta_rehash(smb_hta *table, unsigned int allocated)
+{
+  // Step one: finish the last rehash, and set this table aside as the old one.
+  if (table->old) {
+    hta_migrate(table, UINT_MAX);
+  }
+  table->old = smb_new(smb_hta, 1);
+  *table->old = *table;
+  table->old->old = NULL;
+  table->old->probes = 0;
+  table->migrated = 0;
+  table->map = NULL;
+  table->resizes++;
+
+  // Step two: allocate new space for the table.
+  table->graves = 0;
+  table->allocated = allocated;
   table->table = calloc(table->allocated, item_size(table));
+  if (table->ctrl) {
+    table->ctrl = malloc(table->allocated);
+    memset(table->ctrl, HTA_CTRL_EMPTY, table->allocated);
+  }
+
+  // Step three: move the items over, now or later.
+  if (!table->incremental) {
+    hta_migrate(table, UINT_MAX);
+  }
+}
 
-  // Step two, add the old items to the new table.
-  for (index = 0; index < old_allocated; index++) {
-    bufidx = convert_idx(table, index);
-    if (((int8_t*)old_table)[bufidx] == HT_FULL) {
-      hta_insert(table, old_table + bufidx + HTA_KEY_OFFSET,
-                 old_table + bufidx + HTA_KEY_OFFSET + table->value_size);
+/**
+   @brief Return how many slots (or groups) a lookup of a full slot's key
+   probes.
+ */
+static unsigned int probe_length(const smb_hta *table, unsigned int index)
+{
+  unsigned int hash = slot_hash(table, convert_idx(table, index));
+  unsigned int n = 1, slot, ngroups;
+
+  if (table->ctrl) {
+    ngroups = table->allocated / HTA_GROUP_SIZE;
+    slot = group_home(group_hash(hash), ngroups);
+    while (slot != index / HTA_GROUP_SIZE && n <= ngroups) {
+      slot = (slot + n++) & (ngroups - 1);
     }
+    return n;
   }
+  slot = ht_home(hash, table->allocated, table->policy);
+  while (slot != index && n <= table->allocated) {
+    slot = ht_probe(slot, n++, table->allocated, table->policy);
+  }
+  return n;
+}
 
-  // Step three: free old data.
-  smb_free(old_table);
+/**
+   @brief Add the probe lengths and memory of one table to stats.
+ */
+static void stats_add(const smb_hta *table, smb_ht_stats *stats)
+{
+  unsigned int i;
+  for (i = 0; i < table->allocated; i++) {
+    if (slot_full(table, i)) {
+      ht_stats_probe(stats, probe_length(table, i));
+    }
+  }
+  stats->bytes += sizeof(smb_hta);
+  if (table->map) {
+    stats->bytes += table->map_size;
+  } else {
+    stats->bytes += (size_t) table->allocated * item_size(table) +
+      (table->ctrl ? table->allocated : 0);
+  }
+}
+
+/**
+   @brief Return the id a file uses for a hash function.
+ */
+static uint32_t file_hash_id(HTA_HASH hash)
+{
+  if (hash == hta_int_hash) {
+    return HTA_FILE_HASH_INT;
+  } else if (hash == hta_llint_hash) {
+    return HTA_FILE_HASH_LLINT;
+  }
+  return HTA_FILE_HASH_OTHER;
+}
+
+/**
+   @brief Return whether a file's header describes a table hta_map() can use,
+   given the arguments it was called with and the size of the file.
+
+   The number of slots must be one the policy's probing works with: lookups in
+   a table of any other size could miss keys or never stop.
+ */
+static bool file_header_ok(const struct hta_file_header *header,
+                           HTA_HASH hash_func, unsigned int key_size,
+                           unsigned int value_size, uint64_t file_size)
+{
+  uint64_t size = HTA_FILE_HEADER_SIZE +
+    (uint64_t) header->allocated * header->record_size +
+    (header->has_ctrl ? header->allocated : 0);
+
+  return memcmp(header->magic, HTA_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+    header->byte_order == HTA_FILE_BYTE_ORDER &&
+    header->key_size == key_size && header->value_size == value_size &&
+    header->record_size == HTA_KEY_OFFSET + key_size + value_size &&
+    header->policy <= HT_GROUP &&
+    header->has_ctrl == (header->policy == HT_GROUP) &&
+    ht_valid_size(header->allocated, header->policy) &&
+    (header->policy != HT_GROUP || header->allocated % HTA_GROUP_SIZE == 0) &&
+    header->length + (uint64_t) header->graves < header->allocated &&
+    header->hash_id == file_hash_id(hash_func) &&
+    (header->hash_id == HTA_FILE_HASH_OTHER ||
+     header->seed == hash_get_seed()) &&
+    size == file_size;
 }
 
 /**
-   @brief Return the load factor of a hash table.
+   @brief Return whether the hashes stored in the first few records of a table
+   are the ones its hash function gives.
+
+   This catches a table opened with the wrong hash function (or seed), which
+   would otherwise fail to find keys without any error.
+ */
+static bool hashes_match(const smb_hta *table)
+{
+  unsigned int i, checked = 0, bufidx;
+  for (i = 0; i < table->allocated && checked < HTA_FILE_CHECK_KEYS; i++) {
+    if (slot_full(table, i)) {
+      bufidx = convert_idx(table, i);
+      if (table->hash(table->table + bufidx + HTA_KEY_OFFSET) !=
+          slot_hash(table, bufidx)) {
+        return false;
+      }
+      checked++;
+    }
+  }
+  return true;
+}
+
+/**
+   @brief Return the load factor of a hash table, counting grave stones, since
+   probes have to step over them too.
 
    @param table The table to find the load factor of.
    @returns The load factor of the hash table.
  */
 double hta_load_factor(smb_hta *table)
 {
-  return ((double) table->length) / ((double) table->allocated);
+  return ((double) table->length + table->graves) / ((double) table->allocated);
+}
+
+/**
+   @brief Return the load factor a table may reach before it is rehashed.
+ */
+static double max_load(const smb_hta *table)
+{
+  return table->ctrl ? HTA_GROUP_MAX_LOAD_FACTOR : HASH_TABLE_MAX_LOAD_FACTOR;
 }
 
 /*******************************************************************************
@@ -144,17 +769,64 @@ double hta_load_factor(smb_hta *table)
 
 void hta_init(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
               unsigned int key_size, unsigned int value_size)
+{
+  hta_init_policy(table, hash_func, equal, key_size, value_size, HT_PRIME);
+}
+
+void hta_init_policy(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
+                     unsigned int key_size, unsigned int value_size,
+                     smb_ht_policy policy)
 {
   // Initialize values
   table->length = 0;
-  table->allocated = HASH_TABLE_INITIAL_SIZE;
+  table->graves = 0;
+  table->allocated = ht_initial_size(policy);
+  table->policy = policy;
   table->key_size = key_size;
   table->value_size = value_size;
   table->hash = hash_func;
   table->equal = equal;
 
+  table->old = NULL;
+  table->migrated = 0;
+  table->incremental = false;
+  table->map = NULL;
+  table->arena = NULL;
+  table->resizes = 0;
+  table->lookups = table->hits = table->probes = 0;
+
   // Allocate table
-  table->table = calloc(HASH_TABLE_INITIAL_SIZE, item_size(table));
+  table->table = calloc(table->allocated, item_size(table));
+  table->ctrl = NULL;
+  if (policy == HT_GROUP) {
+    table->ctrl = malloc(table->allocated);
+    memset(table->ctrl, HTA_CTRL_EMPTY, table->allocated);
+  }
+}
+
+void hta_init_keys(smb_hta *table, unsigned int value_size,
+                   smb_ht_policy policy)
+{
+  hta_init_policy(table, hta_bytes_hash, hta_bytes_comp, sizeof(smb_hta_key),
+                  value_size, policy);
+  table->arena = smb_new(smb_hta_arena, 1);
+  table->arena->data = NULL;
+  table->arena->length = 0;
+  table->arena->allocated = 0;
+  table->arena->dead = 0;
+}
+
+smb_hta_bytes hta_key_bytes(smb_hta const *table, void *key)
+{
+  return key_bytes(table, key);
+}
+
+void hta_set_incremental(smb_hta *table, bool incremental)
+{
+  table->incremental = incremental;
+  if (!incremental && table->old) {
+    hta_migrate(table, UINT_MAX);
+  }
 }
 
 smb_hta *hta_create(HTA_HASH hash_func, HTA_COMP equal,
@@ -169,7 +841,21 @@ smb_hta *hta_create(HTA_HASH hash_func, HTA_COMP equal,
 
 void hta_destroy(smb_hta *table)
 {
-  smb_free(table->table);
+  if (table->map) {
+    munmap(table->map, table->map_size);
+  } else {
+    smb_free(table->table);
+    free(table->ctrl);
+  }
+  if (table->old) {
+    table->old->arena = NULL;
+    hta_destroy(table->old);
+    smb_free(table->old);
+  }
+  if (table->arena) {
+    smb_free(table->arena->data);
+    smb_free(table->arena);
+  }
 }
 
 void hta_delete(smb_hta *table)
@@ -182,64 +868,135 @@ void hta_delete(smb_hta *table)
   smb_free(table);
 }
 
-void hta_insert(smb_hta *table, void *key, void *value)
+void hta_reserve(smb_hta *table, unsigned int n)
 {
-  unsigned int index, bufidx;
-  if (hta_load_factor(table) > HASH_TABLE_MAX_LOAD_FACTOR) {
-    hta_resize(table);
+  unsigned int size = ht_reserve_size(table->allocated, n, table->policy,
+                                      max_load(table));
+  // Graves would use up the room too, so clear them if need be.
+  if (size != table->allocated ||
+      n + table->graves > table->allocated * max_load(table)) {
+    hta_rehash(table, size);
   }
+}
 
-  // First, probe for the key as if we're trying to return it.  If we find it,
-  // we update the existing key.
-  index = hta_find_retrieve(table, key);
-  bufidx = convert_idx(table, index);
-  if (HTA_MARK(table, bufidx) == HT_FULL) {
-    memcpy(table->table + bufidx + HTA_KEY_OFFSET + table->key_size, value,
-           table->value_size);
-    return;
+/**
+   @brief Return the value of a key whose hash is known, inserting the key if
+   need be.  See hta_upsert().
+ */
+static void *hta_upsert_hash(smb_hta *table, void *key, unsigned int hash,
+                             bool *inserted)
+{
+  unsigned int index, old_index;
+  smb_hta_key stored;
+  void *value;
+  if (table->old) {
+    hta_migrate(table, HASH_TABLE_MIGRATE_SLOTS);
+  }
+  if (hta_load_factor(table) > max_load(table)) {
+    hta_rehash(table, ht_rehash_size(table->allocated, table->length,
+                                     table->policy, max_load(table)));
+  }
+  if (inserted) {
+    *inserted = false;
   }
 
-  // If we don't find the key, then we find the first open slot or gravestone.
-  index = hta_find_insert(table, key);
-  bufidx = convert_idx(table, index);
-  HTA_MARK(table, bufidx) = HT_FULL;
-  memcpy(table->table + bufidx + HTA_KEY_OFFSET, key, table->key_size);
-  memcpy(table->table + bufidx + HTA_KEY_OFFSET + table->key_size, value,
-         table->value_size);
+  // Probe for the key once.  If we find it, we return its value.
+  HT_COUNT(table, lookups, 1);
+  index = hta_find_retrieve(table, key, hash);
+  if (slot_full(table, index)) {
+    HT_COUNT(table, hits, 1);
+    return table->table + convert_idx(table, index) + HTA_KEY_OFFSET +
+      table->key_size;
+  }
+  if (table->old) {
+    old_index = hta_find_retrieve(table->old, key, hash);
+    if (slot_full(table->old, old_index)) {
+      HT_COUNT(table, hits, 1);
+      return table->old->table + convert_idx(table->old, old_index) +
+        HTA_KEY_OFFSET + table->key_size;
+    }
+  }
+
+  // If we don't find the key, the probe stopped at the slot it belongs in.
+  if (table->arena) {
+    key_store(table, &stored, key);
+    key = &stored;
+  }
+  value = hta_fill(table, index, key, hash);
+  memset(value, 0, table->value_size);
   table->length++;
+  if (inserted) {
+    *inserted = true;
+  }
+  return value;
+}
+
+void *hta_upsert(smb_hta *table, void *key, bool *inserted)
+{
+  return hta_upsert_hash(table, key, table->hash(key), inserted);
+}
+
+void hta_insert(smb_hta *table, void *key, void *value)
+{
+  void *slot = hta_upsert(table, key, NULL);
+  if (table->value_size) {
+    memcpy(slot, value, table->value_size);
+  }
 }
 
 void hta_remove(smb_hta *table, void *key, smb_status *status)
 {
   *status = SMB_SUCCESS;
-  unsigned int index = hta_find_retrieve(table, key);
-  unsigned int bufidx = convert_idx(table, index);
+  unsigned int index;
+  smb_hta *in = hta_lookup(table, key, table->hash(key), &index);
 
-  // If the returned slot isn't full, that means we couldn't find it.
-  if (HTA_MARK(table, bufidx) != HT_FULL) {
+  // If we didn't find a full slot, that means we couldn't find it.
+  if (!in) {
     *status = SMB_NOT_FOUND_ERROR;
     return;
   }
 
-  // Mark the slot with a "grave stone", indicating it is deleted.
-  HTA_MARK(table, bufidx) = HT_GRAVE;
-  table->length--;
+  // Mark the slot with a "grave stone", indicating it is deleted.  A key in
+  // the arena stays there until it's compacted.
+  if (table->arena &&
+      ((smb_hta_bytes *) key)->length > HTA_INLINE_KEY) {
+    table->arena->dead += ((smb_hta_bytes *) key)->length;
+  }
+  HTA_MARK(in, convert_idx(in, index)) = HT_GRAVE;
+  set_ctrl(in, index, 0, HT_GRAVE);
+  in->length--;
+  in->graves++;
+  if (in != table) {
+    table->length--;
+  }
+
+  // Don't start shrinking until the last rehash is done.
+  if (table->old) {
+    hta_migrate(table, HASH_TABLE_MIGRATE_SLOTS);
+    return;
+  }
+
+  unsigned int size = ht_shrink_size(table->allocated, table->length,
+                                     table->policy, max_load(table));
+  if (size != table->allocated) {
+    hta_rehash(table, size);
+  }
 }
 
 void *hta_get(smb_hta const *table, void *key, smb_status *status)
 {
   *status = SMB_SUCCESS;
-  unsigned int index = hta_find_retrieve(table, key);
-  unsigned int bufidx = convert_idx(table, index);
+  unsigned int index;
+  const smb_hta *in = hta_lookup(table, key, table->hash(key), &index);
 
-  // If the slot is not marked full, we didn't find the key.
-  if (HTA_MARK(table, bufidx) != HT_FULL) {
+  // If no slot was marked full, we didn't find the key.
+  if (!in) {
     *status = SMB_NOT_FOUND_ERROR;
     return NULL;
   }
 
   // Otherwise, return the value.
-  return table->table + bufidx + HTA_KEY_OFFSET + table->key_size;
+  return in->table + convert_idx(in, index) + HTA_KEY_OFFSET + in->key_size;
 }
 
 bool hta_contains(smb_hta const *table, void *key)
@@ -249,10 +1006,296 @@ bool hta_contains(smb_hta const *table, void *key)
   return status == SMB_SUCCESS;
 }
 
+/**
+   @brief A full slot, as the set operations see it.
+ */
+struct hta_entry {
+  void *key;
+  void *value;
+  unsigned int hash;
+  smb_hta_bytes bytes;
+};
+
+/**
+   @brief Find the next full slot at or after slot i, counting the old table's
+   slots as if they came after the table's own.
+
+   The entry's key is the one to pass to other tables, which for a table made
+   by hta_init_keys() points to the entry's own bytes.
+   @param table The table.
+   @param i The slot to start at, which is moved past the one found.
+   @param[out] e Where to put the slot's key, value and hash.
+   @returns Whether a full slot was found.
+ */
+static bool hta_next_entry(const smb_hta *table, unsigned int *i,
+                           struct hta_entry *e)
+{
+  const smb_hta *t;
+  unsigned int j, bufidx;
+  char *stored;
+
+  for (;; (*i)++) {
+    t = table;
+    j = *i;
+    if (j >= t->allocated) {
+      if (!t->old || j - t->allocated >= t->old->allocated) {
+        return false;
+      }
+      j -= t->allocated;
+      t = t->old;
+    }
+    bufidx = convert_idx(t, j);
+    if (HTA_MARK(t, bufidx) == HT_FULL) {
+      break;
+    }
+  }
+  (*i)++;
+
+  stored = t->table + bufidx + HTA_KEY_OFFSET;
+  e->key = stored;
+  e->value = stored + t->key_size;
+  e->hash = slot_hash(t, bufidx);
+  if (t->arena) {
+    e->bytes = key_bytes(t, stored);
+    e->key = &e->bytes;
+  }
+  return true;
+}
+
+/**
+   @brief Initialize an empty table which takes the same keys and values as
+   another.
+ */
+static void hta_init_like(smb_hta *out, const smb_hta *table)
+{
+  if (table->arena) {
+    hta_init_keys(out, table->value_size, table->policy);
+  } else {
+    hta_init_policy(out, table->hash, table->equal, table->key_size,
+                    table->value_size, table->policy);
+  }
+}
+
+void hta_union(smb_hta *out, smb_hta const *a, smb_hta const *b)
+{
+  const smb_hta *larger = a->length >= b->length ? a : b;
+  const smb_hta *smaller = larger == a ? b : a;
+  struct hta_entry e;
+  unsigned int i;
+  bool inserted;
+  void *value;
+
+  // The stored hashes are reused, so no key is hashed again.
+  hta_init_like(out, a);
+  hta_reserve(out, a->length + b->length);
+  for (i = 0; hta_next_entry(larger, &i, &e);) {
+    memcpy(hta_upsert_hash(out, e.key, e.hash, NULL), e.value, a->value_size);
+  }
+  for (i = 0; hta_next_entry(smaller, &i, &e);) {
+    value = hta_upsert_hash(out, e.key, e.hash, &inserted);
+    if (inserted || smaller == a) {
+      memcpy(value, e.value, a->value_size);
+    }
+  }
+}
+
+void hta_intersection(smb_hta *out, smb_hta const *a, smb_hta const *b)
+{
+  const smb_hta *larger = a->length >= b->length ? a : b;
+  const smb_hta *smaller = larger == a ? b : a;
+  const smb_hta *in;
+  struct hta_entry e;
+  unsigned int i, index;
+  void *value;
+
+  hta_init_like(out, a);
+  hta_reserve(out, smaller->length);
+  for (i = 0; hta_next_entry(smaller, &i, &e);) {
+    in = hta_lookup(larger, e.key, e.hash, &index);
+    if (in) {
+      value = smaller == a ? e.value : in->table + convert_idx(in, index) +
+        HTA_KEY_OFFSET + in->key_size;
+      memcpy(hta_upsert_hash(out, e.key, e.hash, NULL), value, a->value_size);
+    }
+  }
+}
+
+void hta_difference(smb_hta *out, smb_hta const *a, smb_hta const *b)
+{
+  struct hta_entry e;
+  unsigned int i, index;
+
+  hta_init_like(out, a);
+  hta_reserve(out, a->length);
+  for (i = 0; hta_next_entry(a, &i, &e);) {
+    if (!hta_lookup(b, e.key, e.hash, &index)) {
+      memcpy(hta_upsert_hash(out, e.key, e.hash, NULL), e.value,
+             a->value_size);
+    }
+  }
+}
+
+bool hta_is_subset(smb_hta const *a, smb_hta const *b)
+{
+  struct hta_entry e;
+  unsigned int i, index;
+
+  if (a->length > b->length) {
+    return false;
+  }
+  for (i = 0; hta_next_entry(a, &i, &e);) {
+    if (!hta_lookup(b, e.key, e.hash, &index)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void hta_stats(smb_hta const *table, smb_ht_stats *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+  stats->length = table->length;
+  stats->allocated = table->allocated;
+  stats->graves = table->graves;
+  stats->resizes = table->resizes;
+  stats->lookups = table->lookups;
+  stats->hits = table->hits;
+  stats->probes = table->probes;
+  stats_add(table, stats);
+  if (table->arena) {
+    stats->bytes += sizeof(smb_hta_arena) + table->arena->allocated;
+  }
+  if (table->old) {
+    stats->allocated += table->old->allocated;
+    stats->graves += table->old->graves;
+    stats->probes += table->old->probes;
+    stats_add(table->old, stats);
+  }
+}
+
+void hta_save(smb_hta *table, const char *path, smb_status *status)
+{
+  struct hta_file_header header;
+  char padding[HTA_FILE_HEADER_SIZE - sizeof(header)] = {0};
+  FILE *f;
+  bool ok;
+
+  *status = SMB_SUCCESS;
+  if (table->arena) {
+    *status = SMB_FORMAT_ERROR;
+    return;
+  }
+  if (table->old) {
+    hta_migrate(table, UINT_MAX);
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, HTA_FILE_MAGIC, sizeof(header.magic));
+  header.byte_order = HTA_FILE_BYTE_ORDER;
+  header.key_size = table->key_size;
+  header.value_size = table->value_size;
+  header.record_size = item_size(table);
+  header.policy = table->policy;
+  header.hash_id = file_hash_id(table->hash);
+  header.length = table->length;
+  header.allocated = table->allocated;
+  header.graves = table->graves;
+  header.has_ctrl = table->ctrl != NULL;
+  header.seed = hash_get_seed();
+
+  f = fopen(path, "wb");
+  if (!f) {
+    *status = SMB_IO_ERROR;
+    return;
+  }
+  ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+    fwrite(padding, sizeof(padding), 1, f) == 1 &&
+    fwrite(table->table, item_size(table), table->allocated, f) ==
+      table->allocated &&
+    (!table->ctrl ||
+     fwrite(table->ctrl, 1, table->allocated, f) == table->allocated);
+  if (fclose(f) != 0 || !ok) {
+    *status = SMB_IO_ERROR;
+  }
+}
+
+void hta_map(smb_hta *table, const char *path, HTA_HASH hash_func,
+             HTA_COMP equal, unsigned int key_size, unsigned int value_size,
+             smb_status *status)
+{
+  struct hta_file_header header;
+  struct stat st;
+  void *map;
+  int fd;
+
+  *status = SMB_SUCCESS;
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    *status = SMB_IO_ERROR;
+    return;
+  }
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    *status = SMB_IO_ERROR;
+    return;
+  }
+  if (st.st_size < HTA_FILE_HEADER_SIZE) {
+    close(fd);
+    *status = SMB_FORMAT_ERROR;
+    return;
+  }
+
+  // A private, writable mapping copies pages on write, so the table works like
+  // any other without the file ever changing.
+  map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    *status = SMB_IO_ERROR;
+    return;
+  }
+
+  memcpy(&header, map, sizeof(header));
+  if (!file_header_ok(&header, hash_func, key_size, value_size, st.st_size)) {
+    munmap(map, st.st_size);
+    *status = SMB_FORMAT_ERROR;
+    return;
+  }
+
+  table->length = header.length;
+  table->allocated = header.allocated;
+  table->graves = header.graves;
+  table->key_size = key_size;
+  table->value_size = value_size;
+  table->policy = header.policy;
+  table->hash = hash_func;
+  table->equal = equal;
+  table->table = (char *) map + HTA_FILE_HEADER_SIZE;
+  table->ctrl = NULL;
+  if (header.has_ctrl) {
+    table->ctrl = (uint8_t *) table->table +
+      (size_t) table->allocated * item_size(table);
+  }
+  table->old = NULL;
+  table->migrated = 0;
+  table->incremental = false;
+  table->arena = NULL;
+  table->map = map;
+  table->map_size = st.st_size;
+  table->resizes = 0;
+  table->lookups = table->hits = table->probes = 0;
+
+  if (!hashes_match(table)) {
+    munmap(map, st.st_size);
+    table->map = NULL;
+    *status = SMB_FORMAT_ERROR;
+  }
+}
+
 unsigned int hta_string_hash(void *data)
 {
-  char *theString = *(char**)data;
+  char *theString;
   unsigned int hash = 0;
+  memcpy(&theString, data, sizeof(theString));
 
   while (theString && *theString != '\0' ) {
     hash = (hash << 5) - hash + *theString;
@@ -265,14 +1308,37 @@ unsigned int hta_string_hash(void *data)
 
 int hta_string_comp(void *left, void *right)
 {
-  char **l = (char**)left, **r = (char**)right;
-  return strcmp(*l,*r);
+  char *l, *r;
+  memcpy(&l, left, sizeof(l));
+  memcpy(&r, right, sizeof(r));
+  return strcmp(l,r);
 }
 
 int hta_int_comp(void *left, void *right)
 {
-  int *l = (int*)left, *r = (int*)right;
-  return *l - *r;
+  int l, r;
+  memcpy(&l, left, sizeof(l));
+  memcpy(&r, right, sizeof(r));
+  return l - r;
+}
+
+int hta_llint_comp(void *left, void *right)
+{
+  long long l, r;
+  memcpy(&l, left, sizeof(l));
+  memcpy(&r, right, sizeof(r));
+  return (l > r) - (l < r);
+}
+
+int hta_bytes_comp(void *left, void *right)
+{
+  smb_hta_bytes *l = left, *r = right;
+  unsigned int length = l->length < r->length ? l->length : r->length;
+  int rv = length ? memcmp(l->data, r->data, length) : 0;
+  if (rv != 0) {
+    return rv;
+  }
+  return (l->length > r->length) - (l->length < r->length);
 }
 
 void hta_print(FILE* f, smb_hta const *table, HTA_PRINT key, HTA_PRINT value,
@@ -288,11 +1354,21 @@ void hta_print(FILE* f, smb_hta const *table, HTA_PRINT key, HTA_PRINT value,
       printf("[%04d|%05d|%s]:\n", i, bufidx, MARKS[mark]);
       if (mark == HT_FULL) {
         printf("  key: ");
-        key(f, table->table + bufidx + HTA_KEY_OFFSET);
+        if (table->arena) {
+          smb_hta_bytes bytes = key_bytes(table, table->table + bufidx +
+                                          HTA_KEY_OFFSET);
+          key(f, &bytes);
+        } else {
+          key(f, table->table + bufidx + HTA_KEY_OFFSET);
+        }
         printf("\n  value: ");
-        value(f, table->table + bufidx + HTA_KEY_OFFSET + table->value_size);
+        value(f, table->table + bufidx + HTA_KEY_OFFSET + table->key_size);
         printf("\n");
       }
     }
   }
+  if (table->old) {
+    fprintf(f, "rehashing from %u slots:\n", table->old->allocated);
+    hta_print(f, table->old, key, value, full_mode);
+  }
 }
@@ -0,0 +1,642 @@
+/***************************************************************************//**
+
+  @file         htf.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Implementation of "libstephen/htf.h".
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  Building a table goes like this.  The records are sorted by hash, and those
+  whose hash repeats are split off into the overflow.  The rest are grouped
+  into buckets by their hash, and the buckets are taken from largest to
+  smallest.  For each one, pilots 0, 1, 2, ... are tried until mixing the
+  pilot into every hash in the bucket gives slots that are all free, and those
+  slots are taken.  Large buckets go first, while most slots are free, so the
+  last buckets to be placed hold a single key, and need only find any free
+  slot.  The expected number of tries in all is about n log n.
+
+  Both kinds of table are built by the same code, which treats records as
+  blocks of bytes that start with their hash.
+
+*******************************************************************************/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "libstephen/hash.h"
+#include "libstephen/htf.h"
+
+/*
+  The average number of keys per bucket.  More buckets (and pilots) take more
+  memory, and fewer take longer to find pilots for.
+ */
+#define HTF_BUCKET_KEYS 2
+
+/*
+  Files written by hta_frozen_save() start with this header, padded to
+  HTF_FILE_HEADER_SIZE bytes.  The pilots follow, then the records, and then
+  the overflow records.
+ */
+#define HTF_FILE_MAGIC "smbhtf1"
+#define HTF_FILE_HEADER_SIZE 64
+#define HTF_FILE_BYTE_ORDER 0x01020304u
+
+/*
+  How many keys hta_frozen_map() rehashes to check the hash function.
+ */
+#define HTF_FILE_CHECK_KEYS 8
+
+struct htf_file_header {
+  char magic[8];
+  uint32_t byte_order;
+  uint32_t key_size;
+  uint32_t value_size;
+  uint32_t record_size;
+  uint32_t length;
+  uint32_t allocated;
+  uint32_t nbuckets;
+  uint32_t noverflow;
+  uint64_t seed;
+};
+
+/*
+  Everything built for a frozen table, whatever its records are.
+ */
+struct htf_layout {
+  unsigned int allocated;
+  unsigned int nbuckets;
+  unsigned int noverflow;
+  uint64_t seed;
+  uint32_t *pilots;
+  char *table;
+  char *overflow;
+};
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief Scale the high half of a mixed hash to [0, n), without dividing.
+ */
+static unsigned int htf_range(uint64_t mixed, unsigned int n)
+{
+  return (unsigned int) (((mixed >> 32) * n) >> 32);
+}
+
+/**
+   @brief Return the bucket of a hash.
+ */
+static unsigned int htf_bucket(unsigned int hash, uint64_t seed,
+                               unsigned int nbuckets)
+{
+  return htf_range(hash_int(hash, seed), nbuckets);
+}
+
+/**
+   @brief Return the slot of a hash, given its bucket's pilot.
+ */
+static unsigned int htf_slot(unsigned int hash, uint32_t pilot, uint64_t seed,
+                             unsigned int allocated)
+{
+  return htf_range(hash_int(((uint64_t) pilot << 32) | hash, ~seed),
+                   allocated);
+}
+
+/**
+   @brief Return the hash a record starts with.
+ */
+static unsigned int record_hash(const char *record)
+{
+  unsigned int hash;
+  memcpy(&hash, record, sizeof(hash));
+  return hash;
+}
+
+static int compare_records(const void *left, const void *right)
+{
+  unsigned int l = record_hash(left), r = record_hash(right);
+  return (l > r) - (l < r);
+}
+
+/**
+   @brief Try to choose a pilot for every bucket with one seed.
+   @param layout The layout, with seed and nbuckets set, to fill pilots in.
+   @param hashes The distinct hashes to place.
+   @param n The number of hashes, and slots.
+   @param[out] slots The slot each hash gets.
+   @returns Whether it worked.  It only fails if some bucket runs out of
+   pilots, which is next to impossible.
+ */
+static bool htf_try(struct htf_layout *layout, const unsigned int *hashes,
+                    unsigned int n, unsigned int *slots)
+{
+  unsigned int nb = layout->nbuckets, i, j, b, s, p, size, max_size = 0;
+  unsigned int *start = smb_new(unsigned int, nb + 1);
+  unsigned int *cursor = smb_new(unsigned int, nb);
+  unsigned int *members = smb_new(unsigned int, n + 1);
+  unsigned int *order = smb_new(unsigned int, nb);
+  unsigned int *count;
+  bool *taken = smb_new(bool, n + 1);
+  bool ok = true;
+
+  // Group the hashes by bucket (slots holds each one's bucket for now).
+  memset(start, 0, (nb + 1) * sizeof(unsigned int));
+  for (i = 0; i < n; i++) {
+    slots[i] = htf_bucket(hashes[i], layout->seed, nb);
+    start[slots[i] + 1]++;
+  }
+  for (b = 0; b < nb; b++) {
+    if (start[b + 1] > max_size) {
+      max_size = start[b + 1];
+    }
+    start[b + 1] += start[b];
+    cursor[b] = start[b];
+  }
+  for (i = 0; i < n; i++) {
+    members[cursor[slots[i]]++] = i;
+  }
+
+  // Sort the buckets from largest to smallest.
+  count = smb_new(unsigned int, max_size + 2);
+  memset(count, 0, (max_size + 2) * sizeof(unsigned int));
+  for (b = 0; b < nb; b++) {
+    count[max_size - (start[b + 1] - start[b]) + 1]++;
+  }
+  for (size = 0; size <= max_size; size++) {
+    count[size + 1] += count[size];
+  }
+  for (b = 0; b < nb; b++) {
+    order[count[max_size - (start[b + 1] - start[b])]++] = b;
+  }
+
+  // Find each bucket the first pilot which puts all its keys in free slots.
+  memset(taken, 0, (n + 1) * sizeof(bool));
+  memset(layout->pilots, 0, nb * sizeof(uint32_t));
+  for (i = 0; i < nb && ok; i++) {
+    b = order[i];
+    if (start[b] == start[b + 1]) {
+      break;
+    }
+    for (p = 0; ; p++) {
+      for (j = start[b]; j < start[b + 1]; j++) {
+        s = htf_slot(hashes[members[j]], p, layout->seed, n);
+        if (taken[s]) {
+          break;
+        }
+        taken[s] = true;
+        slots[members[j]] = s;
+      }
+      if (j == start[b + 1]) {
+        break;
+      }
+      // Give back the slots this pilot took.
+      while (j-- > start[b]) {
+        taken[slots[members[j]]] = false;
+      }
+      if (p == UINT32_MAX) {
+        ok = false;
+        break;
+      }
+    }
+    layout->pilots[b] = p;
+  }
+
+  smb_free(start);
+  smb_free(cursor);
+  smb_free(members);
+  smb_free(order);
+  smb_free(count);
+  smb_free(taken);
+  return ok;
+}
+
+/**
+   @brief Build a frozen table out of records which start with their hash.
+   @param[out] layout The layout to fill in.
+   @param records The records, which are sorted by hash in place.
+   @param n The number of records.
+   @param size The size of each record.
+ */
+static void htf_build(struct htf_layout *layout, char *records, unsigned int n,
+                      size_t size)
+{
+  unsigned int i, m = 0, o = 0, attempt;
+  unsigned int *hashes = smb_new(unsigned int, n + 1);
+  unsigned int *slots = smb_new(unsigned int, n + 1);
+  char *record;
+
+  qsort(records, n, size, compare_records);
+  layout->noverflow = 0;
+  for (i = 1; i < n; i++) {
+    layout->noverflow += record_hash(records + i * size) ==
+      record_hash(records + (i - 1) * size);
+  }
+  layout->allocated = n - layout->noverflow;
+  layout->overflow = smb___new((layout->noverflow + 1) * size);
+  for (i = 0; i < n; i++) {
+    record = records + i * size;
+    if (i > 0 && record_hash(record) == record_hash(record - size)) {
+      memcpy(layout->overflow + o++ * size, record, size);
+    } else {
+      hashes[m++] = record_hash(record);
+    }
+  }
+
+  layout->nbuckets = m / HTF_BUCKET_KEYS + 1;
+  layout->pilots = smb_new(uint32_t, layout->nbuckets);
+  for (attempt = 1; ; attempt++) {
+    layout->seed = hash_int(attempt, 0);
+    if (htf_try(layout, hashes, m, slots)) {
+      break;
+    }
+  }
+
+  // The hashes were taken in order, so the mth distinct one is mth here too.
+  layout->table = smb___new((m + 1) * size);
+  for (i = 0, m = 0; i < n; i++) {
+    record = records + i * size;
+    if (i == 0 || record_hash(record) != record_hash(record - size)) {
+      memcpy(layout->table + slots[m++] * size, record, size);
+    }
+  }
+
+  smb_free(hashes);
+  smb_free(slots);
+}
+
+/**
+   @brief Return the slot a hash could be in, or allocated if there are none.
+ */
+static unsigned int htf_find(const uint32_t *pilots, unsigned int nbuckets,
+                             unsigned int allocated, uint64_t seed,
+                             unsigned int hash)
+{
+  if (allocated == 0) {
+    return 0;
+  }
+  return htf_slot(hash, pilots[htf_bucket(hash, seed, nbuckets)], seed,
+                  allocated);
+}
+
+/**
+   @brief Return the index of the first overflow record with a hash, or
+   noverflow if there are none.
+ */
+static unsigned int htf_find_overflow(const char *overflow,
+                                      unsigned int noverflow, size_t size,
+                                      unsigned int hash)
+{
+  unsigned int lo = 0, hi = noverflow, mid;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (record_hash(overflow + mid * size) < hash) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < noverflow && record_hash(overflow + lo * size) == hash) {
+    return lo;
+  }
+  return noverflow;
+}
+
+/*******************************************************************************
+
+                           Public Interface Functions
+
+*******************************************************************************/
+
+void ht_freeze(smb_ht const *table, smb_ht_frozen *frozen)
+{
+  smb_ht_frozen_entry *entries = smb_new(smb_ht_frozen_entry,
+                                         table->length + 1);
+  const smb_ht *t;
+  struct htf_layout layout;
+  unsigned int i, n = 0;
+
+  // Copy out the keys, including any still in the old table.
+  for (t = table; t; t = t->old) {
+    for (i = 0; i < t->allocated; i++) {
+      if (t->table[i].mark == HT_FULL) {
+        entries[n].hash = t->table[i].hash;
+        entries[n].key = t->table[i].key;
+        entries[n].value = t->table[i].value;
+        n++;
+      }
+    }
+  }
+
+  htf_build(&layout, (char *) entries, n, sizeof(smb_ht_frozen_entry));
+  smb_free(entries);
+
+  frozen->length = n;
+  frozen->allocated = layout.allocated;
+  frozen->nbuckets = layout.nbuckets;
+  frozen->noverflow = layout.noverflow;
+  frozen->seed = layout.seed;
+  frozen->hash = table->hash;
+  frozen->equal = table->equal;
+  frozen->pilots = layout.pilots;
+  frozen->table = (smb_ht_frozen_entry *) layout.table;
+  frozen->overflow = (smb_ht_frozen_entry *) layout.overflow;
+}
+
+void ht_frozen_destroy(smb_ht_frozen *frozen)
+{
+  smb_free(frozen->pilots);
+  smb_free(frozen->table);
+  smb_free(frozen->overflow);
+}
+
+/**
+   @brief Return the entry for a key, or NULL.
+ */
+static const smb_ht_frozen_entry *ht_frozen_lookup(const smb_ht_frozen *frozen,
+                                                   DATA key)
+{
+  unsigned int hash = frozen->hash(key), i;
+  const smb_ht_frozen_entry *e;
+
+  i = htf_find(frozen->pilots, frozen->nbuckets, frozen->allocated,
+               frozen->seed, hash);
+  if (i < frozen->allocated) {
+    e = &frozen->table[i];
+    if (e->hash == hash && frozen->equal(e->key, key) == 0) {
+      return e;
+    }
+  }
+
+  // Only keys sharing a hash with another are in the overflow.
+  if (frozen->noverflow == 0) {
+    return NULL;
+  }
+  i = htf_find_overflow((const char *) frozen->overflow, frozen->noverflow,
+                        sizeof(smb_ht_frozen_entry), hash);
+  for (; i < frozen->noverflow && frozen->overflow[i].hash == hash; i++) {
+    if (frozen->equal(frozen->overflow[i].key, key) == 0) {
+      return &frozen->overflow[i];
+    }
+  }
+  return NULL;
+}
+
+DATA ht_frozen_get(smb_ht_frozen const *frozen, DATA key, smb_status *status)
+{
+  const smb_ht_frozen_entry *e = ht_frozen_lookup(frozen, key);
+  *status = SMB_SUCCESS;
+  if (!e) {
+    *status = SMB_NOT_FOUND_ERROR;
+    return PTR(NULL);
+  }
+  return e->value;
+}
+
+bool ht_frozen_contains(smb_ht_frozen const *frozen, DATA key)
+{
+  return ht_frozen_lookup(frozen, key) != NULL;
+}
+
+/**
+   @brief Return the size of a frozen record: hash, key and value.
+ */
+static size_t hta_frozen_record_size(const smb_hta_frozen *frozen)
+{
+  return sizeof(unsigned int) + frozen->key_size + frozen->value_size;
+}
+
+void hta_freeze(smb_hta const *table, smb_hta_frozen *frozen,
+                smb_status *status)
+{
+  size_t size = sizeof(unsigned int) + table->key_size + table->value_size;
+  size_t stride = HTA_KEY_OFFSET + table->key_size + table->value_size;
+  char *records;
+  const smb_hta *t;
+  struct htf_layout layout;
+  unsigned int i, n = 0;
+
+  *status = SMB_SUCCESS;
+  if (table->arena) {
+    memset(frozen, 0, sizeof(*frozen));
+    *status = SMB_FORMAT_ERROR;
+    return;
+  }
+  records = smb___new((table->length + 1) * size);
+
+  // Copy out the records without their marks, including any still in the old
+  // table.
+  for (t = table; t; t = t->old) {
+    for (i = 0; i < t->allocated; i++) {
+      if (HTA_MARK(t, i * stride) == HT_FULL) {
+        memcpy(records + n++ * size, (char *) t->table + i * stride +
+               HTA_HASH_OFFSET, size);
+      }
+    }
+  }
+
+  htf_build(&layout, records, n, size);
+  smb_free(records);
+
+  frozen->length = n;
+  frozen->allocated = layout.allocated;
+  frozen->nbuckets = layout.nbuckets;
+  frozen->noverflow = layout.noverflow;
+  frozen->key_size = table->key_size;
+  frozen->value_size = table->value_size;
+  frozen->seed = layout.seed;
+  frozen->hash = table->hash;
+  frozen->equal = table->equal;
+  frozen->pilots = layout.pilots;
+  frozen->table = layout.table;
+  frozen->overflow = layout.overflow;
+  frozen->map = NULL;
+}
+
+void hta_frozen_destroy(smb_hta_frozen *frozen)
+{
+  if (frozen->map) {
+    munmap(frozen->map, frozen->map_size);
+  } else {
+    smb_free(frozen->pilots);
+    smb_free(frozen->table);
+    smb_free(frozen->overflow);
+  }
+}
+
+void *hta_frozen_get(smb_hta_frozen const *frozen, void *key,
+                     smb_status *status)
+{
+  size_t size = hta_frozen_record_size(frozen);
+  unsigned int hash = frozen->hash(key), i;
+  const char *record;
+
+  *status = SMB_SUCCESS;
+  i = htf_find(frozen->pilots, frozen->nbuckets, frozen->allocated,
+               frozen->seed, hash);
+  if (i < frozen->allocated) {
+    record = (const char *) frozen->table + i * size;
+    if (record_hash(record) == hash &&
+        frozen->equal(key, (void *) (record + sizeof(unsigned int))) == 0) {
+      return (void *) (record + sizeof(unsigned int) + frozen->key_size);
+    }
+  }
+
+  i = frozen->noverflow == 0 ? 0 :
+    htf_find_overflow(frozen->overflow, frozen->noverflow, size, hash);
+  for (; i < frozen->noverflow; i++) {
+    record = (const char *) frozen->overflow + i * size;
+    if (record_hash(record) != hash) {
+      break;
+    }
+    if (frozen->equal(key, (void *) (record + sizeof(unsigned int))) == 0) {
+      return (void *) (record + sizeof(unsigned int) + frozen->key_size);
+    }
+  }
+
+  *status = SMB_NOT_FOUND_ERROR;
+  return NULL;
+}
+
+bool hta_frozen_contains(smb_hta_frozen const *frozen, void *key)
+{
+  smb_status status = SMB_SUCCESS;
+  hta_frozen_get(frozen, key, &status);
+  return status == SMB_SUCCESS;
+}
+
+/**
+   @brief Return the size of the pilots in a file, padded to 8 bytes.
+ */
+static size_t htf_file_pilots_size(unsigned int nbuckets)
+{
+  return ((size_t) nbuckets * sizeof(uint32_t) + 7) & ~(size_t) 7;
+}
+
+void hta_frozen_save(smb_hta_frozen const *frozen, const char *path,
+                     smb_status *status)
+{
+  struct htf_file_header header;
+  char padding[HTF_FILE_HEADER_SIZE - sizeof(header)] = {0};
+  size_t size = hta_frozen_record_size(frozen);
+  size_t pilots = (size_t) frozen->nbuckets * sizeof(uint32_t);
+  FILE *f;
+  bool ok;
+
+  *status = SMB_SUCCESS;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, HTF_FILE_MAGIC, sizeof(header.magic));
+  header.byte_order = HTF_FILE_BYTE_ORDER;
+  header.key_size = frozen->key_size;
+  header.value_size = frozen->value_size;
+  header.record_size = size;
+  header.length = frozen->length;
+  header.allocated = frozen->allocated;
+  header.nbuckets = frozen->nbuckets;
+  header.noverflow = frozen->noverflow;
+  header.seed = frozen->seed;
+
+  f = fopen(path, "wb");
+  if (!f) {
+    *status = SMB_IO_ERROR;
+    return;
+  }
+  ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+    fwrite(padding, sizeof(padding), 1, f) == 1 &&
+    fwrite(frozen->pilots, 1, pilots, f) == pilots &&
+    fwrite(padding, 1, htf_file_pilots_size(frozen->nbuckets) - pilots, f) ==
+      htf_file_pilots_size(frozen->nbuckets) - pilots &&
+    fwrite(frozen->table, size, frozen->allocated, f) == frozen->allocated &&
+    fwrite(frozen->overflow, size, frozen->noverflow, f) == frozen->noverflow;
+  if (fclose(f) != 0 || !ok) {
+    *status = SMB_IO_ERROR;
+  }
+}
+
+void hta_frozen_map(smb_hta_frozen *frozen, const char *path,
+                    HTA_HASH hash_func, HTA_COMP equal, unsigned int key_size,
+                    unsigned int value_size, smb_status *status)
+{
+  struct htf_file_header header;
+  struct stat st;
+  size_t size = sizeof(unsigned int) + key_size + value_size;
+  uint64_t expected;
+  unsigned int i;
+  char *map;
+  int fd;
+
+  *status = SMB_SUCCESS;
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    *status = SMB_IO_ERROR;
+    return;
+  }
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    *status = SMB_IO_ERROR;
+    return;
+  }
+  if (st.st_size < HTF_FILE_HEADER_SIZE) {
+    close(fd);
+    *status = SMB_FORMAT_ERROR;
+    return;
+  }
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    *status = SMB_IO_ERROR;
+    return;
+  }
+
+  memcpy(&header, map, sizeof(header));
+  expected = HTF_FILE_HEADER_SIZE + htf_file_pilots_size(header.nbuckets) +
+    ((uint64_t) header.allocated + header.noverflow) * size;
+  if (memcmp(header.magic, HTF_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.byte_order != HTF_FILE_BYTE_ORDER ||
+      header.key_size != key_size || header.value_size != value_size ||
+      header.record_size != size || header.nbuckets == 0 ||
+      header.allocated + (uint64_t) header.noverflow != header.length ||
+      expected != (uint64_t) st.st_size) {
+    munmap(map, st.st_size);
+    *status = SMB_FORMAT_ERROR;
+    return;
+  }
+
+  frozen->length = header.length;
+  frozen->allocated = header.allocated;
+  frozen->nbuckets = header.nbuckets;
+  frozen->noverflow = header.noverflow;
+  frozen->key_size = key_size;
+  frozen->value_size = value_size;
+  frozen->seed = header.seed;
+  frozen->hash = hash_func;
+  frozen->equal = equal;
+  frozen->pilots = (uint32_t *) (map + HTF_FILE_HEADER_SIZE);
+  frozen->table = map + HTF_FILE_HEADER_SIZE +
+    htf_file_pilots_size(header.nbuckets);
+  frozen->overflow = (char *) frozen->table + header.allocated * size;
+  frozen->map = map;
+  frozen->map_size = st.st_size;
+
+  // A different hash function (or seed) would miss every key quietly.
+  for (i = 0; i < frozen->allocated && i < HTF_FILE_CHECK_KEYS; i++) {
+    char *record = (char *) frozen->table + i * size;
+    if (hash_func(record + sizeof(unsigned int)) != record_hash(record)) {
+      munmap(map, st.st_size);
+      frozen->map = NULL;
+      *status = SMB_FORMAT_ERROR;
+      return;
+    }
+  }
+}
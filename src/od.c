@@ -0,0 +1,347 @@
+/***************************************************************************//**
+
+  @file         od.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Implementation of "libstephen/od.h".
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  The index table is probed like CPython's: each step multiplies the slot by 5
+  and adds in the next few bits of the hash, so every bit of the hash is used
+  before the probe sequence settles into visiting every slot.  That lets
+  ht_string_hash() and other weak hashes work without a power of two table
+  clustering keys.
+
+*******************************************************************************/
+
+#include <string.h>
+
+#include "libstephen/od.h"
+
+/*
+  Index table values that aren't entry indices.
+ */
+#define OD_EMPTY (-1)
+#define OD_DUMMY (-2)
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief Return the number of entries a table with this many slots holds.
+ */
+static unsigned int od_usable(unsigned int size)
+{
+  return size * 2 / 3;
+}
+
+/**
+   @brief Return the bytes per index for a table with this many slots.
+ */
+static unsigned int od_width(unsigned int size)
+{
+  if (od_usable(size) <= INT8_MAX) {
+    return 1;
+  } else if (od_usable(size) <= INT16_MAX) {
+    return 2;
+  }
+  return 4;
+}
+
+static int32_t od_get_index(const smb_od *table, unsigned int slot)
+{
+  switch (table->width) {
+  case 1:
+    return ((const int8_t *) table->indices)[slot];
+  case 2:
+    return ((const int16_t *) table->indices)[slot];
+  default:
+    return ((const int32_t *) table->indices)[slot];
+  }
+}
+
+static void od_set_index(smb_od *table, unsigned int slot, int32_t index)
+{
+  switch (table->width) {
+  case 1:
+    ((int8_t *) table->indices)[slot] = (int8_t) index;
+    break;
+  case 2:
+    ((int16_t *) table->indices)[slot] = (int16_t) index;
+    break;
+  default:
+    ((int32_t *) table->indices)[slot] = index;
+    break;
+  }
+}
+
+/**
+   @brief Find the slot for a key.
+   @param table The table.
+   @param key The key to look for.
+   @param hash The key's hash.
+   @param[out] slot The slot holding the key, or if it isn't there, the first
+   free slot the probe passed.
+   @returns The index of the key's entry, or OD_EMPTY if it isn't there.
+ */
+static int32_t od_lookup(const smb_od *table, DATA key, unsigned int hash,
+                         unsigned int *slot)
+{
+  unsigned int mask = table->size - 1, i = hash & mask, perturb = hash;
+  bool found_free = false;
+
+  for (;;) {
+    int32_t ix = od_get_index(table, i);
+    if (ix == OD_EMPTY) {
+      if (!found_free) {
+        *slot = i;
+      }
+      return OD_EMPTY;
+    } else if (ix == OD_DUMMY) {
+      if (!found_free) {
+        *slot = i;
+        found_free = true;
+      }
+    } else if (table->entries[ix].hash == hash &&
+               table->equal(table->entries[ix].key, key) == 0) {
+      *slot = i;
+      return ix;
+    }
+    i = (i * 5 + perturb + 1) & mask;
+    perturb >>= 5;
+  }
+}
+
+/**
+   @brief Allocate an empty index table with this many slots.
+ */
+static void od_alloc(smb_od *table, unsigned int size)
+{
+  table->size = size;
+  table->width = od_width(size);
+  table->indices = smb___new(size * table->width);
+  // Every byte of -1 is -1 at any width.
+  memset(table->indices, 0xFF, size * table->width);
+  table->entries = smb_new(smb_od_entry, od_usable(size));
+}
+
+/**
+   @brief Rebuild the table with at least three index slots per live entry,
+   dropping removed entries.
+ */
+static void od_resize(smb_od *table)
+{
+  smb_od_entry *old = table->entries;
+  unsigned int i, n = 0, size = OD_INITIAL_SIZE, slot, perturb;
+
+  while (size < 3 * table->length) {
+    size *= 2;
+  }
+  smb___free(table->indices);
+  od_alloc(table, size);
+
+  for (i = 0; i < table->nentries; i++) {
+    if (!old[i].live) {
+      continue;
+    }
+    // There are no duplicates or dummies, so the first empty slot will do.
+    slot = old[i].hash & (size - 1);
+    perturb = old[i].hash;
+    while (od_get_index(table, slot) != OD_EMPTY) {
+      slot = (slot * 5 + perturb + 1) & (size - 1);
+      perturb >>= 5;
+    }
+    table->entries[n] = old[i];
+    od_set_index(table, slot, n++);
+  }
+  table->nentries = n;
+  smb_free(old);
+}
+
+/*******************************************************************************
+
+                           Public Interface Functions
+
+*******************************************************************************/
+
+void od_init(smb_od *table, HASH_FUNCTION hash_func, DATA_COMPARE equal)
+{
+  table->length = 0;
+  table->nentries = 0;
+  table->hash = hash_func;
+  table->equal = equal;
+  od_alloc(table, OD_INITIAL_SIZE);
+}
+
+smb_od *od_create(HASH_FUNCTION hash_func, DATA_COMPARE equal)
+{
+  smb_od *table = smb_new(smb_od, 1);
+  od_init(table, hash_func, equal);
+  return table;
+}
+
+void od_destroy_act(smb_od *table, DATA_ACTION deleter)
+{
+  unsigned int i;
+  if (deleter) {
+    for (i = 0; i < table->nentries; i++) {
+      if (table->entries[i].live) {
+        deleter(table->entries[i].value);
+      }
+    }
+  }
+  smb___free(table->indices);
+  smb_free(table->entries);
+}
+
+void od_destroy(smb_od *table)
+{
+  od_destroy_act(table, NULL);
+}
+
+void od_delete_act(smb_od *table, DATA_ACTION deleter)
+{
+  if (!table) {
+    return;
+  }
+
+  od_destroy_act(table, deleter);
+  smb_free(table);
+}
+
+void od_delete(smb_od *table)
+{
+  od_delete_act(table, NULL);
+}
+
+void od_insert(smb_od *table, DATA key, DATA value)
+{
+  unsigned int slot, hash = table->hash(key);
+  int32_t ix = od_lookup(table, key, hash, &slot);
+
+  if (ix >= 0) {
+    table->entries[ix].value = value;
+    return;
+  }
+
+  // Entries are only ever appended, so when the array is full, compact it, and
+  // grow it if need be.
+  if (table->nentries == od_usable(table->size)) {
+    od_resize(table);
+    od_lookup(table, key, hash, &slot);
+  }
+
+  table->entries[table->nentries].key = key;
+  table->entries[table->nentries].value = value;
+  table->entries[table->nentries].hash = hash;
+  table->entries[table->nentries].live = true;
+  od_set_index(table, slot, table->nentries++);
+  table->length++;
+}
+
+void od_remove_act(smb_od *table, DATA key, DATA_ACTION deleter,
+                   smb_status *status)
+{
+  unsigned int slot;
+  int32_t ix = od_lookup(table, key, table->hash(key), &slot);
+
+  *status = SMB_SUCCESS;
+  if (ix < 0) {
+    *status = SMB_NOT_FOUND_ERROR;
+    return;
+  }
+
+  if (deleter) {
+    deleter(table->entries[ix].value);
+  }
+  // The slot becomes a dummy, so probes for other keys carry on past it.
+  od_set_index(table, slot, OD_DUMMY);
+  table->entries[ix].live = false;
+  table->length--;
+}
+
+void od_remove(smb_od *table, DATA key, smb_status *status)
+{
+  od_remove_act(table, key, NULL, status);
+}
+
+DATA od_get(smb_od const *table, DATA key, smb_status *status)
+{
+  unsigned int slot;
+  int32_t ix = od_lookup(table, key, table->hash(key), &slot);
+
+  *status = SMB_SUCCESS;
+  if (ix < 0) {
+    *status = SMB_NOT_FOUND_ERROR;
+    return PTR(NULL);
+  }
+  return table->entries[ix].value;
+}
+
+bool od_contains(smb_od const *table, DATA key)
+{
+  unsigned int slot;
+  return od_lookup(table, key, table->hash(key), &slot) >= 0;
+}
+
+DATA od_iter_next(smb_iter *iter, smb_status *status)
+{
+  *status = SMB_SUCCESS;
+  long long int i = iter->state.data_llint + 1;
+  const smb_od *od = iter->ds;
+
+  // Skip over removed entries.
+  while (i < od->nentries && !od->entries[i].live) {
+    i++;
+  }
+  iter->state.data_llint = i;
+
+  if (i >= od->nentries) {
+    *status = SMB_STOP_ITERATION;
+    return LLINT(0);
+  }
+  iter->index++;
+  return od->entries[i].key;
+}
+
+bool od_iter_has_next(smb_iter *iter)
+{
+  const smb_od *od = iter->ds;
+  return iter->index < (int)od->length;
+}
+
+void od_iter_destroy(smb_iter *iter)
+{
+  (void)iter; //unused
+}
+
+void od_iter_delete(smb_iter *iter)
+{
+  od_iter_destroy(iter);
+  free(iter);
+}
+
+smb_iter od_get_iter(const smb_od *table)
+{
+  smb_iter iter = {
+    // Data:
+    .ds = table,        // A reference to the data structure.
+    .state = LLINT(-1), // This tracks the index into the entries.
+    .index = 0,         // This tracks how many keys have been returned.
+
+    // Functions
+    .next = &od_iter_next,
+    .has_next = &od_iter_has_next,
+    .destroy = &od_iter_destroy,
+    .delete = &od_iter_delete
+  };
+  return iter;
+}
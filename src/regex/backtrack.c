@@ -0,0 +1,238 @@
+/***************************************************************************//**
+
+  @file         backtrack.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Bounded backtracking matcher for short inputs.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+  The Pike VM keeps a list of threads, each with its own copy of the capture
+  array, and it allocates a new one at every split.  For short inputs, it's a
+  lot cheaper to just explore the program depth first, with a single capture
+  array.  Threads are explored in priority order, so the first match found is
+  the same one the Pike VM would report.
+
+  To search rather than match at the start of the string, each starting index is
+  tried in turn.  The visited bitmap doesn't depend on where a thread started,
+  so it's shared between them, and a search is no more work than a match.
+
+  Plain backtracking can take exponential time, so (like RE2's "BitState") we
+  keep a bitmap of every (instruction, string index) pair that has been tried.
+  Once a pair has failed, it will fail again, so it is never tried twice.  That
+  bounds the work by the size of the bitmap, which is why this is only used
+  when the program and input are small enough (see BACKTRACK_MAX_BITS).
+
+  The bitmap, capture array and job stack live in a BitState, which a Matcher
+  keeps around so that searching the same input over and over doesn't allocate.
+
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+
+/*
+  A job is either a thread to try (pc, sp), or a capture slot to restore when
+  we backtrack past the Save that changed it.
+ */
+typedef struct job job;
+struct job {
+  size_t pc;    // instruction, or (size_t)-1 for a restore
+  size_t sp;    // string index, or old value of the slot
+  size_t slot;  // slot to restore
+};
+
+typedef struct job_stack job_stack;
+struct job_stack {
+  job *j;
+  size_t n;
+  size_t alloc;
+};
+
+static void push(job_stack *s, size_t pc, size_t sp, size_t slot)
+{
+  if (s->n >= s->alloc) {
+    s->alloc = s->alloc ? s->alloc * 2 : 64;
+    s->j = realloc(s->j, s->alloc * sizeof(job));
+  }
+  s->j[s->n++] = (job){.pc=pc, .sp=sp, .slot=slot};
+}
+
+/**
+   @brief Mark (pc, sp) as visited.
+   @returns True if it was already visited.
+ */
+static bool visit(uint32_t *visited, size_t len, size_t pc, size_t sp)
+{
+  size_t bit = pc * (len + 1) + sp;
+  uint32_t mask = (uint32_t)1 << (bit % 32);
+  if (visited[bit / 32] & mask) {
+    return true;
+  }
+  visited[bit / 32] |= mask;
+  return false;
+}
+
+/*
+  Everything the backtracker allocates, kept together so that it can be reused
+  from one run to the next.
+ */
+struct BitState {
+  uint32_t *visited;
+  size_t nwords;
+  size_t *caps;
+  job_stack stack;
+};
+
+/**
+   @brief Allocate backtracker state for a program.
+ */
+BitState *btnew(const Prog *p)
+{
+  BitState *bt = calloc(1, sizeof(BitState));
+  bt->caps = calloc(p->nsave, sizeof(size_t));
+  return bt;
+}
+
+/**
+   @brief Free backtracker state from btnew().
+ */
+void btfree(BitState *bt)
+{
+  free(bt->visited);
+  free(bt->caps);
+  free(bt->stack.j);
+  free(bt);
+}
+
+/**
+   @brief Return the captures from the last successful btrun().
+ */
+size_t *btcaps(BitState *bt)
+{
+  return bt->caps;
+}
+
+/**
+   @brief Run a packed program with the bounded backtracker, reusing its state.
+   @param bt State from btnew(), for the same program.
+   @param p The program.
+   @param input The input string.
+   @param len Length of the input string.
+   @param anchored True if the match must start at index 0.
+   @param[out] start Where to put the index the match starts at (may be NULL).
+   @returns Index the match ends at, or -1 if no match.  Captures are left in
+   btcaps(), and are only valid until the next run.
+ */
+ssize_t btrun(BitState *bt, const Prog *p, const struct Input input, size_t len,
+              bool anchored, size_t *start)
+{
+  size_t nwords = (p->n * (len + 1) + 31) / 32;
+  size_t *caps = bt->caps;
+  job_stack *stack = &bt->stack;
+  ssize_t match = -1;
+  size_t pc, sp, begin;
+
+  if (nwords > bt->nwords) {
+    free(bt->visited);
+    bt->visited = malloc(nwords * sizeof(uint32_t));
+    bt->nwords = nwords;
+  }
+  memset(bt->visited, 0, nwords * sizeof(uint32_t));
+  memset(caps, 0, p->nsave * sizeof(size_t));
+  stack->n = 0;
+
+  for (begin = 0; begin <= (anchored ? 0 : len) && match == -1; begin++) {
+    push(stack, 0, begin, 0);
+    while (stack->n > 0 && match == -1) {
+      job j = stack->j[--stack->n];
+      if (j.pc == (size_t)-1) {
+        caps[j.slot] = j.sp;
+        continue;
+      }
+      pc = j.pc;
+      sp = j.sp;
+
+      // Follow this thread until it fails or matches.
+      while (!visit(bt->visited, len, pc, sp)) {
+        PInstr in = p->code[pc];
+        wchar_t c = sp < len ? InputIdx(input, sp) : L'\0';
+
+        if (in.code == Char) {
+          if (c == L'\0' || c != (wchar_t) in.arg) {
+            break;
+          }
+          pc++;
+          sp++;
+        } else if (in.code == Any) {
+          if (c == L'\0') {
+            break;
+          }
+          pc++;
+          sp++;
+        } else if (in.code == Range || in.code == NRange) {
+          if (!inclass(p, in, c)) {
+            break;
+          }
+          pc++;
+          sp++;
+        } else if (in.code == Jump) {
+          pc += in.x;
+        } else if (in.code == Split) {
+          // The second branch is tried only once the first has failed.
+          push(stack, pc + in.arg, sp, 0);
+          pc += in.x;
+        } else if (in.code == Save) {
+          push(stack, (size_t)-1, caps[in.arg], in.arg);
+          caps[in.arg] = sp;
+          pc++;
+        } else {
+          // Match: threads are tried in priority order, so this is the one.
+          match = sp;
+          break;
+        }
+      }
+    }
+  }
+
+  if (match != -1 && start) {
+    *start = begin - 1;
+  }
+  return match;
+}
+
+/**
+   @brief Run a packed program with the bounded backtracker.
+   @param p The program.
+   @param input The input string.
+   @param len Length of the input string.
+   @param anchored True if the match must start at index 0.
+   @param[out] start Where to put the index the match starts at (may be NULL).
+   @param[out] saved Out pointer for captured indices (may be NULL).
+   @returns Index the match ends at, or -1 if no match.
+ */
+ssize_t backtrack(const Prog *p, const struct Input input, size_t len,
+                  bool anchored, size_t *start, size_t **saved)
+{
+  BitState *bt = btnew(p);
+  ssize_t match = btrun(bt, p, input, len, anchored, start);
+
+  if (saved) {
+    *saved = NULL;
+    if (match != -1) {
+      // Steal the captures, so that btfree() leaves them alone.
+      *saved = bt->caps;
+      bt->caps = NULL;
+    }
+  }
+  btfree(bt);
+  return match;
+}
@@ -0,0 +1,117 @@
+/***************************************************************************//**
+
+  @file         batch.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Matching one regex against many strings in parallel.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+  A packed program is never written to while it runs, so any number of threads
+  can share it.  All each thread needs is its own Matcher for scratch space.
+  Threads take inputs in chunks from a shared counter, so a thread that gets
+  some long strings doesn't hold up the rest.
+
+*******************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+
+/*
+  Number of inputs a thread claims at once.  Large enough that the lock is
+  rarely contended, small enough that the work stays balanced.
+ */
+#define BATCH_CHUNK 256
+
+/*
+  State shared by all of the workers.
+ */
+struct batch {
+  Regex r;
+  const char *const *inputs;
+  ssize_t *results;
+  size_t n;
+  size_t next;
+  pthread_mutex_t lock;
+};
+
+/**
+   @brief Claim the next chunk of inputs.
+   @returns Index of the first input in the chunk, or n if there are none left.
+ */
+static size_t claim(struct batch *b)
+{
+  pthread_mutex_lock(&b->lock);
+  size_t first = b->next;
+  b->next = first + BATCH_CHUNK < b->n ? first + BATCH_CHUNK : b->n;
+  pthread_mutex_unlock(&b->lock);
+  return first;
+}
+
+static void *worker(void *arg)
+{
+  struct batch *b = arg;
+  Matcher m;
+  size_t first, end;
+
+  reminit(&m, b->r);
+  while ((first = claim(b)) < b->n) {
+    end = first + BATCH_CHUNK < b->n ? first + BATCH_CHUNK : b->n;
+    for (size_t i = first; i < end; i++) {
+      b->results[i] = rematch(&m, b->inputs[i]);
+    }
+  }
+  remdestroy(&m);
+  return NULL;
+}
+
+void rebatch(Regex r, const char *const *inputs, size_t n, int nthreads,
+             ssize_t *results)
+{
+  struct batch b = {
+    .r=r, .inputs=inputs, .results=results, .n=n, .next=0,
+  };
+  pthread_t *threads;
+  int started;
+
+  if (nthreads <= 0) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    nthreads = ncpu > 0 ? (int) ncpu : 1;
+  }
+  if ((size_t) nthreads > (n + BATCH_CHUNK - 1) / BATCH_CHUNK) {
+    nthreads = (int) ((n + BATCH_CHUNK - 1) / BATCH_CHUNK);
+  }
+
+  // Pack the program here if need be, so that the threads share one copy.
+  if (!r.p) {
+    b.r.p = repack(r.i, r.n);
+  }
+  pthread_mutex_init(&b.lock, NULL);
+
+  // The calling thread is a worker too, and picks up whatever is left if some
+  // threads couldn't be created.
+  threads = calloc(nthreads > 1 ? nthreads - 1 : 1, sizeof(pthread_t));
+  for (started = 0; started < nthreads - 1; started++) {
+    if (pthread_create(&threads[started], NULL, worker, &b) != 0) {
+      break;
+    }
+  }
+  worker(&b);
+  for (int i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  free(threads);
+  pthread_mutex_destroy(&b.lock);
+  if (!r.p) {
+    progfree(b.r.p);
+  }
+}
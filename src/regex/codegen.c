@@ -26,6 +26,12 @@
   code, it will be turned into an array, and all the IDs will be resolved
   efficiently to locations in the final array using a table.
 
+  Fragment lists are passed around as Blocks, which remember their tail and
+  length.  Joining two Blocks deletes the Match at the end of the first one,
+  and rather than walking the list to retarget jumps to that Match, a
+  forwarding entry is recorded for its ID.  This keeps every join constant
+  time, so code generation is linear in the size of the regex.
+
 *******************************************************************************/
 
 #include <stdio.h>
@@ -44,75 +50,72 @@ struct Fragment {
   Fragment *next;
 };
 
+/*
+  A Block is a Fragment list, along with everything needed to append to it in
+  constant time.  Every Block ends with a single Match instruction (the tail),
+  which is where execution "falls out" of the Block.  The length is tracked so
+  that the final code size is known without walking the list.
+ */
+typedef struct Block Block;
+struct Block {
+  Fragment *head;   // first instruction
+  Fragment *tail;   // trailing Match instruction
+  Fragment *before; // instruction before the tail, or NULL
+  size_t len;
+};
+
 typedef struct State State;
 struct State {
   intptr_t id; // "global" id counter
   size_t capture; // capture parentheses counter
+  intptr_t *forward; // forward[id] is the id that replaced it (or itself)
+  size_t alloc; // allocated length of forward
 };
 
-static Fragment *last(Fragment *f)
+/**
+   @brief Look up the id that should be used in place of the given id.
+
+   When join() deletes a trailing Match, anything that targeted it should target
+   the start of the following Block instead.  Rather than walking the Block to
+   rewrite those targets, join() records a forwarding entry, and they are all
+   resolved here once code generation is finished.
+ */
+static intptr_t resolve(State *s, intptr_t id)
 {
-  while (f->next) {
-    f = f->next;
+  intptr_t root = id, next;
+  while (s->forward[root] != root) {
+    root = s->forward[root];
+  }
+  // Path compression, so that long chains of joins are only walked once.
+  while (s->forward[id] != root) {
+    next = s->forward[id];
+    s->forward[id] = root;
+    id = next;
   }
-  return f;
+  return root;
 }
 
 /**
-   @brief "Join" a fragment to the given ID.
+   @brief "Join" a block to the block after it.
 
-   This replaces each "match" instruction with a "jump" instruction to the given
-   ID.  Since it's assumed that the instruction with that ID will be placed
-   after this one, if the last instruction of this fragment is a "match", it
-   will just be deleted.
+   The trailing Match of the first block is deleted, and anything that jumped to
+   it is forwarded to the head of the second block.  This takes constant time,
+   regardless of the size of either block.
  */
-static void join(Fragment *a, Fragment *b)
+static Block join(State *s, Block a, Block b)
 {
-  Fragment *prev = NULL;
-  Fragment *l = last(a);
-  Instr *lastid;
-
-  // lastid will be set in case the last instruction is a Match, which will be
-  // deleted later.
-  if (l->in.code == Match) {
-    lastid = (Instr*) l->id;
-  } else {
-    lastid = (Instr*) -1;
-  }
+  assert(a.tail->in.code == Match && a.before != NULL);
 
-  while (a->next != NULL) {
-    // Matches should be replaced with jumps to the next fragment.
-    if (a->in.code == Match) {
-      a->in.code = Jump;
-      a->in.x = (Instr*)b->id;
-    }
-    // Jumps to the final match instruction should instead be targeted to the
-    // next fragment.
-    if ((a->in.code == Jump || a->in.code == Split) && a->in.x == lastid) {
-      a->in.x = (Instr*) b->id;
-    }
-    if (a->in.code == Split && a->in.y == lastid) {
-      a->in.y = (Instr*) b->id;
-    }
-    prev = a;
-    a = a->next;
-  }
-
-  // If the last Instruction is a Match, delete it.
-  if (prev != NULL && a->in.code == Match) {
-    free(a);
-    prev->next = b;
-  }
-}
+  s->forward[a.tail->id] = b.head->id;
+  a.before->next = b.head;
+  free(a.tail);
 
-static size_t fraglen(Fragment *f)
-{
-  size_t len = 0;
-  while (f) {
-    len++;
-    f = f->next;
+  if (b.before == NULL) {
+    // b is a lone Match, which now directly follows a.before.
+    b.before = a.before;
   }
-  return len;
+  return (Block){.head=a.head, .tail=b.tail, .before=b.before,
+                 .len=a.len + b.len - 1};
 }
 
 static Fragment *newfrag(enum code code, State *s)
@@ -120,9 +123,43 @@ static Fragment *newfrag(enum code code, State *s)
   Fragment *new = calloc(1, sizeof(Fragment));
   new->in.code = code;
   new->id = s->id++;
+  if ((size_t)new->id >= s->alloc) {
+    s->alloc = s->alloc ? s->alloc * 2 : 64;
+    s->forward = realloc(s->forward, s->alloc * sizeof(intptr_t));
+  }
+  s->forward[new->id] = new->id;
   return new;
 }
 
+/**
+   @brief Make a block out of a lone Match instruction.
+ */
+static Block matchblock(State *s)
+{
+  Fragment *m = newfrag(Match, s);
+  return (Block){.head=m, .tail=m, .before=NULL, .len=1};
+}
+
+/**
+   @brief Put an instruction in front of a block.
+ */
+static Block prepend(Fragment *f, Block b)
+{
+  f->next = b.head;
+  if (b.before == NULL) {
+    b.before = f;
+  }
+  return (Block){.head=f, .tail=b.tail, .before=b.before, .len=b.len + 1};
+}
+
+/**
+   @brief Make a block out of a single instruction followed by a Match.
+ */
+static Block single(Fragment *f, State *s)
+{
+  return prepend(f, matchblock(s));
+}
+
 static void freefraglist(Fragment *f)
 {
   Fragment *next;
@@ -133,13 +170,13 @@ static void freefraglist(Fragment *f)
   }
 }
 
-static Fragment *regex(PTree *t, State *s);
-static Fragment *term(PTree *t, State *s);
-static Fragment *expr(PTree *t, State *s);
-static Fragment *class(PTree *t, State *s, bool is_negative);
-static Fragment *sub(PTree *t, State *s);
+static Block regex(PTree *t, State *s);
+static Block term(PTree *t, State *s);
+static Block expr(PTree *t, State *s);
+static Block class(PTree *t, State *s, bool is_negative);
+static Block sub(PTree *t, State *s);
 
-static Fragment *special(char type, State *s)
+static Block special(char type, State *s)
 {
   Fragment *f;
 
@@ -175,13 +212,13 @@ static Fragment *special(char type, State *s)
     break;
   }
 
-  f->next = newfrag(Match, s);
-  return f;
+  return single(f, s);
 }
 
-static Fragment *term(PTree *t, State *s)
+static Block term(PTree *t, State *s)
 {
-  Fragment *f = NULL;
+  Block b = {0};
+  Fragment *f;
 
   assert(t->nt == TERMnt);
 
@@ -191,35 +228,34 @@ static Fragment *term(PTree *t, State *s)
       // Character
       f = newfrag(Char, s);
       f->in.c = t->children[0]->tok.c;
-      f->next = newfrag(Match, s);
+      b = single(f, s);
     } else if (t->children[0]->tok.sym == Dot) {
       // Dot
-      f = newfrag(Any, s);
-      f->next = newfrag(Match, s);
+      b = single(newfrag(Any, s), s);
     } else if (t->children[0]->tok.sym == Special) {
       // Special
-      f = special(t->children[0]->tok.c, s);
+      b = special(t->children[0]->tok.c, s);
     }
   } else if (t->production == 2) {
     // Parenthesized expression
     f = newfrag(Save, s);
     f->in.s = s->capture++;
     size_t nextsave = s->capture++;
-    f->next = regex(t->children[1], s);
+    b = prepend(f, regex(t->children[1], s));
     Fragment *n = newfrag(Save, s);
     n->in.s = nextsave;
-    n->next = newfrag(Match, s);
-    join(f, n);
+    b = join(s, b, single(n, s));
   } else {
     // Character class
-    f = class(t->children[1], s, (t->production == 4));
+    b = class(t->children[1], s, (t->production == 4));
   }
-  return f;
+  return b;
 }
 
-static Fragment *expr(PTree *t, State *s)
+static Block expr(PTree *t, State *s)
 {
-  Fragment *f = NULL, *a = NULL, *b = NULL, *c = NULL;
+  Block f, c;
+  Fragment *a = NULL, *b = NULL;
 
   assert(t->nt == EXPRnt);
 
@@ -239,21 +275,18 @@ static Fragment *expr(PTree *t, State *s)
        */
       a = newfrag(Split, s);
       b = newfrag(Jump, s);
-      c = newfrag(Match, s);
+      c = matchblock(s);
       if (t->nchildren == 3) {
         // Non-greedy
-        a->in.x = (Instr*) c->id;
-        a->in.y = (Instr*) f->id;
+        a->in.x = (Instr*) c.head->id;
+        a->in.y = (Instr*) f.head->id;
       } else {
         // Greedy
-        a->in.x = (Instr*) f->id;
-        a->in.y = (Instr*) c->id;
+        a->in.x = (Instr*) f.head->id;
+        a->in.y = (Instr*) c.head->id;
       }
       b->in.x = (Instr*) a->id;
-      a->next = f;
-      b->next = c;
-      join(a, b);
-      return a;
+      return join(s, prepend(a, f), prepend(b, c));
     } else if (t->children[1]->tok.sym == Plus) {
       /*
         L1:
@@ -263,19 +296,17 @@ static Fragment *expr(PTree *t, State *s)
             match         ;; this is "b"
        */
       a = newfrag(Split, s);
-      b = newfrag(Match, s);
+      c = matchblock(s);
       if (t->nchildren == 3) {
         // Non-greedy
-        a->in.x = (Instr*) b->id;
-        a->in.y = (Instr*) f->id;
+        a->in.x = (Instr*) c.head->id;
+        a->in.y = (Instr*) f.head->id;
       } else {
         // Greedy
-        a->in.x = (Instr*) f->id;
-        a->in.y = (Instr*) b->id;
+        a->in.x = (Instr*) f.head->id;
+        a->in.y = (Instr*) c.head->id;
       }
-      join(f, a);
-      a->next = b;
-      return f;
+      return join(s, f, prepend(a, c));
     } else if (t->children[1]->tok.sym == Question) {
       /*
             split L1 L2   ;; this is "a"  [ non-greedy: split L2 L1 ]
@@ -285,44 +316,46 @@ static Fragment *expr(PTree *t, State *s)
             match         ;; this is "b"
        */
       a = newfrag(Split, s);
-      b = newfrag(Match, s);
+      c = matchblock(s);
       if (t->nchildren == 3) {
         // Non-greedy
-        a->in.x = (Instr*) b->id;
-        a->in.y = (Instr*) f->id;
+        a->in.x = (Instr*) c.head->id;
+        a->in.y = (Instr*) f.head->id;
       } else {
         // Greedy
-        a->in.x = (Instr*) f->id;
-        a->in.y = (Instr*) b->id;
+        a->in.x = (Instr*) f.head->id;
+        a->in.y = (Instr*) c.head->id;
       }
-      a->next = f;
-      join(f, b);
-      return a;
+      return prepend(a, join(s, f, c));
     } else {
       assert(false);
+      return f;
     }
   }
 }
 
-static Fragment *sub(PTree *tree, State *state)
+static Block sub(PTree *tree, State *state)
 {
+  /*
+    BLOCK from e
+    BLOCK from s
+   */
+  // SUB is a right-recursive list of EXPRs, so walk it iteratively, to avoid
+  // recursing once per term of a long concatenation.
   assert(tree->nt == SUBnt);
-  Fragment *e = expr(tree->children[0], state);
-  if (tree->nchildren == 2) {
-    /*
-      BLOCK from e
-      BLOCK from s
-     */
-    Fragment *s = sub(tree->children[1], state);
-    join(e, s);
+  Block b = expr(tree->children[0], state);
+  while (tree->nchildren == 2) {
+    tree = tree->children[1];
+    assert(tree->nt == SUBnt);
+    b = join(state, b, expr(tree->children[0], state));
   }
-  return e;
+  return b;
 }
 
-static Fragment *regex(PTree *tree, State *state)
+static Block regex(PTree *tree, State *state)
 {
   assert(tree->nt == REGEXnt);
-  Fragment *s = sub(tree->children[0], state);
+  Block s = sub(tree->children[0], state);
   if (tree->nchildren == 3) {
     /*
           split L1 L2     ;; this is "pre"
@@ -335,26 +368,22 @@ static Fragment *regex(PTree *tree, State *state)
           match           ;; this is "m"
      */
 
-    Fragment *r = regex(tree->children[2], state);
+    Block r = regex(tree->children[2], state);
 
     Fragment *pre = newfrag(Split, state);
-    pre->in.x = (Instr*) s->id;
-    pre->in.y = (Instr*) r->id;
-    pre->next = s;
+    pre->in.x = (Instr*) s.head->id;
+    pre->in.y = (Instr*) r.head->id;
 
-    Fragment *m = newfrag(Match, state);
+    Block m = matchblock(state);
     Fragment *j = newfrag(Jump, state);
-    j->in.x = (Instr*) m->id;
-    j->next = r;
-    join(j, m);
-    join(pre, j);
-
-    return pre;
+    j->in.x = (Instr*) m.head->id;
+    Block jb = join(state, prepend(j, r), m);
+    return join(state, prepend(pre, s), jb);
   }
   return s;
 }
 
-static Fragment *class(PTree *tree, State *state, bool is_negative)
+static Block class(PTree *tree, State *state, bool is_negative)
 {
   size_t nranges = 0;
   PTree *curr;
@@ -390,19 +419,17 @@ static Fragment *class(PTree *tree, State *state, bool is_negative)
     nranges++;
   }
 
-  f->next = newfrag(Match, state);
-  return f;
+  return single(f, state);
 }
 
 Regex codegen(PTree *tree)
 {
   // Generate code.
-  State s = {0, 0};
-  Fragment *f = regex(tree, &s);
-  size_t n;
+  State s = {0, 0, NULL, 0};
+  Block b = regex(tree, &s);
 
-  // Get the length of the code
-  n = fraglen(f);
+  // The length of the code was tracked while generating it.
+  size_t n = b.len;
 
   // Allocate buffers for the code, and for a lookup table of targets for jumps.
   Instr *code = calloc(n, sizeof(Instr));
@@ -411,22 +438,24 @@ Regex codegen(PTree *tree)
   // Fill up the lookup table.
   size_t i = 0;
   Fragment *curr;
-  for (curr = f; curr; curr = curr->next, i++) {
+  for (curr = b.head; curr; curr = curr->next, i++) {
     targets[curr->id] = i;
   }
 
   // Now, copy in the Instructions, replacing the jump targets from the table.
-  for (curr = f, i = 0; curr; curr = curr->next, i++) {
+  // Targets may refer to deleted Match instructions, so resolve them first.
+  for (curr = b.head, i = 0; curr; curr = curr->next, i++) {
     code[i] = curr->in;
     if (code[i].code == Jump || code[i].code == Split) {
-      code[i].x = code + targets[(intptr_t)code[i].x];
+      code[i].x = code + targets[resolve(&s, (intptr_t)code[i].x)];
     }
     if (code[i].code == Split) {
-      code[i].y = code + targets[(intptr_t)code[i].y];
+      code[i].y = code + targets[resolve(&s, (intptr_t)code[i].y)];
     }
   }
 
   free(targets);
-  freefraglist(f);
-  return (Regex){.n=n, .i=code};
+  free(s.forward);
+  freefraglist(b.head);
+  return (Regex){.n=n, .i=code, .p=repack(code, n)};
 }
@@ -182,7 +182,7 @@ static Instr read_instr(char *line, int lineno)
   // buffer.  We know we don't need more than like TODO
   size_t ntok;
   char **tokens = tokenize(line, &ntok);
-  Instr inst = {.code=0, .c=0, .s=0, .x=NULL, .y=NULL, .lastidx=0};
+  Instr inst = {.code=0, .c=0, .s=0, .x=NULL, .y=NULL};
 
   if (strcmp(tokens[0], Opcodes[Char]) == 0) {
     if (ntok != 2) {
@@ -353,7 +353,7 @@ Regex reread(char *str)
   free(lines);
   free(labels);
   free(labelindices);
-  return (Regex){.n=codeidx, .i=rv};
+  return (Regex){.n=codeidx, .i=rv, .p=repack(rv, codeidx)};
 }
 
 /**
@@ -449,6 +449,132 @@ void rewrite(Regex r, FILE *f)
   free(labels);
 }
 
+/**
+   @brief Write the range block of an instruction as a C initializer.
+ */
+static void writeblock(const char *block, size_t n, FILE *f)
+{
+  fprintf(f, "{");
+  for (size_t i = 0; i < n; i++) {
+    fprintf(f, "%s%d", i ? ", " : "", block[i]);
+  }
+  fprintf(f, "}");
+}
+
+/**
+   @brief Write a program as a C translation unit.
+ */
+void rewritec(Regex r, const char *name, FILE *f)
+{
+  static const char *codes[] = {
+    "Char", "Match", "Jump", "Split", "Save", "Any", "Range", "NRange"
+  };
+  Prog *p = r.p ? r.p : repack(r.i, r.n);
+  size_t nclasses = 0, nranges = 0;
+
+  fprintf(f, "/*\n");
+  fprintf(f, "  Generated by rewritec(), do not edit.\n\n");
+  fprintf(f, "  Declare this regex wherever you use it with:\n");
+  fprintf(f, "      extern const Regex %s;\n", name);
+  fprintf(f, "  It is static data, so it must not be passed to refree().\n");
+  fprintf(f, " */\n\n");
+  fprintf(f, "#include \"libstephen/re.h\"\n");
+  fprintf(f, "#include \"libstephen/re_internals.h\"\n\n");
+
+  // Range blocks for the unpacked instructions.
+  for (size_t i = 0; i < r.n; i++) {
+    if (r.i[i].code == Range || r.i[i].code == NRange) {
+      fprintf(f, "static char %s_block%zu[] = ", name, i);
+      writeblock((char *) r.i[i].x, 2 * r.i[i].s, f);
+      fprintf(f, ";\n");
+    }
+  }
+
+  // Unpacked instructions, so that rewrite() and friends still work.
+  fprintf(f, "\nstatic Instr %s_instr[] = {\n", name);
+  for (size_t i = 0; i < r.n; i++) {
+    fprintf(f, "  {.code=%s", codes[r.i[i].code]);
+    switch (r.i[i].code) {
+    case Char:
+      fprintf(f, ", .c=%ld", (long) r.i[i].c);
+      break;
+    case Jump:
+      fprintf(f, ", .x=%s_instr + %td", name, r.i[i].x - r.i);
+      break;
+    case Split:
+      fprintf(f, ", .x=%s_instr + %td, .y=%s_instr + %td", name,
+              r.i[i].x - r.i, name, r.i[i].y - r.i);
+      break;
+    case Save:
+      fprintf(f, ", .s=%zu", r.i[i].s);
+      break;
+    case Range:
+    case NRange:
+      fprintf(f, ", .s=%zu, .x=(Instr *) %s_block%zu", r.i[i].s, name, i);
+      nclasses++;
+      nranges += r.i[i].s;
+      break;
+    case Match:
+    case Any:
+      break;
+    }
+    fprintf(f, "},\n");
+  }
+  fprintf(f, "};\n\n");
+
+  // Packed instructions and their tables, which are what actually run.
+  fprintf(f, "static const PInstr %s_code[] = {\n", name);
+  for (size_t i = 0; i < p->n; i++) {
+    fprintf(f, "  {.code=%s, .x=%d, .arg=%ld},\n", codes[p->code[i].code],
+            (int) p->code[i].x, (long) p->code[i].arg);
+  }
+  fprintf(f, "};\n\n");
+
+  if (nclasses > 0) {
+    fprintf(f, "static const PClass %s_classes[] = {\n", name);
+    for (size_t i = 0; i < nclasses; i++) {
+      fprintf(f, "  {.bits={");
+      for (size_t j = 0; j < nelem(p->classes[i].bits); j++) {
+        fprintf(f, "%s0x%08lx", j ? ", " : "",
+                (unsigned long) p->classes[i].bits[j]);
+      }
+      fprintf(f, "}, .start=%zu, .n=%zu},\n", p->classes[i].start,
+              p->classes[i].n);
+    }
+    fprintf(f, "};\n\n");
+    fprintf(f, "static const char %s_ranges[] = ", name);
+    writeblock(p->ranges, 2 * nranges, f);
+    fprintf(f, ";\n\n");
+  }
+
+  if (p->nlit > 0) {
+    size_t litsize = 0;
+    for (size_t i = 0; i < p->nlit; i++) {
+      litsize += strlen(p->lits + litsize) + 1;
+    }
+    fprintf(f, "static const char %s_lits[] = ", name);
+    writeblock(p->lits, litsize, f);
+    fprintf(f, ";\n\n");
+  }
+
+  fprintf(f, "static const Prog %s_prog = {\n", name);
+  fprintf(f, "  .n=%zu, .nsave=%zu, .code=%s_code,\n", p->n, p->nsave, name);
+  if (nclasses > 0) {
+    fprintf(f, "  .classes=%s_classes, .ranges=%s_ranges,\n", name, name);
+  }
+  if (p->nlit > 0) {
+    fprintf(f, "  .nlit=%zu, .lits=%s_lits,\n", p->nlit, name);
+  }
+  fprintf(f, "};\n\n");
+
+  fprintf(f, "const Regex %s = {.n=%zu, .i=%s_instr, .p=(Prog *) &%s_prog};\n",
+          name, r.n, name, name);
+
+  if (p != r.p) {
+    progfree(p);
+  }
+}
+
 void refree(Regex r)
 {
   for (size_t i = 0; i < r.n; i++) {
@@ -457,4 +583,5 @@ void refree(Regex r)
     }
   }
   free(r.i);
+  progfree(r.p);
 }
@@ -0,0 +1,478 @@
+/***************************************************************************//**
+
+  @file         jit.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Compiling packed programs to x86-64 machine code.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+  This is the backtracker from backtrack.c, with the interpreter loop unrolled
+  into native code.  Every instruction becomes a block of machine code, which
+  first marks its (instruction, string index) pair in the visited bitmap, and
+  then does the instruction's work.  So a Jump is a jmp, a Char is a compare
+  against an immediate, and a class is a bit test in a table right after the
+  code (already negated for NRange).  The program counter is the instruction
+  pointer, and there's no dispatch at all.
+
+  The job stack holds pairs of (code address, value).  A Split pushes the
+  address of a small stub that loads the string index and jumps to the second
+  branch, and a Save pushes the address of a stub that puts the old value back
+  in its slot.  Backtracking is then just popping a pair and jumping to it.
+  Since each (instruction, index) pair is visited at most once, and only Split
+  and Save push, the stack is allocated up front and never checked.
+
+  Only narrow strings are compiled for.  Wide strings, long inputs, and other
+  architectures use the interpreters.  Generated code is written to an
+  anonymous mapping, which is made executable (and read only) before it runs;
+  if the system refuses that, jitnew() returns NULL, and the interpreters are
+  used instead.
+
+*******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+
+#ifdef SMB_RE_JIT
+
+#include <limits.h>
+#include <sys/mman.h>
+
+/*
+  Arguments to the generated code, which loads them into registers.  The
+  offsets are baked into the prologue.
+ */
+typedef struct jitargs jitargs;
+struct jitargs {
+  const char *str;    // 0: rbx
+  size_t len;         // 8: r13
+  uint32_t *visited;  // 16: r14
+  size_t *caps;       // 24: r15
+  void *jobs;         // 32: rbp, and [rsp]
+  size_t begin;       // 40: r12
+};
+
+typedef ssize_t (*jitfunc)(jitargs *args);
+
+/*
+  A job on the stack: where to jump, and a string index or an old slot value,
+  which is passed in rax.
+ */
+#define JOB_SIZE 16
+
+/*
+  Everything the generated code needs, kept together so that it can be reused
+  from one run to the next, like a BitState.
+ */
+struct Jit {
+  void *code;
+  size_t size;
+  size_t n;         // number of instructions
+  size_t nsave;     // number of capture slots
+  size_t npush;     // number of instructions that push a job
+  uint32_t *visited;
+  size_t nwords;
+  void *jobs;
+  size_t njobs;
+  size_t *caps;
+};
+
+/*
+  Things a rel32 operand can refer to.  Every instruction with one has it as
+  its last four bytes, so they're all resolved the same way.
+ */
+enum target {
+  T_BLOCK,    // the code for an instruction
+  T_RESUME,   // the stub that resumes a Split's second branch
+  T_RESTORE,  // the stub that restores a Save's slot
+  T_TABLE,    // the bitmap for a Range or NRange
+  T_BACKTRACK,
+  T_RETURN,
+};
+
+typedef struct fixup fixup;
+struct fixup {
+  size_t at;         // offset of the rel32
+  enum target kind;
+  size_t pc;
+};
+
+typedef struct emitter emitter;
+struct emitter {
+  unsigned char *buf;
+  size_t len;
+  size_t alloc;
+  fixup *fix;
+  size_t nfix;
+  size_t allocfix;
+  size_t *labels[4];  // offsets, by pc, for each per-instruction target
+  size_t backtrack;
+  size_t ret;
+};
+
+static void emit(emitter *e, const char *bytes, size_t n)
+{
+  if (e->len + n > e->alloc) {
+    e->alloc = e->alloc ? e->alloc * 2 : 4096;
+    e->buf = realloc(e->buf, e->alloc);
+  }
+  memcpy(e->buf + e->len, bytes, n);
+  e->len += n;
+}
+
+static void emit32(emitter *e, int32_t value)
+{
+  emit(e, (const char *) &value, 4);
+}
+
+/**
+   @brief Emit a rel32 operand, to be filled in once the target is placed.
+ */
+static void emitrel(emitter *e, enum target kind, size_t pc)
+{
+  if (e->nfix >= e->allocfix) {
+    e->allocfix = e->allocfix ? e->allocfix * 2 : 64;
+    e->fix = realloc(e->fix, e->allocfix * sizeof(fixup));
+  }
+  e->fix[e->nfix++] = (fixup){.at=e->len, .kind=kind, .pc=pc};
+  emit32(e, 0);
+}
+
+#define EMIT(e, s) emit(e, s, sizeof(s) - 1)
+
+/**
+   @brief Mark (pc, r12) visited, or backtrack if it already was.
+
+   The bit is r12 * n + pc, so that the only runtime multiply is by a constant.
+ */
+static void emitvisit(emitter *e, size_t n, size_t pc)
+{
+  EMIT(e, "\x49\x69\xc4");       // imul rax, r12, n
+  emit32(e, (int32_t) n);
+  EMIT(e, "\x48\x05");           // add rax, pc
+  emit32(e, (int32_t) pc);
+  EMIT(e, "\x48\x89\xc1"         // mov rcx, rax
+          "\x48\xc1\xe9\x05"     // shr rcx, 5
+          "\x41\x8b\x14\x8e"     // mov edx, [r14 + rcx*4]
+          "\x0f\xa3\xc2"         // bt edx, eax
+          "\x0f\x82");           // jc backtrack
+  emitrel(e, T_BACKTRACK, 0);
+  EMIT(e, "\x0f\xab\xc2"         // bts edx, eax
+          "\x41\x89\x14\x8e");   // mov [r14 + rcx*4], edx
+}
+
+/**
+   @brief Backtrack unless there's a character left at r12.
+ */
+static void emitavail(emitter *e)
+{
+  EMIT(e, "\x4d\x39\xec"         // cmp r12, r13
+          "\x0f\x83");           // jae backtrack
+  emitrel(e, T_BACKTRACK, 0);
+}
+
+static void emitjump(emitter *e, enum target kind, size_t pc)
+{
+  EMIT(e, "\xe9");               // jmp rel32
+  emitrel(e, kind, pc);
+}
+
+/**
+   @brief Push a job: the address of a stub, and a value in rax.
+ */
+static void emitpush(emitter *e, enum target kind, size_t pc)
+{
+  EMIT(e, "\x48\x8d\x0d");       // lea rcx, [rip + stub]
+  emitrel(e, kind, pc);
+  EMIT(e, "\x48\x89\x4d\x00"     // mov [rbp], rcx
+          "\x48\x89\x45\x08"     // mov [rbp + 8], rax
+          "\x48\x83\xc5\x10");   // add rbp, 16
+}
+
+static void emitinstr(emitter *e, const Prog *p, size_t pc)
+{
+  PInstr in = p->code[pc];
+
+  emitvisit(e, p->n, pc);
+  switch (in.code) {
+  case Char:
+    // Narrow input can only ever match a nonzero char.
+    if (in.arg == 0 || in.arg < CHAR_MIN || in.arg > CHAR_MAX) {
+      emitjump(e, T_BACKTRACK, 0);
+      break;
+    }
+    emitavail(e);
+    EMIT(e, "\x42\x0f\xbe\x04\x23" // movsx eax, byte [rbx + r12]
+            "\x3d");               // cmp eax, arg
+    emit32(e, in.arg);
+    EMIT(e, "\x0f\x85");           // jne backtrack
+    emitrel(e, T_BACKTRACK, 0);
+    EMIT(e, "\x49\xff\xc4");       // inc r12
+    break;
+  case Any:
+    emitavail(e);
+    EMIT(e, "\x49\xff\xc4");       // inc r12
+    break;
+  case Range:
+  case NRange:
+    emitavail(e);
+    EMIT(e, "\x42\x0f\xb6\x04\x23" // movzx eax, byte [rbx + r12]
+            "\x48\x8d\x15");       // lea rdx, [rip + table]
+    emitrel(e, T_TABLE, pc);
+    EMIT(e, "\x89\xc1"             // mov ecx, eax
+            "\xc1\xe9\x05"         // shr ecx, 5
+            "\x8b\x14\x8a"         // mov edx, [rdx + rcx*4]
+            "\x0f\xa3\xc2"         // bt edx, eax
+            "\x0f\x83");           // jnc backtrack
+    emitrel(e, T_BACKTRACK, 0);
+    EMIT(e, "\x49\xff\xc4");       // inc r12
+    break;
+  case Jump:
+    if (in.x != 1) {
+      emitjump(e, T_BLOCK, pc + in.x);
+    }
+    break;
+  case Split:
+    // The second branch is tried only once the first has failed.
+    EMIT(e, "\x4c\x89\xe0");       // mov rax, r12
+    emitpush(e, T_RESUME, pc);
+    if (in.x != 1) {
+      emitjump(e, T_BLOCK, pc + in.x);
+    }
+    break;
+  case Save:
+    EMIT(e, "\x49\x8b\x87");       // mov rax, [r15 + 8*slot]
+    emit32(e, 8 * in.arg);
+    emitpush(e, T_RESTORE, pc);
+    EMIT(e, "\x4d\x89\xa7");       // mov [r15 + 8*slot], r12
+    emit32(e, 8 * in.arg);
+    break;
+  case Match:
+    EMIT(e, "\x4c\x89\xe0");       // mov rax, r12
+    emitjump(e, T_RETURN, 0);
+    break;
+  }
+}
+
+/**
+   @brief Generate the code for a program into the emitter's buffer.
+ */
+static void generate(emitter *e, const Prog *p)
+{
+  size_t pc;
+
+  // Save callee-saved registers, keeping the stack 16 byte aligned, and
+  // remember where the job stack starts, so we know when it's empty.
+  EMIT(e, "\x53\x55\x41\x54\x41\x55\x41\x56\x41\x57" // push rbx ... r15
+          "\x48\x83\xec\x08"     // sub rsp, 8
+          "\x48\x8b\x1f"         // mov rbx, [rdi]
+          "\x4c\x8b\x6f\x08"     // mov r13, [rdi + 8]
+          "\x4c\x8b\x77\x10"     // mov r14, [rdi + 16]
+          "\x4c\x8b\x7f\x18"     // mov r15, [rdi + 24]
+          "\x48\x8b\x6f\x20"     // mov rbp, [rdi + 32]
+          "\x4c\x8b\x67\x28"     // mov r12, [rdi + 40]
+          "\x48\x89\x2c\x24");   // mov [rsp], rbp
+
+  for (pc = 0; pc < p->n; pc++) {
+    e->labels[T_BLOCK][pc] = e->len;
+    emitinstr(e, p, pc);
+  }
+
+  // Falling off the end of the program fails, like a thread with no match.
+  // Otherwise, pop a job and jump to its stub, with its value in rax.
+  e->backtrack = e->len;
+  EMIT(e, "\x48\x3b\x2c\x24"     // cmp rbp, [rsp]
+          "\x74\x0b"             // je fail
+          "\x48\x83\xed\x10"     // sub rbp, 16
+          "\x48\x8b\x45\x08"     // mov rax, [rbp + 8]
+          "\xff\x65\x00"         // jmp [rbp]
+          "\x48\xc7\xc0\xff\xff\xff\xff"); // fail: mov rax, -1
+  e->ret = e->len;
+  EMIT(e, "\x48\x83\xc4\x08"     // add rsp, 8
+          "\x41\x5f\x41\x5e\x41\x5d\x41\x5c\x5d\x5b" // pop r15 ... rbx
+          "\xc3");               // ret
+
+  for (pc = 0; pc < p->n; pc++) {
+    PInstr in = p->code[pc];
+    if (in.code == Split) {
+      e->labels[T_RESUME][pc] = e->len;
+      EMIT(e, "\x49\x89\xc4");   // mov r12, rax
+      emitjump(e, T_BLOCK, pc + in.arg);
+    } else if (in.code == Save) {
+      e->labels[T_RESTORE][pc] = e->len;
+      EMIT(e, "\x49\x89\x87");   // mov [r15 + 8*slot], rax
+      emit32(e, 8 * in.arg);
+      emitjump(e, T_BACKTRACK, 0);
+    }
+  }
+
+  // Class tables, with NRange's negated, so that both are one bit test.
+  while (e->len % 4 != 0) {
+    EMIT(e, "\xcc");             // int3
+  }
+  for (pc = 0; pc < p->n; pc++) {
+    PInstr in = p->code[pc];
+    if (in.code == Range || in.code == NRange) {
+      e->labels[T_TABLE][pc] = e->len;
+      for (int i = 0; i < 8; i++) {
+        uint32_t bits = p->classes[in.arg].bits[i];
+        emit32(e, (int32_t) (in.code == Range ? bits : ~bits));
+      }
+    }
+  }
+
+  for (size_t i = 0; i < e->nfix; i++) {
+    fixup f = e->fix[i];
+    size_t to;
+    if (f.kind == T_BACKTRACK) {
+      to = e->backtrack;
+    } else if (f.kind == T_RETURN) {
+      to = e->ret;
+    } else {
+      to = e->labels[f.kind][f.pc];
+    }
+    int32_t rel = (int32_t) ((ptrdiff_t) to - (ptrdiff_t) (f.at + 4));
+    memcpy(e->buf + f.at, &rel, 4);
+  }
+}
+
+Jit *jitnew(const Prog *p)
+{
+  emitter e = {0};
+  Jit *j;
+  void *code;
+
+  // The visited bit index is computed with a 32 bit immediate.
+  if (p->n == 0 || p->n > INT32_MAX / 2) {
+    return NULL;
+  }
+
+  for (int k = 0; k < 4; k++) {
+    e.labels[k] = calloc(p->n, sizeof(size_t));
+  }
+  generate(&e, p);
+  for (int k = 0; k < 4; k++) {
+    free(e.labels[k]);
+  }
+  free(e.fix);
+
+  code = mmap(NULL, e.len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+              -1, 0);
+  if (code == MAP_FAILED) {
+    free(e.buf);
+    return NULL;
+  }
+  memcpy(code, e.buf, e.len);
+  free(e.buf);
+  if (mprotect(code, e.len, PROT_READ | PROT_EXEC) != 0) {
+    munmap(code, e.len);
+    return NULL;
+  }
+
+  j = calloc(1, sizeof(Jit));
+  j->code = code;
+  j->size = e.len;
+  j->n = p->n;
+  j->nsave = p->nsave;
+  for (size_t pc = 0; pc < p->n; pc++) {
+    if (p->code[pc].code == Split || p->code[pc].code == Save) {
+      j->npush++;
+    }
+  }
+  j->caps = calloc(p->nsave ? p->nsave : 1, sizeof(size_t));
+  return j;
+}
+
+void jitfree(Jit *j)
+{
+  if (j) {
+    munmap(j->code, j->size);
+    free(j->visited);
+    free(j->jobs);
+    free(j->caps);
+    free(j);
+  }
+}
+
+ssize_t jitrun(Jit *j, const char *input, size_t len, bool anchored,
+               size_t *start)
+{
+  size_t nwords = (j->n * (len + 1) + 31) / 32;
+  size_t njobs = j->npush * (len + 1);
+  jitfunc run = (jitfunc) j->code;
+  jitargs args;
+  ssize_t match = -1;
+  size_t begin;
+
+  if (nwords > j->nwords) {
+    free(j->visited);
+    j->visited = malloc(nwords * sizeof(uint32_t));
+    j->nwords = nwords;
+  }
+  if (njobs > j->njobs) {
+    free(j->jobs);
+    j->jobs = malloc(njobs * JOB_SIZE);
+    j->njobs = njobs;
+  }
+  memset(j->visited, 0, nwords * sizeof(uint32_t));
+  memset(j->caps, 0, j->nsave * sizeof(size_t));
+
+  args.str = input;
+  args.len = len;
+  args.visited = j->visited;
+  args.caps = j->caps;
+  args.jobs = j->jobs;
+
+  // Like btrun(), the visited bitmap is shared by every starting index.
+  for (begin = 0; begin <= (anchored ? 0 : len) && match == -1; begin++) {
+    args.begin = begin;
+    match = run(&args);
+  }
+
+  if (match != -1 && start) {
+    *start = begin - 1;
+  }
+  return match;
+}
+
+size_t *jitcaps(Jit *j)
+{
+  return j->caps;
+}
+
+#else // SMB_RE_JIT
+
+Jit *jitnew(const Prog *p)
+{
+  (void) p; // unused
+  return NULL;
+}
+
+void jitfree(Jit *j)
+{
+  (void) j; // unused, and always NULL
+}
+
+ssize_t jitrun(Jit *j, const char *input, size_t len, bool anchored,
+               size_t *start)
+{
+  (void) j; (void) input; (void) len; (void) anchored; (void) start;
+  return -1;
+}
+
+size_t *jitcaps(Jit *j)
+{
+  (void) j; // unused
+  return NULL;
+}
+
+#endif // SMB_RE_JIT
@@ -0,0 +1,194 @@
+/***************************************************************************//**
+
+  @file         literal.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Fast path for regexes that only match literal strings.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+  A lot of regexes have no metacharacters at all, or are just a few literals
+  separated by pipes.  Running them on the VM costs a dispatch per instruction
+  per character, when a plain string comparison would do.  So, when a program
+  is packed, we check whether every path through it is a straight line of Char
+  instructions ending in a Match.  If so, the literals are saved in the
+  program, in priority order, and narrow strings are matched with strncmp(),
+  or searched for with memchr() (which libc vectorizes) on the first byte,
+  filtered on the last byte before comparing the rest.
+
+*******************************************************************************/
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+
+/*
+  Beyond this many literals, checking each one in turn is no longer clearly
+  faster than the VM, which tries them all at once.
+ */
+#define LIT_MAX 16
+
+struct lits {
+  char *buf;
+  size_t len;
+  size_t alloc;
+  size_t n;
+};
+
+/**
+   @brief Collect the literals along every path starting at an instruction.
+   @param code The instructions.
+   @param pc Instruction to start at.
+   @param path Characters matched before reaching pc.
+   @param plen Number of characters in path.
+   @param l Literals found so far.
+   @returns False if some path isn't a literal.
+ */
+static bool walk(const Instr *code, size_t pc, char *path, size_t plen,
+                 struct lits *l)
+{
+  for (;;) {
+    const Instr *in = code + pc;
+    switch (in->code) {
+    case Char:
+      if (in->c == L'\0' || in->c < CHAR_MIN || in->c > CHAR_MAX) {
+        return false;
+      }
+      path[plen++] = (char) in->c;
+      pc++;
+      break;
+    case Split:
+      // Only forward jumps are allowed, so there are no loops, and every path
+      // is at most as long as the program.
+      if (in->x <= in || in->y <= in ||
+          !walk(code, in->x - code, path, plen, l)) {
+        return false;
+      }
+      pc = in->y - code;
+      break;
+    case Jump:
+      if (in->x <= in) {
+        return false;
+      }
+      pc = in->x - code;
+      break;
+    case Match:
+      if (++l->n > LIT_MAX) {
+        return false;
+      }
+      if (l->len + plen + 1 > l->alloc) {
+        l->alloc = 2 * (l->len + plen + 1);
+        l->buf = realloc(l->buf, l->alloc);
+      }
+      memcpy(l->buf + l->len, path, plen);
+      l->buf[l->len + plen] = '\0';
+      l->len += plen + 1;
+      return true;
+    default:
+      return false;
+    }
+  }
+}
+
+/**
+   @brief Find the literals a program matches, if that's all it matches.
+   @param code The instructions.
+   @param n The number of instructions.
+   @param[out] nlit The number of literals.
+   @returns The literals in priority order, each followed by a NUL, or NULL if
+   the program matches more than literals.
+ */
+char *findlits(const Instr *code, size_t n, size_t *nlit)
+{
+  struct lits l = {0};
+  char *path = malloc(n + 1);
+  bool ok = n > 0 && walk(code, 0, path, 0, &l);
+
+  free(path);
+  *nlit = ok ? l.n : 0;
+  if (!ok) {
+    free(l.buf);
+    return NULL;
+  }
+  return l.buf;
+}
+
+/**
+   @brief Return the first occurrence of a literal in a string.
+
+   memchr() finds candidates for the first byte, and the last byte is checked
+   before comparing the rest, which rules out most false starts cheaply.
+ */
+static const char *litfind(const char *str, size_t len, const char *lit,
+                           size_t llen)
+{
+  if (llen == 0) {
+    return str;
+  } else if (llen > len) {
+    return NULL;
+  }
+
+  const char *curr = str, *end = str + len - llen + 1;
+  while ((curr = memchr(curr, lit[0], end - curr)) != NULL) {
+    if (curr[llen - 1] == lit[llen - 1] &&
+        memcmp(curr + 1, lit + 1, llen - 1) == 0) {
+      return curr;
+    }
+    curr++;
+  }
+  return NULL;
+}
+
+/**
+   @brief Run a literal program (one with nlit > 0) on a narrow string.
+
+   The result is the same as the VM's: the leftmost match, and of the literals
+   matching there, the one with the highest priority.
+   @param p The program.
+   @param input The input string.
+   @param len Length of the input.  Only needed when not anchored.
+   @param anchored True if the match must start at index 0.
+   @param[out] start Where to put the index the match starts at (may be NULL).
+   @returns Index the match ends at, or -1 if no match.
+ */
+ssize_t litexec(const Prog *p, const char *input, size_t len, bool anchored,
+                size_t *start)
+{
+  const char *lit = p->lits, *best = NULL;
+  size_t bestlen = 0;
+
+  for (size_t i = 0; i < p->nlit; i++) {
+    size_t llen = strlen(lit);
+    if (anchored) {
+      if (strncmp(input, lit, llen) == 0) {
+        best = input;
+        bestlen = llen;
+        break;
+      }
+    } else {
+      // Only an occurrence that starts before the best so far can replace it.
+      size_t limit = best ? (size_t) (best - input) + llen : len;
+      const char *found = litfind(input, limit < len ? limit : len, lit, llen);
+      if (found && (!best || found < best)) {
+        best = found;
+        bestlen = llen;
+      }
+    }
+    lit += llen + 1;
+  }
+
+  if (!best) {
+    return -1;
+  }
+  if (start) {
+    *start = best - input;
+  }
+  return (best - input) + bestlen;
+}
@@ -0,0 +1,185 @@
+/***************************************************************************//**
+
+  @file         pack.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Packing instructions into the compact form used by the VM.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+  The Instr struct is easy to generate and to read and write, but it has room
+  for every operand of every instruction, plus pointers for targets.  The VM
+  only needs an opcode and one or two small operands, so programs are packed
+  into 8 byte PInstr's once they are compiled.  Jump and split targets become
+  offsets relative to the instruction, and character classes are moved into a
+  table shared by the whole program, where each one is turned into a bitmap.
+  Programs that only match literal strings have them saved too (see
+  literal.c).
+
+*******************************************************************************/
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+
+#define PACK_XMIN (-(1 << 23))
+#define PACK_XMAX ((1 << 23) - 1)
+
+/**
+   @brief Return the packed offset from one instruction to another.
+
+   Offsets must fit within the 24 bit x operand.  That allows programs of about
+   8 million instructions, which is much more than the VM could usefully run.
+ */
+static int32_t offset(const Instr *from, const Instr *to)
+{
+  ptrdiff_t diff = to - from;
+  if (diff < PACK_XMIN || diff > PACK_XMAX) {
+    fprintf(stderr, "error: jump offset %td too large to pack\n", diff);
+    exit(1);
+  }
+  return (int32_t) diff;
+}
+
+/**
+   @brief Fill in the class bitmap from its ranges.
+
+   Each char value is tested against the ranges exactly as a wide character
+   would be, so the bitmap and the ranges always agree.
+ */
+static void fillclass(PClass *cls, const char *ranges)
+{
+  for (int c = CHAR_MIN; c <= CHAR_MAX; c++) {
+    for (size_t i = 0; i < cls->n; i++) {
+      if (ranges[2*i] <= c && c <= ranges[2*i + 1]) {
+        unsigned char idx = (unsigned char) c;
+        cls->bits[idx / 32] |= (uint32_t)1 << (idx % 32);
+        break;
+      }
+    }
+  }
+}
+
+/**
+   @brief Create a packed program from an array of instructions.
+   @param code The instructions.
+   @param n The number of instructions.
+   @returns A newly allocated program, which must be freed with progfree().
+ */
+Prog *repack(const Instr *code, size_t n)
+{
+  Prog *p = calloc(1, sizeof(Prog));
+  size_t nranges = 0, nclasses = 0;
+
+  // First, find out how large the class and range tables must be.
+  for (size_t i = 0; i < n; i++) {
+    if (code[i].code == Range || code[i].code == NRange) {
+      nranges += code[i].s;
+      nclasses++;
+    }
+  }
+
+  PInstr *packed = calloc(n, sizeof(PInstr));
+  PClass *classes = calloc(nclasses, sizeof(PClass));
+  char *ranges = calloc(2 * nranges, sizeof(char));
+
+  nranges = 0;
+  nclasses = 0;
+  for (size_t i = 0; i < n; i++) {
+    packed[i].code = code[i].code;
+    switch (code[i].code) {
+    case Char:
+      packed[i].arg = code[i].c;
+      break;
+    case Split:
+      packed[i].arg = offset(code + i, code[i].y);
+      // fall through
+    case Jump:
+      packed[i].x = offset(code + i, code[i].x);
+      break;
+    case Save:
+      packed[i].arg = code[i].s;
+      p->nsave++;
+      break;
+    case Range:
+    case NRange:
+      classes[nclasses].start = nranges;
+      classes[nclasses].n = code[i].s;
+      memcpy(ranges + 2 * nranges, code[i].x, 2 * code[i].s);
+      fillclass(classes + nclasses, ranges + 2 * nranges);
+      packed[i].arg = nclasses;
+      nranges += code[i].s;
+      nclasses++;
+      break;
+    case Match:
+    case Any:
+      break;
+    }
+  }
+
+  p->lits = findlits(code, n, &p->nlit);
+  p->n = n;
+  p->code = packed;
+  p->classes = classes;
+  p->ranges = ranges;
+  return p;
+}
+
+/**
+   @brief Return whether a character is accepted by a Range or NRange.
+   @param p The program containing the instruction.
+   @param in The Range or NRange instruction.
+   @param test The character to test.
+ */
+bool inclass(const Prog *p, PInstr in, wchar_t test)
+{
+  if (test == L'\0') {
+    return false;
+  }
+  const PClass *cls = p->classes + in.arg;
+  bool result = false;
+
+  if (CHAR_MIN <= test && test <= CHAR_MAX) {
+    // Narrow characters can just use the bitmap.
+    unsigned char idx = (unsigned char) test;
+    result = (cls->bits[idx / 32] >> (idx % 32)) & 1;
+  } else {
+    const char *block = p->ranges + 2 * cls->start;
+    for (size_t i = 0; i < cls->n; i++) {
+      if (block[i*2] <= test && test <= block [i*2 + 1]) {
+        result = true;
+        break; // short circuit yo!
+      }
+    }
+  }
+
+  // negate result for negative ranges
+  if (in.code == Range) {
+    return result;
+  } else {
+    return !result;
+  }
+}
+
+/**
+   @brief Free a program created by repack().
+ */
+void progfree(Prog *p)
+{
+  if (p) {
+    free((PInstr *) p->code);
+    free((PClass *) p->classes);
+    free((char *) p->ranges);
+    free((char *) p->lits);
+    free(p);
+  }
+}
@@ -33,7 +33,7 @@
 
 typedef struct thread thread;
 struct thread {
-  Instr *pc;
+  size_t pc;
   size_t *saved;
 };
 
@@ -45,9 +45,9 @@ struct thread_list {
 
 // Printing, for diagnostics
 
-void printthreads(thread_list *tl, Instr *prog, size_t nsave) {
+void printthreads(thread_list *tl, size_t nsave) {
   for (size_t i = 0; i < tl->n; i++) {
-    printf("T%zu@pc=%lu{", i, (intptr_t) (tl->t[i].pc - prog));
+    printf("T%zu@pc=%zu{", i, tl->t[i].pc);
     for (size_t j = 0; j < nsave; j++) {
       printf("%lu,", tl->t[i].saved[j]);
     }
@@ -56,31 +56,6 @@ void printthreads(thread_list *tl, Instr *prog, size_t nsave) {
   printf("\n");
 }
 
-// Helper evaluation functions for instructions
-
-bool range(Instr in, wchar_t test) {
-  if (test == L'\0') {
-    return false;
-  }
-  bool result = false;
-  char *block = (char *) in.x;
-
-  // use in.s for number of ranges, in.x as char* for ranges.
-  for (size_t i = 0; i < in.s; i++) {
-    if (block[i*2] <= test && test <= block [i*2 + 1]) {
-      result = true;
-      break; // short circuit yo!
-    }
-  }
-
-  // negate result for negative ranges
-  if (in.code == Range) {
-    return result;
-  } else {
-    return !result;
-  }
-}
-
 // Pike VM functions:
 
 thread_list newthread_list(size_t n)
@@ -91,32 +66,42 @@ thread_list newthread_list(size_t n)
   return tl;
 }
 
-void addthread(thread_list *threads, Instr *pc, size_t *saved, size_t nsave,
-               size_t sp)
+/**
+   @brief Add a thread to a list, following any instructions that don't consume
+   input.
+
+   The program itself is never modified.  The lastidx array (one entry per
+   instruction) records the last string index at which each instruction was
+   added, so that we don't add the same instruction twice for one index.
+ */
+void addthread(thread_list *threads, const Prog *p, size_t *lastidx, size_t pc,
+               size_t *saved, size_t sp)
 {
-  //printf("addthread(): pc=%d, saved={%u, %u}, sp=%u, lastidx=%u\n", pc - extprog,
-  //       saved[0], saved[1], sp, pc->lastidx);
-  if (pc->lastidx == sp) {
+  //printf("addthread(): pc=%zu, saved={%zu, %zu}, sp=%zu, lastidx=%zu\n", pc,
+  //       saved[0], saved[1], sp, lastidx[pc]);
+  if (lastidx[pc] == sp) {
     // we've executed this instruction on this string index already
     free(saved);
     return;
   }
-  pc->lastidx = sp;
+  lastidx[pc] = sp;
 
+  PInstr in = p->code[pc];
   size_t *newsaved;
-  switch (pc->code) {
+  switch (in.code) {
   case Jump:
-    addthread(threads, pc->x, saved, nsave, sp);
+    addthread(threads, p, lastidx, pc + in.x, saved, sp);
     break;
   case Split:
-    newsaved = calloc(nsave, sizeof(size_t));
-    memcpy(newsaved, saved, nsave * sizeof(size_t));
-    addthread(threads, pc->x, saved, nsave, sp);
-    addthread(threads, pc->y, newsaved, nsave, sp);
+    // The extra slot holds the index this thread started at.
+    newsaved = calloc(p->nsave + 1, sizeof(size_t));
+    memcpy(newsaved, saved, (p->nsave + 1) * sizeof(size_t));
+    addthread(threads, p, lastidx, pc + in.x, saved, sp);
+    addthread(threads, p, lastidx, pc + in.arg, newsaved, sp);
     break;
   case Save:
-    saved[pc->s] = sp;
-    addthread(threads, pc + 1, saved, nsave, sp);
+    saved[in.arg] = sp;
+    addthread(threads, p, lastidx, pc + 1, saved, sp);
     break;
   default:
     threads->t[threads->n].pc = pc;
@@ -147,53 +132,75 @@ void stash(size_t *new, size_t **destination)
   *destination = new;
 }
 
-static ssize_t reexec_internal(Regex r, const struct Input input, size_t **saved)
+/**
+   @brief Run a packed program on the Pike VM.
+
+   When searching (not anchored), a new thread is started at every string index
+   until a match is found.  It's added with the lowest priority, so matches that
+   start earlier are always preferred.  Each thread stores the index it started
+   at in an extra slot after the regular capture slots.
+
+   @param p The program.
+   @param input The input string.
+   @param anchored True if the match must start at index 0.
+   @param[out] start Where to put the index the match starts at (may be NULL).
+   @param[out] saved Out pointer for captured indices (may be NULL).
+   @returns Index the match ends at, or -1 if no match.
+ */
+ssize_t pike(const Prog *p, const struct Input input, bool anchored,
+             size_t *start, size_t **saved)
 {
   // Can have at most n threads, where n is the length of the program.  This is
   // because (as it is now) the thread state is simply a program counter.
-  thread_list curr = newthread_list(r.n);
-  thread_list next = newthread_list(r.n);
+  thread_list curr = newthread_list(p->n);
+  thread_list next = newthread_list(p->n);
   thread_list temp;
-  size_t nsave = 0;
+  size_t nsave = p->nsave;
+  size_t *found = NULL;
+  size_t *initial;
   ssize_t match = -1;
+  bool more = true; // whether there are string indices left to start at
 
-  // Set the out pointer to NULL so that stash() knows whether we've already
-  // stashed away a capture list.
   if (saved) {
     *saved = NULL;
   }
 
   // Need to initialize lastidx to something that will never be used.
-  for (size_t i = 0; i < r.n; i++) {
-    r.i[i].lastidx = (size_t)-1;
-    if (r.i[i].code == Save) {
-      nsave++;
-    }
-  }
-
-  // Start with a single thread and add more as we need.  Note that addthread()
-  // will execute instructions that don't consume input (i.e. epsilon closure).
-  addthread(&curr, r.i, calloc(nsave, sizeof(size_t)), nsave, 0);
+  size_t *lastidx = malloc(p->n * sizeof(size_t));
+  memset(lastidx, 0xFF, p->n * sizeof(size_t));
 
   size_t sp;
-  for (sp = 0; curr.n > 0; sp++) {
+  for (sp = 0; curr.n > 0 || ((sp == 0 || (!anchored && more)) && match == -1);
+       sp++) {
+
+    // Start a thread here if it is allowed.  Note that addthread() will execute
+    // instructions that don't consume input (i.e. epsilon closure).
+    if ((sp == 0 || !anchored) && match == -1) {
+      initial = calloc(nsave + 1, sizeof(size_t));
+      initial[nsave] = sp;
+      addthread(&curr, p, lastidx, 0, initial, sp);
+    }
+    if (InputIdx(input, sp) == L'\0') {
+      more = false;
+    }
 
     //printf("consider input %c\nthreads: ", input[sp]);
-    //printthreads(&curr, r.i, nsave);
+    //printthreads(&curr, nsave);
 
     // Execute each thread (this will only ever reach instructions that consume
     // input, since addthread() stops with those).
     for (size_t t = 0; t < curr.n; t++) {
-      Instr *pc = curr.t[t].pc;
+      size_t pc = curr.t[t].pc;
+      PInstr in = p->code[pc];
 
-      switch (pc->code) {
+      switch (in.code) {
       case Char:
-        if (InputIdx(input, sp) != pc->c) {
+        if (InputIdx(input, sp) != (wchar_t) in.arg) {
           free(curr.t[t].saved);
           break; // fail, don't continue executing this thread
         }
         // add thread containing the next instruction to the next thread list.
-        addthread(&next, pc+1, curr.t[t].saved, nsave, sp+1);
+        addthread(&next, p, lastidx, pc+1, curr.t[t].saved, sp+1);
         break;
       case Any:
         if (InputIdx(input, sp) == '\0') {
@@ -201,19 +208,23 @@ static ssize_t reexec_internal(Regex r, const struct Input input, size_t **saved
           break; // dot can't match end of string!
         }
         // add thread containing the next instruction to the next thread list.
-        addthread(&next, pc+1, curr.t[t].saved, nsave, sp+1);
+        addthread(&next, p, lastidx, pc+1, curr.t[t].saved, sp+1);
         break;
       case Range:
       case NRange:
-        if (!range(*pc, InputIdx(input, sp))) {
+        if (!inclass(p, in, InputIdx(input, sp))) {
           free(curr.t[t].saved);
           break;
         }
-        addthread(&next, pc+1, curr.t[t].saved, nsave, sp+1);
+        addthread(&next, p, lastidx, pc+1, curr.t[t].saved, sp+1);
         break;
       case Match:
-        stash(curr.t[t].saved, saved);
+        stash(curr.t[t].saved, &found);
         match = sp;
+        // Lower priority threads are cut off by this match.
+        for (t = t + 1; t < curr.n; t++) {
+          free(curr.t[t].saved);
+        }
         goto cont;
       default:
         assert(false);
@@ -231,21 +242,211 @@ static ssize_t reexec_internal(Regex r, const struct Input input, size_t **saved
     next.n = 0;
   }
 
+  if (found && start) {
+    *start = found[nsave];
+  }
+  stash(found, saved);
+  free(lastidx);
   free(curr.t);
   free(next.t);
   return match;
 }
 
+/**
+   @brief Run a packed program on the best matcher for the input.
+
+   Programs that only match literals don't need a VM at all for narrow strings.
+   Short inputs go to the backtracker, which has no thread lists to manage.  It
+   needs a bit per instruction per input position, so anything larger than
+   that budget is left to the Pike VM.  Finding the length is bounded by the
+   budget too, so a long input never gets scanned just to make the choice.
+ */
+static ssize_t dispatch(const Prog *p, const struct Input input, bool anchored,
+                        size_t *start, size_t **saved)
+{
+  if (p->nlit > 0 && input.str) {
+    size_t len = anchored ? 0 : strlen(input.str);
+    ssize_t match = litexec(p, input.str, len, anchored, start);
+    if (saved) {
+      *saved = match == -1 ? NULL : calloc(1, sizeof(size_t));
+    }
+    return match;
+  }
+
+  size_t max = BACKTRACK_MAX_BITS / (p->n ? p->n : 1);
+  size_t len = inputlen(input, max);
+  if (len < max) {
+    return backtrack(p, input, len, anchored, start, saved);
+  }
+  return pike(p, input, anchored, start, saved);
+}
+
+static ssize_t reexec_internal(Regex r, const struct Input input, bool anchored,
+                               size_t *start, size_t **saved)
+{
+  // Regexes from recomp() and reread() come with a packed program, but one that
+  // was put together by hand may not.
+  if (r.p) {
+    return dispatch(r.p, input, anchored, start, saved);
+  }
+  Prog *p = repack(r.i, r.n);
+  ssize_t match = dispatch(p, input, anchored, start, saved);
+  progfree(p);
+  return match;
+}
+
 ssize_t reexec(Regex r, const char *input, size_t **saved)
 {
   struct Input in = {.str=input, .wstr=NULL};
-  return reexec_internal(r, in, saved);
+  return reexec_internal(r, in, true, NULL, saved);
 }
 
 ssize_t reexecw(Regex r, const wchar_t *input, size_t **saved)
 {
   struct Input in = {.str=NULL, .wstr=input};
-  return reexec_internal(r, in, saved);
+  return reexec_internal(r, in, true, NULL, saved);
+}
+
+ssize_t research(Regex r, const char *input, size_t *start, size_t **saved)
+{
+  struct Input in = {.str=input, .wstr=NULL};
+  size_t begin = 0;
+  ssize_t end = reexec_internal(r, in, false, &begin, saved);
+  if (end == -1) {
+    return -1;
+  }
+  if (start) {
+    *start = begin;
+  }
+  return end - begin;
+}
+
+ssize_t researchw(Regex r, const wchar_t *input, size_t *start, size_t **saved)
+{
+  struct Input in = {.str=NULL, .wstr=input};
+  size_t begin = 0;
+  ssize_t end = reexec_internal(r, in, false, &begin, saved);
+  if (end == -1) {
+    return -1;
+  }
+  if (start) {
+    *start = begin;
+  }
+  return end - begin;
+}
+
+void reminit(Matcher *m, Regex r)
+{
+  m->own = r.p ? NULL : repack(r.i, r.n);
+  m->p = r.p ? r.p : m->own;
+  m->saved = calloc(m->p->nsave, sizeof(size_t));
+  m->bt = btnew(m->p);
+  m->jit = NULL;
+}
+
+void remdestroy(Matcher *m)
+{
+  jitfree(m->jit);
+  btfree(m->bt);
+  free(m->saved);
+  progfree(m->own);
+}
+
+bool remjit(Matcher *m)
+{
+  if (!m->jit) {
+    m->jit = jitnew(m->p);
+  }
+  return m->jit != NULL;
+}
+
+/**
+   @brief Run the Matcher's program, leaving captures in m->saved.
+
+   This is the same choice of matcher as dispatch(), but the backtracker reuses
+   the Matcher's state, so only the Pike VM allocates.  If remjit() compiled
+   the program, narrow strings run its native code instead of the backtracker.
+   @param m The Matcher.
+   @param input The input.
+   @param len Length of the input.  When anchored, it only needs to be exact if
+   it is below the backtracker's limit.
+   @param anchored True if the match must start at index 0.
+   @param[out] start Index the match starts at (may be NULL).
+   @returns Index the match ends at, or -1.
+ */
+static ssize_t mrun(Matcher *m, const struct Input input, size_t len,
+                    bool anchored, size_t *start)
+{
+  size_t max = BACKTRACK_MAX_BITS / (m->p->n ? m->p->n : 1);
+  size_t *caps = NULL, *pikecaps = NULL;
+  ssize_t end;
+
+  if (m->p->nlit > 0 && input.str) {
+    return litexec(m->p, input.str, len, anchored, start);
+  } else if (len < max && m->jit && input.str) {
+    end = jitrun(m->jit, input.str, len, anchored, start);
+    caps = jitcaps(m->jit);
+  } else if (len < max) {
+    end = btrun(m->bt, m->p, input, len, anchored, start);
+    caps = btcaps(m->bt);
+  } else {
+    end = pike(m->p, input, anchored, start, &pikecaps);
+    caps = pikecaps;
+  }
+
+  if (end != -1) {
+    memcpy(m->saved, caps, m->p->nsave * sizeof(size_t));
+  }
+  free(pikecaps);
+  return end;
+}
+
+/**
+   @brief Search for a match starting at or after an index of the input.
+   @param m The Matcher.
+   @param input The whole input.
+   @param len Length of the whole input.
+   @param from Index to start searching at.
+   @param[out] start Index the match starts at.
+   @returns Length of the match, or -1.  Captures are left in m->saved, and all
+   indices are relative to the whole input.
+ */
+ssize_t remsearch(Matcher *m, const struct Input input, size_t len, size_t from,
+                  size_t *start)
+{
+  struct Input rest = {
+    .str = input.str ? input.str + from : NULL,
+    .wstr = input.wstr ? input.wstr + from : NULL,
+  };
+  ssize_t end = mrun(m, rest, len - from, false, start);
+
+  if (end == -1) {
+    return -1;
+  }
+  for (size_t i = 0; i < m->p->nsave; i++) {
+    m->saved[i] += from;
+  }
+  end -= *start;
+  *start += from;
+  return end;
+}
+
+static ssize_t rematch_internal(Matcher *m, const struct Input input)
+{
+  size_t max = BACKTRACK_MAX_BITS / (m->p->n ? m->p->n : 1);
+  return mrun(m, input, inputlen(input, max), true, NULL);
+}
+
+ssize_t rematch(Matcher *m, const char *input)
+{
+  struct Input in = {.str=input, .wstr=NULL};
+  return rematch_internal(m, in);
+}
+
+ssize_t rematchw(Matcher *m, const wchar_t *input)
+{
+  struct Input in = {.str=NULL, .wstr=input};
+  return rematch_internal(m, in);
 }
 
 size_t renumsaves(Regex r)
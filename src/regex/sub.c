@@ -0,0 +1,257 @@
+/***************************************************************************//**
+
+  @file         sub.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Regex substitution and splitting.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+  Substitution walks the input once, searching for each match after the end of
+  the last one.  Text between matches, and the expanded replacement, are
+  appended straight onto the caller's buffer, so no intermediate strings are
+  created.
+
+  Splitting works the same way, except that it reports the text between
+  matches as slices of the input, and never copies anything at all.  It runs
+  on a Matcher supplied by the caller, so splitting line after line doesn't
+  allocate either.
+
+*******************************************************************************/
+
+#include <string.h>
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+#include "libstephen/cb.h"
+
+/*
+  Output goes to either a cbuf or a wcbuf, to match the input.
+ */
+struct Output {
+  cbuf *cb;
+  wcbuf *wcb;
+};
+
+/**
+   @brief Append input characters [from, to) to the output.
+ */
+static void emit(struct Output out, struct Input in, size_t from, size_t to)
+{
+  if (out.cb) {
+    cb_nconcat(out.cb, in.str + from, to - from);
+  } else {
+    wcb_nconcat(out.wcb, in.wstr + from, to - from);
+  }
+}
+
+/**
+   @brief Append the replacement for one match to the output.
+
+   `$0` is the whole match, `$1` through `$9` are the captures, and `${N}` is
+   capture N, for any N.  `$$` is a literal dollar sign.  A capture that doesn't
+   exist is replaced by nothing, and any other `$` is left alone.
+ */
+static void expand(struct Output out, struct Input in, struct Input repl,
+                   size_t start, size_t end, const size_t *saved, size_t nsave)
+{
+  size_t i = 0, lit = 0;
+  wchar_t c;
+
+  while ((c = InputIdx(repl, i)) != L'\0') {
+    if (c != L'$') {
+      i++;
+      continue;
+    }
+
+    // Parse the reference, leaving i after it.
+    size_t group = 0, after = i + 1;
+    bool valid = true;
+    c = InputIdx(repl, after);
+    if (c == L'$') {
+      emit(out, repl, lit, i + 1);
+      lit = i = after + 1;
+      continue;
+    } else if (L'0' <= c && c <= L'9') {
+      group = c - L'0';
+      after++;
+    } else if (c == L'{') {
+      after++;
+      valid = false;
+      while (L'0' <= (c = InputIdx(repl, after)) && c <= L'9') {
+        group = group * 10 + (c - L'0');
+        valid = true;
+        after++;
+      }
+      valid = valid && c == L'}';
+      after++;
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      i++;
+      continue;
+    }
+
+    // Flush the literal text before the reference, then the group itself.
+    emit(out, repl, lit, i);
+    if (group == 0) {
+      emit(out, in, start, end);
+    } else if (2 * group <= nsave) {
+      emit(out, in, saved[2 * group - 2], saved[2 * group - 1]);
+    }
+    lit = i = after;
+  }
+  emit(out, repl, lit, i);
+}
+
+static size_t resub_internal(Regex r, struct Input in, struct Input repl,
+                             size_t max, struct Output out)
+{
+  Matcher m;
+  size_t n = inputlen(in, (size_t) -1);
+  size_t pos = 0, start, count;
+  ssize_t len;
+
+  reminit(&m, r);
+  for (count = 0; count < max; count++) {
+    len = remsearch(&m, in, n, pos, &start);
+    if (len == -1) {
+      break;
+    }
+    emit(out, in, pos, start);
+    expand(out, in, repl, start, start + len, m.saved, m.p->nsave);
+    pos = start + len;
+
+    if (len == 0) {
+      // Don't find the same empty match again, move past the next character.
+      if (pos == n) {
+        count++;
+        break;
+      }
+      emit(out, in, pos, pos + 1);
+      pos++;
+    }
+  }
+
+  emit(out, in, pos, n);
+  remdestroy(&m);
+  return count;
+}
+
+size_t resub(Regex r, const char *input, const char *repl, cbuf *out)
+{
+  return resubn(r, input, repl, (size_t)-1, out);
+}
+
+size_t resubn(Regex r, const char *input, const char *repl, size_t max,
+              cbuf *out)
+{
+  struct Input in = {.str=input, .wstr=NULL};
+  struct Input rp = {.str=repl, .wstr=NULL};
+  struct Output o = {.cb=out, .wcb=NULL};
+  return resub_internal(r, in, rp, max, o);
+}
+
+size_t resubw(Regex r, const wchar_t *input, const wchar_t *repl, wcbuf *out)
+{
+  return resubnw(r, input, repl, (size_t)-1, out);
+}
+
+size_t resubnw(Regex r, const wchar_t *input, const wchar_t *repl, size_t max,
+               wcbuf *out)
+{
+  struct Input in = {.str=NULL, .wstr=input};
+  struct Input rp = {.str=NULL, .wstr=repl};
+  struct Output o = {.cb=NULL, .wcb=out};
+  return resub_internal(r, in, rp, max, o);
+}
+
+/*
+  Where resplit() puts its fields: an array, a function, or both.
+ */
+struct Fields {
+  Slice *out;
+  size_t nout;
+  void (*f)(Slice, void *);
+  void *data;
+};
+
+/**
+   @brief Report the field [from, to) as field number idx.
+ */
+static void field(struct Fields fs, size_t idx, size_t from, size_t to)
+{
+  Slice s = {.offset=from, .length=to - from};
+  if (idx < fs.nout) {
+    fs.out[idx] = s;
+  }
+  if (fs.f) {
+    fs.f(s, fs.data);
+  }
+}
+
+static size_t resplit_internal(Matcher *m, struct Input in, size_t max,
+                               struct Fields fs)
+{
+  size_t n = inputlen(in, (size_t) -1);
+  size_t pos = 0, from = 0, start, count = 0;
+  ssize_t len;
+
+  // Each delimiter ends a field, until there's only room for the last one.
+  while (max == 0 || count + 1 < max) {
+    len = remsearch(m, in, n, from, &start);
+    if (len == -1) {
+      break;
+    } else if (len == 0) {
+      // An empty delimiter would split between every character, so look for a
+      // real one past it, within the same field.
+      if (start == n) {
+        break;
+      }
+      from = start + 1;
+      continue;
+    }
+    field(fs, count++, pos, start);
+    pos = from = start + len;
+  }
+
+  field(fs, count++, pos, n);
+  return count;
+}
+
+size_t resplit(Matcher *m, const char *input, size_t max, Slice *out,
+               size_t nout)
+{
+  struct Input in = {.str=input, .wstr=NULL};
+  struct Fields fs = {.out=out, .nout=nout, .f=NULL, .data=NULL};
+  return resplit_internal(m, in, max, fs);
+}
+
+size_t resplitw(Matcher *m, const wchar_t *input, size_t max, Slice *out,
+                size_t nout)
+{
+  struct Input in = {.str=NULL, .wstr=input};
+  struct Fields fs = {.out=out, .nout=nout, .f=NULL, .data=NULL};
+  return resplit_internal(m, in, max, fs);
+}
+
+size_t resplitf(Matcher *m, const char *input, size_t max,
+                void (*f)(Slice, void *), void *data)
+{
+  struct Input in = {.str=input, .wstr=NULL};
+  struct Fields fs = {.out=NULL, .nout=0, .f=f, .data=data};
+  return resplit_internal(m, in, max, fs);
+}
+
+size_t resplitfw(Matcher *m, const wchar_t *input, size_t max,
+                 void (*f)(Slice, void *), void *data)
+{
+  struct Input in = {.str=NULL, .wstr=input};
+  struct Fields fs = {.out=NULL, .nout=0, .f=f, .data=data};
+  return resplit_internal(m, in, max, fs);
+}
@@ -74,3 +74,12 @@ wchar_t InputIdx(struct Input in, size_t idx)
     return in.wstr[idx];
   }
 }
+
+size_t inputlen(struct Input in, size_t max)
+{
+  size_t len = 0;
+  while (len < max && InputIdx(in, len) != L'\0') {
+    len++;
+  }
+  return len;
+}
@@ -0,0 +1,409 @@
+/***************************************************************************//**
+
+  @file         alatest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Test of the inline record array list.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libstephen/ala.h"
+#include "libstephen/ut.h"
+#include "tests.h"
+
+/**
+   A 48 byte record, about the size these lists are meant for.
+ */
+typedef struct {
+  long long id;
+  double weight;
+  char name[32];
+} record;
+
+static record make_record(long long id)
+{
+  record r;
+  memset(&r, 0, sizeof(r));
+  r.id = id;
+  r.weight = id / 2.0;
+  snprintf(r.name, sizeof(r.name), "record %lld", id);
+  return r;
+}
+
+static int record_check(const record *r, long long id)
+{
+  record expected = make_record(id);
+  return r != NULL && memcmp(r, &expected, sizeof(record)) == 0;
+}
+
+static int record_comp(const void *left, const void *right)
+{
+  const record *l = left, *r = right;
+  return (l->id > r->id) - (l->id < r->id);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TESTS
+
+/**
+   Appending copies records in (or zeroes them), past several reallocations.
+ */
+int ala_test_append()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ala *list = ala_create(sizeof(record));
+  record *r;
+  int i;
+
+  for (i = 0; i < 1000; i++) {
+    record item = make_record(i);
+    r = ala_append(list, &item);
+    TEST_ASSERT(record_check(r, i));
+  }
+  r = ala_append(list, NULL);
+  TA_LLINT_EQ(r->id, 0);
+  TA_INT_EQ(r->name[0], 0);
+  r->id = 1000;
+
+  TA_INT_EQ(ala_length(list), 1001);
+  for (i = 0; i < 1000; i++) {
+    r = ala_get(list, i, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TEST_ASSERT(record_check(r, i));
+  }
+  r = ala_get(list, 1000, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_LLINT_EQ(r->id, 1000);
+
+  ala_delete(list);
+  return 0;
+}
+
+/**
+   Getting or removing outside the list is an index error.
+ */
+int ala_test_index_error()
+{
+  smb_status status = SMB_SUCCESS;
+  record item = make_record(1);
+  smb_ala list;
+  ala_init(&list, sizeof(record));
+
+  TA_PTR_EQ(ala_get(&list, 0, &status), NULL);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+  ala_pop_back(&list, &item, &status);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+  TEST_ASSERT(record_check(&item, 1));
+
+  ala_append(&list, &item);
+  TA_PTR_EQ(ala_get(&list, -1, &status), NULL);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+  TA_PTR_EQ(ala_get(&list, 1, &status), NULL);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+  ala_remove(&list, 1, &status);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+  ala_remove(&list, -1, &status);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+  TA_INT_EQ(ala_length(&list), 1);
+
+  ala_destroy(&list);
+  return 0;
+}
+
+/**
+   Inserting shifts later records up, and clamps the index like al_insert().
+ */
+int ala_test_insert()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ala list;
+  record item;
+  int i;
+  ala_init(&list, sizeof(record));
+
+  // Build 0..39 out of order: odd ones appended, even ones inserted.
+  for (i = 1; i < 40; i += 2) {
+    item = make_record(i);
+    ala_append(&list, &item);
+  }
+  for (i = 0; i < 40; i += 2) {
+    item = make_record(i);
+    TEST_ASSERT(record_check(ala_insert(&list, i, &item), i));
+  }
+  item = make_record(-1);
+  ala_insert(&list, -5, &item);
+  item = make_record(40);
+  ala_insert(&list, 100, &item);
+
+  TA_INT_EQ(ala_length(&list), 42);
+  for (i = 0; i < 42; i++) {
+    TEST_ASSERT(record_check(ala_get(&list, i, &status), i - 1));
+  }
+
+  ala_destroy(&list);
+  return 0;
+}
+
+/**
+   Removing shifts later records down, and pop_back copies the last one out.
+ */
+int ala_test_remove()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ala list;
+  record item;
+  int i;
+  ala_init(&list, sizeof(record));
+
+  for (i = 0; i < 20; i++) {
+    item = make_record(i);
+    ala_append(&list, &item);
+  }
+  // Remove the odd records, from the front, middle, and back.
+  for (i = 1; i < 11; i++) {
+    ala_remove(&list, i, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  TA_INT_EQ(ala_length(&list), 10);
+  for (i = 0; i < 10; i++) {
+    TEST_ASSERT(record_check(ala_get(&list, i, &status), 2 * i));
+  }
+  ala_remove(&list, 0, &status);
+  TEST_ASSERT(record_check(ala_get(&list, 0, &status), 2));
+
+  ala_pop_back(&list, &item, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TEST_ASSERT(record_check(&item, 18));
+  ala_pop_back(&list, NULL, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_INT_EQ(ala_length(&list), 7);
+  TEST_ASSERT(record_check(ala_get(&list, 6, &status), 14));
+
+  ala_destroy(&list);
+  return 0;
+}
+
+/**
+   Extending copies a whole array, and reserve and shrink_to_fit only change
+   the capacity.
+ */
+int ala_test_capacity()
+{
+  smb_status status = SMB_SUCCESS;
+  record items[100];
+  smb_ala list;
+  void *data;
+  int i;
+  ala_init(&list, sizeof(record));
+
+  for (i = 0; i < 100; i++) {
+    items[i] = make_record(i);
+  }
+  ala_reserve(&list, 250);
+  TA_INT_EQ(list.allocated, 250);
+  data = list.data;
+  ala_extend(&list, items, 100);
+  ala_extend(&list, items, 0);
+  ala_extend(&list, items, 100);
+  ala_extend(&list, items, 50);
+  TA_PTR_EQ(list.data, data);
+  ala_extend(&list, items, 1);
+  TEST_ASSERT(list.allocated >= 251);
+
+  TA_INT_EQ(ala_length(&list), 251);
+  for (i = 0; i < 250; i++) {
+    long long id = i % 100;
+    TEST_ASSERT(record_check(ala_get(&list, i, &status), id));
+  }
+
+  ala_shrink_to_fit(&list);
+  TA_INT_EQ(list.allocated, 251);
+  TEST_ASSERT(record_check(ala_get(&list, 250, &status), 0));
+  while (ala_length(&list) > 0) {
+    ala_pop_back(&list, NULL, &status);
+  }
+  ala_shrink_to_fit(&list);
+  TA_INT_EQ(list.allocated, 1);
+  ala_extend(&list, items, 3);
+  TEST_ASSERT(record_check(ala_get(&list, 2, &status), 2));
+
+  ala_destroy(&list);
+  return 0;
+}
+
+/**
+   Sorting orders records in place with a qsort() comparator.
+ */
+int ala_test_sort()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ala list;
+  record item;
+  int i;
+  ala_init(&list, sizeof(record));
+
+  ala_sort(&list, record_comp);
+  for (i = 0; i < 500; i++) {
+    item = make_record((i * 7919) % 500);
+    ala_append(&list, &item);
+  }
+  ala_sort(&list, record_comp);
+  for (i = 0; i < 500; i++) {
+    TEST_ASSERT(record_check(ala_get(&list, i, &status), i));
+  }
+
+  ala_destroy(&list);
+  return 0;
+}
+
+/**
+   The iterator yields pointers into the list, so records can be changed in
+   place.
+ */
+int ala_test_iter()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ala list;
+  smb_iter it;
+  record item, *r;
+  int i;
+  ala_init(&list, sizeof(record));
+
+  for (i = 0; i < 30; i++) {
+    item = make_record(i);
+    ala_append(&list, &item);
+  }
+
+  it = ala_get_iter(&list);
+  i = 0;
+  while (it.has_next(&it)) {
+    r = it.next(&it, &status).data_ptr;
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_PTR_EQ(r, ala_get(&list, i, &status));
+    TEST_ASSERT(record_check(r, i));
+    r->weight = -1;
+    i++;
+  }
+  TA_INT_EQ(i, 30);
+  TA_PTR_EQ(it.next(&it, &status).data_ptr, NULL);
+  TA_INT_EQ(status, SMB_STOP_ITERATION);
+  it.destroy(&it);
+
+  for (i = 0; i < 30; i++) {
+    r = ala_get(&list, i, &status);
+    TEST_ASSERT(r->weight == -1);
+  }
+
+  ala_destroy(&list);
+  return 0;
+}
+
+/**
+   Lists of zero sized items still work, and never allocate zero bytes.
+ */
+int ala_test_empty_items()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ala list;
+  int i;
+  ala_init(&list, 0);
+
+  for (i = 0; i < 100; i++) {
+    ala_append(&list, NULL);
+  }
+  ala_insert(&list, 3, NULL);
+  ala_remove(&list, 0, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  ala_sort(&list, record_comp);
+  TA_INT_EQ(ala_length(&list), 100);
+  ala_shrink_to_fit(&list);
+
+  ala_destroy(&list);
+  return 0;
+}
+
+/**
+   Items copied in may come from the list itself, even when it has to grow and
+   move, or when inserting shifts them.
+ */
+int ala_test_self_copy()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ala list;
+  record item;
+  int i;
+  ala_init(&list, sizeof(record));
+
+  for (i = 0; i < 16; i++) {
+    item = make_record(i);
+    ala_append(&list, &item);
+  }
+  TA_INT_EQ(list.allocated, 16);
+  ala_append(&list, ala_get(&list, 3, &status));
+  TEST_ASSERT(record_check(ala_get(&list, 16, &status), 3));
+
+  ala_shrink_to_fit(&list);
+  ala_insert(&list, 0, ala_get(&list, 5, &status));
+  TEST_ASSERT(record_check(ala_get(&list, 0, &status), 5));
+  ala_insert(&list, 10, ala_get(&list, 2, &status));
+  TEST_ASSERT(record_check(ala_get(&list, 10, &status), 1));
+  TA_INT_EQ(ala_length(&list), 19);
+
+  ala_shrink_to_fit(&list);
+  ala_extend(&list, list.data, 19);
+  TA_INT_EQ(ala_length(&list), 38);
+  for (i = 0; i < 19; i++) {
+    TEST_ASSERT(memcmp(ala_get(&list, i, &status),
+                       ala_get(&list, i + 19, &status), sizeof(record)) == 0);
+  }
+
+  ala_destroy(&list);
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TEST LOADER AND RUNNER
+
+void ala_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/alatest.c");
+
+  smb_ut_test *append = su_create_test("append", ala_test_append);
+  su_add_test(group, append);
+
+  smb_ut_test *index_error = su_create_test("index_error", ala_test_index_error);
+  su_add_test(group, index_error);
+
+  smb_ut_test *insert = su_create_test("insert", ala_test_insert);
+  su_add_test(group, insert);
+
+  smb_ut_test *remove = su_create_test("remove", ala_test_remove);
+  su_add_test(group, remove);
+
+  smb_ut_test *capacity = su_create_test("capacity", ala_test_capacity);
+  su_add_test(group, capacity);
+
+  smb_ut_test *sort = su_create_test("sort", ala_test_sort);
+  su_add_test(group, sort);
+
+  smb_ut_test *iter = su_create_test("iter", ala_test_iter);
+  su_add_test(group, iter);
+
+  smb_ut_test *empty_items = su_create_test("empty_items", ala_test_empty_items);
+  su_add_test(group, empty_items);
+
+  smb_ut_test *self_copy = su_create_test("self_copy", ala_test_self_copy);
+  su_add_test(group, self_copy);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
@@ -46,6 +46,109 @@ int al_test_create_empty()
   return 0;
 }
 
+/**
+   The capacity doubles, so it's never much more than twice the length.
+ */
+int al_test_growth()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_al list;
+  int i, resizes = 0, allocated;
+  al_init(&list);
+
+  for (i = 0; i < 100000; i++) {
+    allocated = list.allocated;
+    al_append(&list, LLINT(i));
+    resizes += list.allocated != allocated;
+    TEST_ASSERT(list.allocated <= 2 * list.length + 20);
+  }
+  TEST_ASSERT(resizes < 20);
+  TA_LLINT_EQ(al_get(&list, 99999, &status).data_llint, 99999);
+
+  al_destroy(&list);
+  return 0;
+}
+
+/**
+   Reserving makes room up front, and shrinking frees what's left over.
+ */
+int al_test_reserve()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_al list;
+  DATA *data;
+  int i;
+  al_init(&list);
+
+  al_reserve(&list, 1000);
+  TA_INT_EQ(list.allocated, 1000);
+  data = list.data;
+  for (i = 0; i < 1000; i++) {
+    al_append(&list, LLINT(i));
+  }
+  TA_PTR_EQ(list.data, data);
+  // Reserving less than the list holds does nothing.
+  al_reserve(&list, 10);
+  TA_INT_EQ(list.allocated, 1000);
+
+  al_append(&list, LLINT(1000));
+  TEST_ASSERT(list.allocated > 1001);
+  al_shrink_to_fit(&list);
+  TA_INT_EQ(list.allocated, 1001);
+  TA_LLINT_EQ(al_get(&list, 1000, &status).data_llint, 1000);
+
+  // An empty list keeps room for one item, and still grows.
+  while (al_length(&list) > 0) {
+    al_pop_back(&list, &status);
+  }
+  al_shrink_to_fit(&list);
+  TA_INT_EQ(list.allocated, 1);
+  for (i = 0; i < 50; i++) {
+    al_append(&list, LLINT(i));
+  }
+  TA_LLINT_EQ(al_get(&list, 49, &status).data_llint, 49);
+
+  al_destroy(&list);
+  return 0;
+}
+
+/**
+   Extending appends a whole array, growing as much as it needs to.
+ */
+int al_test_extend()
+{
+  smb_status status = SMB_SUCCESS;
+  DATA items[500];
+  smb_al list;
+  int i;
+  al_init(&list);
+
+  for (i = 0; i < 500; i++) {
+    items[i] = LLINT(i);
+  }
+  al_append(&list, LLINT(-1));
+  al_extend(&list, items, 500);
+  al_extend(&list, items, 0);
+  al_extend(&list, items, 3);
+  TA_INT_EQ(al_length(&list), 504);
+  TA_LLINT_EQ(al_get(&list, 0, &status).data_llint, -1);
+  for (i = 0; i < 500; i++) {
+    TA_LLINT_EQ(al_get(&list, i + 1, &status).data_llint, i);
+  }
+  TA_LLINT_EQ(al_get(&list, 503, &status).data_llint, 2);
+
+  // Extending a full list from itself reads the items after it grows.
+  al_shrink_to_fit(&list);
+  al_extend(&list, list.data + 1, 503);
+  TA_INT_EQ(al_length(&list), 1007);
+  for (i = 0; i < 503; i++) {
+    TA_LLINT_EQ(al_get(&list, i + 504, &status).data_llint,
+                al_get(&list, i + 1, &status).data_llint);
+  }
+
+  al_destroy(&list);
+  return 0;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 // TEST LOADER AND RUNNER
@@ -60,6 +163,15 @@ void array_list_test()
   smb_ut_test *create_empty = su_create_test("create_empty", al_test_create_empty);
   su_add_test(group, create_empty);
 
+  smb_ut_test *growth = su_create_test("growth", al_test_growth);
+  su_add_test(group, growth);
+
+  smb_ut_test *reserve = su_create_test("reserve", al_test_reserve);
+  su_add_test(group, reserve);
+
+  smb_ut_test *extend = su_create_test("extend", al_test_extend);
+  su_add_test(group, extend);
+
   su_run_group(group);
   su_delete_group(group);
 }
@@ -99,6 +99,36 @@ int test_wcbuf_concat_realloc(void)
   return 0;
 }
 
+/**
+   @brief Test concatenating part of a string to a cbuf.
+ */
+int test_cbuf_nconcat(void)
+{
+  cbuf *c = cb_create(4);
+  cb_nconcat(c, "abcxyz", 3);
+  cb_nconcat(c, "defxyz", 3);
+  TA_STR_EQ(c->buf, "abcdef");
+  TA_INT_EQ(c->capacity, 8);
+  TA_INT_EQ(c->length, 6);
+  cb_delete(c);
+  return 0;
+}
+
+/**
+   @brief Test concatenating part of a wide string to a wcbuf.
+ */
+int test_wcbuf_nconcat(void)
+{
+  wcbuf *wc = wcb_create(4);
+  wcb_nconcat(wc, L"abcxyz", 3);
+  wcb_nconcat(wc, L"defxyz", 3);
+  TA_WSTR_EQ(wc->buf, L"abcdef");
+  TA_INT_EQ(wc->capacity, 8);
+  TA_INT_EQ(wc->length, 6);
+  wcb_delete(wc);
+  return 0;
+}
+
 /**
    @brief Test appending a character to a cbuf without reallocation.
  */
@@ -271,6 +301,12 @@ void charbuf_test(void)
   smb_ut_test *wcbuf_concat_realloc = su_create_test("wcbuf_concat_realloc", test_wcbuf_concat_realloc);
   su_add_test(group, wcbuf_concat_realloc);
 
+  smb_ut_test *cbuf_nconcat = su_create_test("cbuf_nconcat", test_cbuf_nconcat);
+  su_add_test(group, cbuf_nconcat);
+
+  smb_ut_test *wcbuf_nconcat = su_create_test("wcbuf_nconcat", test_wcbuf_nconcat);
+  su_add_test(group, wcbuf_nconcat);
+
   smb_ut_test *cbuf_printf = su_create_test("cbuf_printf", test_cbuf_printf);
   su_add_test(group, cbuf_printf);
 
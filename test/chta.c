@@ -0,0 +1,146 @@
+/***************************************************************************//**
+
+  @file         chta.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the concurrent hash table.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "tests.h"
+#include "libstephen/ut.h"
+#include "libstephen/chta.h"
+
+#define CHTA_TEST_THREADS 4
+#define CHTA_TEST_KEYS 20000
+
+static unsigned int chta_test_hash(void *key)
+{
+  return * (unsigned int*) key;
+}
+
+static int chta_test_basic(void)
+{
+  smb_status status = SMB_SUCCESS;
+  int key, value = 0;
+  smb_chta *table = chta_create(chta_test_hash, &hta_int_comp, sizeof(int),
+                                sizeof(int));
+
+  for (key = 0; key < 1000; key++) {
+    value = key * 2;
+    chta_insert(table, &key, &value);
+  }
+  TA_INT_EQ(chta_length(table), 1000);
+
+  key = 21;
+  chta_get(table, &key, &value, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_INT_EQ(value, 42);
+
+  chta_remove(table, &key, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TEST_ASSERT(!chta_contains(table, &key));
+  chta_remove(table, &key, &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+  chta_get(table, &key, &value, &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+  TA_INT_EQ(chta_length(table), 999);
+
+  chta_delete(table);
+  return 0;
+}
+
+struct chta_test_arg {
+  smb_chta *table;
+  int id;
+  int errors;
+};
+
+/*
+  Insert a range of keys of our own, reading back keys of other threads as we
+  go, then remove every other one of ours.
+ */
+static void *chta_test_worker(void *data)
+{
+  struct chta_test_arg *arg = data;
+  smb_status status = SMB_SUCCESS;
+  int i, key, value;
+
+  for (i = 0; i < CHTA_TEST_KEYS; i++) {
+    key = arg->id * CHTA_TEST_KEYS + i;
+    value = -key;
+    chta_insert(arg->table, &key, &value);
+
+    key = ((arg->id + 1) % CHTA_TEST_THREADS) * CHTA_TEST_KEYS + i;
+    chta_get(arg->table, &key, &value, &status);
+    if (status == SMB_SUCCESS && value != -key) {
+      arg->errors++;
+    }
+  }
+  for (i = 0; i < CHTA_TEST_KEYS; i += 2) {
+    key = arg->id * CHTA_TEST_KEYS + i;
+    chta_remove(arg->table, &key, &status);
+    if (status != SMB_SUCCESS) {
+      arg->errors++;
+    }
+  }
+  return NULL;
+}
+
+static int chta_test_threads(void)
+{
+  smb_status status = SMB_SUCCESS;
+  pthread_t threads[CHTA_TEST_THREADS];
+  struct chta_test_arg args[CHTA_TEST_THREADS];
+  int i, key, value;
+  smb_chta table;
+  chta_init(&table, chta_test_hash, &hta_int_comp, sizeof(int), sizeof(int));
+
+  for (i = 0; i < CHTA_TEST_THREADS; i++) {
+    args[i].table = &table;
+    args[i].id = i;
+    args[i].errors = 0;
+    pthread_create(&threads[i], NULL, chta_test_worker, &args[i]);
+  }
+  for (i = 0; i < CHTA_TEST_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+    TA_INT_EQ(args[i].errors, 0);
+  }
+
+  TA_INT_EQ(chta_length(&table), CHTA_TEST_THREADS * CHTA_TEST_KEYS / 2);
+  for (key = 0; key < CHTA_TEST_THREADS * CHTA_TEST_KEYS; key++) {
+    chta_get(&table, &key, &value, &status);
+    if (key % 2 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+    } else {
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_INT_EQ(value, -key);
+    }
+  }
+
+  chta_destroy(&table);
+  return 0;
+}
+
+void chta_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/chta.c");
+
+  smb_ut_test *basic = su_create_test("basic", chta_test_basic);
+  su_add_test(group, basic);
+
+  smb_ut_test *threads = su_create_test("threads", chta_test_threads);
+  su_add_test(group, threads);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
@@ -17,6 +17,7 @@
 
 #include "tests.h"
 #include "libstephen/ut.h"
+#include "libstephen/hash.h"
 #include "libstephen/ht.h"
 
 #define TEST_PAIRS 5
@@ -312,6 +313,356 @@ int ht_test_iterator(void)
   return 0;
 }
 
+/**
+   Power of two tables must still spread out keys that only differ in their high
+   bits, and must find every key after growing several times.
+ */
+int ht_test_pow2()
+{
+  smb_status status = SMB_SUCCESS;
+  DATA key, value;
+  unsigned int i, n = 1000;
+  smb_ht table;
+  ht_init_policy(&table, ht_test_linear_hash, &data_compare_int, HT_POW2);
+  TA_INT_EQ(table.allocated, HASH_TABLE_INITIAL_POW2);
+
+  for (i = 0; i < n; i++) {
+    key.data_llint = i << 12;
+    value.data_llint = -(long long)i;
+    ht_insert(&table, key, value);
+  }
+  TA_INT_EQ(table.length, n);
+  TA_INT_EQ(table.allocated & (table.allocated - 1), 0);
+
+  for (i = 0; i < n; i += 2) {
+    key.data_llint = i << 12;
+    ht_remove(&table, key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  for (i = 0; i < n; i++) {
+    key.data_llint = i << 12;
+    value = ht_get(&table, key, &status);
+    if (i % 2 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+    } else {
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_LLINT_EQ(value.data_llint, -(long long)i);
+    }
+  }
+
+  ht_destroy(&table);
+  return 0;
+}
+
+/**
+   Inserting and removing over and over leaves graves behind.  They must be
+   cleaned up without growing the table.
+ */
+int ht_test_churn()
+{
+  smb_status status = SMB_SUCCESS;
+  DATA key, value;
+  unsigned int i;
+  smb_ht table;
+  ht_init(&table, ht_test_linear_hash, &data_compare_int);
+
+  for (i = 0; i < 10000; i++) {
+    key.data_llint = i;
+    value.data_llint = i;
+    ht_insert(&table, key, value);
+    if (i >= 4) {
+      key.data_llint = i - 4;
+      ht_remove(&table, key, &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+    }
+    TA_INT_EQ(table.allocated, HASH_TABLE_INITIAL_SIZE);
+    TEST_ASSERT(table.graves < table.allocated * HASH_TABLE_MAX_LOAD_FACTOR);
+  }
+  TA_INT_EQ(table.length, 4);
+  for (i = 9996; i < 10000; i++) {
+    key.data_llint = i;
+    TA_LLINT_EQ(ht_get(&table, key, &status).data_llint, i);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+
+  ht_destroy(&table);
+  return 0;
+}
+
+/**
+   Removing most of the keys shrinks the table, for both policies.
+ */
+static int ht_test_shrink_policy(smb_ht_policy policy)
+{
+  smb_status status = SMB_SUCCESS;
+  DATA key, value;
+  unsigned int i, n = 1000, grown;
+  smb_ht table;
+  ht_init_policy(&table, ht_test_linear_hash, &data_compare_int, policy);
+
+  for (i = 0; i < n; i++) {
+    key.data_llint = i;
+    value.data_llint = -(long long)i;
+    ht_insert(&table, key, value);
+  }
+  grown = table.allocated;
+
+  for (i = 10; i < n; i++) {
+    key.data_llint = i;
+    ht_remove(&table, key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  TA_INT_EQ(table.length, 10);
+  TEST_ASSERT(table.allocated < grown / 8);
+  TEST_ASSERT(table.allocated >= ht_initial_size(policy));
+  for (i = 0; i < 10; i++) {
+    key.data_llint = i;
+    TA_LLINT_EQ(ht_get(&table, key, &status).data_llint, -(long long)i);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+
+  ht_destroy(&table);
+  return 0;
+}
+
+int ht_test_shrink()
+{
+  return ht_test_shrink_policy(HT_PRIME) || ht_test_shrink_policy(HT_POW2);
+}
+
+/**
+   Incremental tables must find every key while a rehash is in progress, move
+   only a few slots per change, and iterate over both tables.
+ */
+int ht_test_incremental()
+{
+  smb_status status = SMB_SUCCESS;
+  DATA key, value;
+  unsigned int i, n = 5000, migrated, rehashes = 0;
+  size_t nseen = 0;
+  smb_ht table;
+  ht_init(&table, ht_test_linear_hash, &data_compare_int);
+  ht_set_incremental(&table, true);
+
+  for (i = 0; i < n; i++) {
+    smb_ht *old = table.old;
+    migrated = table.migrated;
+    key.data_llint = i;
+    value.data_llint = -(long long)i;
+    ht_insert(&table, key, value);
+    if (table.old && table.old == old) {
+      TEST_ASSERT(table.migrated - migrated <= HASH_TABLE_MIGRATE_SLOTS);
+    } else if (table.old) {
+      rehashes++;
+    }
+    key.data_llint = i / 2;
+    TA_LLINT_EQ(ht_get(&table, key, &status).data_llint, -(long long)(i / 2));
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  TEST_ASSERT(rehashes > 0);
+  TA_INT_EQ(table.length, n);
+
+  // Catch the table in the middle of a rehash, and check the iterator.
+  while (!table.old) {
+    key.data_llint = i++;
+    ht_insert(&table, key, key);
+  }
+  smb_iter it = ht_get_iter(&table);
+  while (it.has_next(&it)) {
+    it.next(&it, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    nseen++;
+  }
+  TA_INT_EQ(nseen, table.length);
+
+  // Remove keys from both tables, then finish the rehash.
+  for (i = 0; i < n; i += 2) {
+    key.data_llint = i;
+    ht_remove(&table, key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  ht_set_incremental(&table, false);
+  TA_PTR_EQ(table.old, NULL);
+  for (i = 0; i < n; i++) {
+    key.data_llint = i;
+    TA_INT_EQ(ht_contains(&table, key), i % 2 == 1);
+  }
+
+  ht_destroy(&table);
+  return 0;
+}
+
+/**
+   Counting words is the classic use of an upsert.
+ */
+int ht_test_upsert()
+{
+  char *words[] = {"a", "b", "a", "c", "a", "b"};
+  bool inserted;
+  DATA *count;
+  smb_status status = SMB_SUCCESS;
+  size_t i;
+  smb_ht table;
+  ht_init(&table, ht_string_hash, &data_compare_string);
+
+  for (i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+    count = ht_upsert(&table, PTR(words[i]), &inserted);
+    TA_INT_EQ(inserted, count->data_llint == 0);
+    count->data_llint++;
+  }
+  TA_INT_EQ(table.length, 3);
+  TA_LLINT_EQ(ht_get(&table, PTR("a"), &status).data_llint, 3);
+  TA_LLINT_EQ(ht_get(&table, PTR("b"), &status).data_llint, 2);
+  TA_LLINT_EQ(ht_get(&table, PTR("c"), &status).data_llint, 1);
+
+  // Removing leaves a grave, which the next upsert of the key reuses.
+  ht_remove(&table, PTR("b"), &status);
+  count = ht_upsert(&table, PTR("b"), &inserted);
+  TEST_ASSERT(inserted);
+  TA_LLINT_EQ(count->data_llint, 0);
+  TA_INT_EQ(table.graves, 0);
+
+  ht_destroy(&table);
+  return 0;
+}
+
+/**
+   A reserved table doesn't rehash while it's loaded.
+ */
+int ht_test_reserve()
+{
+  DATA key;
+  unsigned int i, n = 10000, allocated;
+  smb_ht table;
+  ht_init(&table, ht_test_linear_hash, &data_compare_int);
+
+  ht_reserve(&table, n);
+  allocated = table.allocated;
+  TEST_ASSERT(allocated > HASH_TABLE_INITIAL_SIZE);
+  for (i = 0; i < n; i++) {
+    key.data_llint = i;
+    ht_insert(&table, key, key);
+    TA_INT_EQ(table.allocated, allocated);
+  }
+
+  // Reserving less than the table holds does nothing.
+  ht_reserve(&table, 10);
+  TA_INT_EQ(table.allocated, allocated);
+
+  ht_destroy(&table);
+  return 0;
+}
+
+/**
+   Stats count probe lengths, graves and resizes, and lookups if they're built
+   in.
+ */
+int ht_test_stats()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ht_stats stats;
+  unsigned int i, resizes = 0, allocated;
+  smb_ht table;
+
+  // Every key collides, so the nth one is n probes from home.
+  ht_init(&table, ht_test_constant_hash, &data_compare_int);
+  for (i = 0; i < 20; i++) {
+    allocated = table.allocated;
+    ht_insert(&table, LLINT(i), LLINT(i));
+    resizes += table.allocated != allocated;
+  }
+  ht_remove(&table, LLINT(19), &status);
+  ht_stats(&table, &stats);
+  TA_INT_EQ(stats.length, 19);
+  TA_INT_EQ(stats.allocated, table.allocated);
+  TA_INT_EQ(stats.graves, 1);
+  TA_INT_EQ(stats.max_probe_length, 19);
+  for (i = 0; i < HT_STATS_PROBES - 1; i++) {
+    TA_INT_EQ(stats.probe_lengths[i], 1);
+  }
+  TA_INT_EQ(stats.probe_lengths[HT_STATS_PROBES - 1], 19 - i);
+  TA_INT_EQ(stats.resizes, resizes);
+  TEST_ASSERT(resizes > 0);
+  TA_SIZE_EQ(stats.bytes, sizeof(smb_ht) + table.allocated * sizeof(smb_ht_bckt));
+  ht_destroy(&table);
+
+  // No key collides, so every lookup probes one slot.
+  ht_init(&table, ht_test_linear_hash, &data_compare_int);
+  for (i = 0; i < 10; i++) {
+    ht_insert(&table, LLINT(i), LLINT(i));
+  }
+  for (i = 0; i < 15; i++) {
+    ht_get(&table, LLINT(i), &status);
+  }
+  ht_stats(&table, &stats);
+  TA_INT_EQ(stats.probe_lengths[0], 10);
+  TA_INT_EQ(stats.max_probe_length, 1);
+#ifdef SMB_HT_STATS
+  TA_INT_EQ(stats.lookups, 25);
+  TA_INT_EQ(stats.hits, 10);
+  TA_INT_EQ(stats.probes, 25);
+#else
+  TA_INT_EQ(stats.lookups + stats.hits + stats.probes, 0);
+#endif
+  ht_destroy(&table);
+  return 0;
+}
+
+/**
+   Set operations give the right keys, keep the first table's values, and see
+   keys still in an old table.
+ */
+int ht_test_set_ops()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ht a, b, out;
+  long long i;
+
+  // a holds the evens below 2000, and is partway through a rehash.
+  ht_init(&a, ht_int_hash, &data_compare_int);
+  ht_set_incremental(&a, true);
+  for (i = 0; i < 2000; i += 2) {
+    ht_insert(&a, LLINT(i), LLINT(i));
+  }
+  ht_reserve(&a, 4000);
+  TEST_ASSERT(a.old != NULL);
+  // b holds the multiples of 3 below 3000.
+  ht_init(&b, ht_int_hash, &data_compare_int);
+  for (i = 0; i < 3000; i += 3) {
+    ht_insert(&b, LLINT(i), LLINT(-i));
+  }
+
+  ht_union(&out, &a, &b);
+  TA_INT_EQ(out.length, 1000 + 1000 - 334);
+  TA_LLINT_EQ(ht_get(&out, LLINT(6), &status).data_llint, 6);
+  TA_LLINT_EQ(ht_get(&out, LLINT(9), &status).data_llint, -9);
+  TA_LLINT_EQ(ht_get(&out, LLINT(1998), &status).data_llint, 1998);
+  TA_LLINT_EQ(ht_get(&out, LLINT(2997), &status).data_llint, -2997);
+  TEST_ASSERT(ht_is_subset(&a, &out) && ht_is_subset(&b, &out));
+  ht_destroy(&out);
+
+  ht_intersection(&out, &b, &a);
+  TA_INT_EQ(out.length, 334);
+  for (i = 0; i < 2000; i++) {
+    TA_INT_EQ(ht_contains(&out, LLINT(i)), i % 6 == 0);
+  }
+  TA_LLINT_EQ(ht_get(&out, LLINT(6), &status).data_llint, -6);
+  ht_destroy(&out);
+
+  ht_difference(&out, &a, &b);
+  TA_INT_EQ(out.length, 1000 - 334);
+  TEST_ASSERT(ht_contains(&out, LLINT(4)));
+  TEST_ASSERT(!ht_contains(&out, LLINT(6)));
+  TEST_ASSERT(!ht_is_subset(&a, &b));
+  TEST_ASSERT(ht_is_subset(&out, &a));
+  TEST_ASSERT(!ht_is_subset(&a, &out));
+  ht_destroy(&out);
+
+  ht_destroy(&a);
+  ht_destroy(&b);
+  return 0;
+}
+
 void hash_table_test()
 {
   smb_ut_group *group = su_create_test_group("test/hashtabletest.c");
@@ -337,6 +688,30 @@ void hash_table_test()
   smb_ut_test *test_iterator = su_create_test("test_iterator", ht_test_iterator);
   su_add_test(group, test_iterator);
 
+  smb_ut_test *pow2 = su_create_test("pow2", ht_test_pow2);
+  su_add_test(group, pow2);
+
+  smb_ut_test *churn = su_create_test("churn", ht_test_churn);
+  su_add_test(group, churn);
+
+  smb_ut_test *shrink = su_create_test("shrink", ht_test_shrink);
+  su_add_test(group, shrink);
+
+  smb_ut_test *incremental = su_create_test("incremental", ht_test_incremental);
+  su_add_test(group, incremental);
+
+  smb_ut_test *upsert = su_create_test("upsert", ht_test_upsert);
+  su_add_test(group, upsert);
+
+  smb_ut_test *reserve = su_create_test("reserve", ht_test_reserve);
+  su_add_test(group, reserve);
+
+  smb_ut_test *stats = su_create_test("stats", ht_test_stats);
+  su_add_test(group, stats);
+
+  smb_ut_test *set_ops = su_create_test("set_ops", ht_test_set_ops);
+  su_add_test(group, set_ops);
+
   su_run_group(group);
   su_delete_group(group);
 }
@@ -0,0 +1,212 @@
+/***************************************************************************//**
+
+  @file         hashtest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the hash functions.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+#include "libstephen/ut.h"
+#include "libstephen/hash.h"
+#include "libstephen/ht.h"
+#include "libstephen/hta.h"
+
+#define HASH_TEST_KEYS 100000
+
+static int compare_u64(const void *left, const void *right)
+{
+  uint64_t l = *(const uint64_t *) left, r = *(const uint64_t *) right;
+  return (l > r) - (l < r);
+}
+
+/**
+   The hash of some bytes doesn't depend on where they are in memory.
+ */
+static int hash_test_alignment(void)
+{
+  char buf[128 + 8], copy[128 + 8];
+  size_t len, off;
+
+  for (len = 0; len < sizeof(buf) - 8; len++) {
+    buf[len] = (char) (len * 7 + 1);
+  }
+  for (len = 0; len <= 128; len++) {
+    uint64_t expected = hash_bytes(buf, len, 1);
+    for (off = 1; off < 8; off++) {
+      memcpy(copy + off, buf, len);
+      TA_LLINT_EQ((long long) hash_bytes(copy + off, len, 1),
+                  (long long) expected);
+    }
+  }
+  TA_LLINT_EQ((long long) hash_string("abc", 0),
+              (long long) hash_bytes("abc", 3, 0));
+  TA_LLINT_EQ((long long) hash_string(NULL, 0),
+              (long long) hash_bytes("", 0, 0));
+  return 0;
+}
+
+/**
+   Prefixes of a string, and the same string with different seeds, all hash
+   differently.
+ */
+static int hash_test_distinct(void)
+{
+  const char *str = "the quick brown fox jumps over the lazy dog, twice over";
+  uint64_t hashes[64];
+  size_t i, n = 0, len = strlen(str);
+
+  for (i = 0; i <= len; i++) {
+    hashes[n++] = hash_bytes(str, i, 0);
+  }
+  for (i = 1; i < 8; i++) {
+    hashes[n++] = hash_bytes(str, len, i);
+  }
+  qsort(hashes, n, sizeof(uint64_t), compare_u64);
+  for (i = 1; i < n; i++) {
+    TEST_ASSERT(hashes[i] != hashes[i - 1]);
+  }
+  return 0;
+}
+
+/**
+   Flipping any one input bit flips about half of the output bits.
+ */
+static int hash_test_avalanche(void)
+{
+  unsigned char buf[40] = {0};
+  uint64_t base = hash_bytes(buf, sizeof(buf), 0);
+  long total = 0;
+  size_t bit;
+
+  for (bit = 0; bit < 8 * sizeof(buf); bit++) {
+    buf[bit / 8] ^= 1 << (bit % 8);
+    total += __builtin_popcountll(hash_bytes(buf, sizeof(buf), 0) ^ base);
+    buf[bit / 8] ^= 1 << (bit % 8);
+  }
+  total /= 8 * sizeof(buf);
+  TEST_ASSERT(total >= 28 && total <= 36);
+
+  total = 0;
+  for (bit = 0; bit < 64; bit++) {
+    total += __builtin_popcountll(hash_int(1ull << bit, 0) ^ hash_int(0, 0));
+  }
+  total /= 64;
+  TEST_ASSERT(total >= 28 && total <= 36);
+  return 0;
+}
+
+/**
+   URL-like keys, which differ only in a few digits, don't collide.
+ */
+static int hash_test_collisions(void)
+{
+  uint64_t *hashes = calloc(HASH_TEST_KEYS, sizeof(uint64_t));
+  unsigned int *folded = calloc(HASH_TEST_KEYS, sizeof(unsigned int));
+  char key[64];
+  size_t i, collisions = 0;
+
+  for (i = 0; i < HASH_TEST_KEYS; i++) {
+    sprintf(key, "https://example.com/users/%zu/items/%zu", i % 317, i / 317);
+    hashes[i] = hash_string(key, 0);
+    folded[i] = ht_fast_string_hash(PTR(key));
+  }
+  qsort(hashes, HASH_TEST_KEYS, sizeof(uint64_t), compare_u64);
+  for (i = 1; i < HASH_TEST_KEYS; i++) {
+    TEST_ASSERT(hashes[i] != hashes[i - 1]);
+  }
+
+  // About one 32 bit collision is expected among this many random values.
+  for (i = 0; i < HASH_TEST_KEYS; i++) {
+    hashes[i] = folded[i];
+  }
+  qsort(hashes, HASH_TEST_KEYS, sizeof(uint64_t), compare_u64);
+  for (i = 1; i < HASH_TEST_KEYS; i++) {
+    collisions += hashes[i] == hashes[i - 1];
+  }
+  TEST_ASSERT(collisions < 10);
+
+  free(hashes);
+  free(folded);
+  return 0;
+}
+
+/**
+   The adapters work in tables, and the seed changes them.
+ */
+static int hash_test_adapters(void)
+{
+  smb_status status = SMB_SUCCESS;
+  char *keys[] = {"alpha", "beta", "gamma"};
+  int i, ikey, value;
+  long long lkey = 1ll << 40;
+  char record[1 + sizeof(long long)];
+  smb_ht ht;
+  smb_hta hta;
+
+  ht_init(&ht, ht_fast_string_hash, &data_compare_string);
+  for (i = 0; i < 3; i++) {
+    ht_insert(&ht, PTR(keys[i]), LLINT(i));
+  }
+  TA_LLINT_EQ(ht_get(&ht, PTR("gamma"), &status).data_llint, 2);
+  ht_destroy(&ht);
+
+  hta_init(&hta, hta_fast_string_hash, &hta_string_comp, sizeof(char *),
+           sizeof(int));
+  for (i = 0; i < 3; i++) {
+    hta_insert(&hta, &keys[i], &i);
+  }
+  memcpy(&value, hta_get(&hta, &keys[1], &status), sizeof(value));
+  TA_INT_EQ(value, 1);
+  hta_destroy(&hta);
+
+  ikey = 5;
+  unsigned int before = hta_int_hash(&ikey);
+  TA_INT_EQ(ht_int_hash(LLINT(5)), before);
+  TEST_ASSERT(hta_llint_hash(&lkey) != hta_llint_hash(&(long long){0}));
+  // Table keys are unaligned, like this one.
+  memcpy(record + 1, &ikey, sizeof(ikey));
+  TA_INT_EQ(hta_int_hash(record + 1), before);
+  memcpy(record + 1, &lkey, sizeof(lkey));
+  TA_INT_EQ(hta_llint_hash(record + 1), hta_llint_hash(&lkey));
+  hash_set_seed(12345);
+  TEST_ASSERT(hta_int_hash(&ikey) != before);
+  hash_random_seed();
+  hash_set_seed(0);
+  TA_INT_EQ(hta_int_hash(&ikey), before);
+  return 0;
+}
+
+void hash_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/hashtest.c");
+
+  smb_ut_test *alignment = su_create_test("alignment", hash_test_alignment);
+  su_add_test(group, alignment);
+
+  smb_ut_test *distinct = su_create_test("distinct", hash_test_distinct);
+  su_add_test(group, distinct);
+
+  smb_ut_test *avalanche = su_create_test("avalanche", hash_test_avalanche);
+  su_add_test(group, avalanche);
+
+  smb_ut_test *collisions = su_create_test("collisions", hash_test_collisions);
+  su_add_test(group, collisions);
+
+  smb_ut_test *adapters = su_create_test("adapters", hash_test_adapters);
+  su_add_test(group, adapters);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
@@ -14,9 +14,13 @@
 *******************************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "tests.h"
 #include "libstephen/ut.h"
+#include "libstephen/hash.h"
 #include "libstephen/ht.h"
 #include "libstephen/hta.h"
 
@@ -255,6 +259,666 @@ int hta_test_duplicate()
   return 0;
 }
 
+/**
+   Power of two tables must still spread out keys that only differ in their high
+   bits.  Values are a different size from keys, to check that resizing copies
+   the right bytes.
+ */
+static int hta_test_policy(smb_ht_policy policy)
+{
+  smb_status status = SMB_SUCCESS;
+  unsigned int i, key, n = 1000;
+  long long value, *rv;
+  smb_hta table;
+  hta_init_policy(&table, hta_test_linear_hash, &hta_int_comp, sizeof(int),
+                  sizeof(long long), policy);
+  TA_INT_EQ(table.allocated, HASH_TABLE_INITIAL_POW2);
+
+  for (i = 0; i < n; i++) {
+    key = i << 12;
+    value = -(long long)i;
+    hta_insert(&table, &key, &value);
+  }
+  TA_INT_EQ(table.length, n);
+  TA_INT_EQ(table.allocated & (table.allocated - 1), 0);
+
+  for (i = 0; i < n; i += 2) {
+    key = i << 12;
+    hta_remove(&table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  for (i = 0; i < n; i++) {
+    key = i << 12;
+    rv = hta_get(&table, &key, &status);
+    if (i % 2 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+    } else {
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_LLINT_EQ(*rv, -(long long)i);
+    }
+  }
+
+  hta_destroy(&table);
+  return 0;
+}
+
+int hta_test_pow2()
+{
+  return hta_test_policy(HT_POW2);
+}
+
+int hta_test_group()
+{
+  return hta_test_policy(HT_GROUP);
+}
+
+/**
+   Removing and inserting over and over fills a table with graves.  Lookups must
+   still terminate, and find what they should.
+ */
+int hta_test_group_graves()
+{
+  smb_status status = SMB_SUCCESS;
+  int key, value, *rv;
+  smb_hta table;
+  hta_init_policy(&table, hta_test_constant_hash, &hta_int_comp, sizeof(int),
+                  sizeof(int), HT_GROUP);
+
+  for (key = 0; key < 200; key++) {
+    value = -key;
+    hta_insert(&table, &key, &value);
+    if (key > 0) {
+      int prev = key - 1;
+      hta_remove(&table, &prev, &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+    }
+    TA_INT_EQ(table.length, 1);
+  }
+  TA_INT_EQ(table.allocated, HASH_TABLE_INITIAL_POW2);
+
+  key = 199;
+  rv = hta_get(&table, &key, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_INT_EQ(*rv, -199);
+  key = 5;
+  TEST_ASSERT(!hta_contains(&table, &key));
+
+  hta_destroy(&table);
+  return 0;
+}
+
+/**
+   Removing most of the keys shrinks the table, and the rest are still found.
+ */
+static int hta_test_shrink_policy(smb_ht_policy policy)
+{
+  smb_status status = SMB_SUCCESS;
+  unsigned int i, key, n = 1000, grown;
+  long long value, *rv;
+  smb_hta table;
+  hta_init_policy(&table, hta_test_linear_hash, &hta_int_comp, sizeof(int),
+                  sizeof(long long), policy);
+
+  for (i = 0; i < n; i++) {
+    key = i;
+    value = -(long long)i;
+    hta_insert(&table, &key, &value);
+  }
+  grown = table.allocated;
+
+  for (i = 10; i < n; i++) {
+    key = i;
+    hta_remove(&table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  TA_INT_EQ(table.length, 10);
+  TEST_ASSERT(table.allocated < grown / 8);
+  TEST_ASSERT(table.allocated >= ht_initial_size(policy));
+  for (i = 0; i < 10; i++) {
+    key = i;
+    rv = hta_get(&table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_LLINT_EQ(*rv, -(long long)i);
+  }
+
+  hta_destroy(&table);
+  return 0;
+}
+
+int hta_test_shrink()
+{
+  return hta_test_shrink_policy(HT_PRIME) || hta_test_shrink_policy(HT_POW2) ||
+    hta_test_shrink_policy(HT_GROUP);
+}
+
+/**
+   Incremental tables must find every key while a rehash is in progress, and
+   move only a few slots per change.
+ */
+static int hta_test_incremental_policy(smb_ht_policy policy)
+{
+  smb_status status = SMB_SUCCESS;
+  unsigned int i, key, n = 5000, migrated, rehashes = 0;
+  long long value, *rv;
+  smb_hta table;
+  hta_init_policy(&table, hta_test_linear_hash, &hta_int_comp, sizeof(int),
+                  sizeof(long long), policy);
+  hta_set_incremental(&table, true);
+
+  for (i = 0; i < n; i++) {
+    smb_hta *old = table.old;
+    migrated = table.migrated;
+    key = i;
+    value = -(long long)i;
+    hta_insert(&table, &key, &value);
+    if (table.old && table.old == old) {
+      TEST_ASSERT(table.migrated - migrated <= HASH_TABLE_MIGRATE_SLOTS);
+    } else if (table.old) {
+      rehashes++;
+    }
+    key = i / 2;
+    rv = hta_get(&table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_LLINT_EQ(*rv, -(long long)(i / 2));
+  }
+  TEST_ASSERT(rehashes > 0);
+  TA_INT_EQ(table.length, n);
+
+  // Remove keys from both tables, then finish the rehash.
+  while (!table.old) {
+    key = i++;
+    value = 0;
+    hta_insert(&table, &key, &value);
+  }
+  for (i = 0; i < n; i += 2) {
+    key = i;
+    hta_remove(&table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  hta_set_incremental(&table, false);
+  TA_PTR_EQ(table.old, NULL);
+  for (i = 0; i < n; i++) {
+    key = i;
+    TA_INT_EQ(hta_contains(&table, &key), i % 2 == 1);
+  }
+
+  hta_destroy(&table);
+  return 0;
+}
+
+int hta_test_incremental()
+{
+  return hta_test_incremental_policy(HT_PRIME) ||
+    hta_test_incremental_policy(HT_POW2) ||
+    hta_test_incremental_policy(HT_GROUP);
+}
+
+/**
+   Upserts find existing keys, and zero the values of new ones, and a reserved
+   table doesn't rehash while it's loaded.
+ */
+static int hta_test_upsert_policy(smb_ht_policy policy)
+{
+  unsigned int i, key, n = 10000, allocated;
+  smb_status status = SMB_SUCCESS;
+  bool inserted;
+  long long *value;
+  smb_hta table;
+  hta_init_policy(&table, hta_test_linear_hash, &hta_int_comp, sizeof(int),
+                  sizeof(long long), policy);
+
+  hta_reserve(&table, n);
+  allocated = table.allocated;
+  for (i = 0; i < 2 * n; i++) {
+    key = i % n;
+    value = hta_upsert(&table, &key, &inserted);
+    TA_INT_EQ(inserted, i < n);
+    TA_LLINT_EQ(*value, i < n ? 0 : key);
+    *value += key;
+  }
+  TA_INT_EQ(table.allocated, allocated);
+  TA_INT_EQ(table.length, n);
+
+  key = 7;
+  TA_LLINT_EQ(*(long long *) hta_get(&table, &key, &status), 14);
+
+  hta_destroy(&table);
+  return 0;
+}
+
+int hta_test_upsert()
+{
+  return hta_test_upsert_policy(HT_PRIME) || hta_test_upsert_policy(HT_POW2) ||
+    hta_test_upsert_policy(HT_GROUP);
+}
+
+/**
+   Stats count probe lengths (in groups for HT_GROUP), graves and lookups if
+   they're built in.
+ */
+static int hta_test_stats_policy(smb_ht_policy policy)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ht_stats stats;
+  unsigned int i, n = 40, total = 0;
+  smb_hta table;
+
+  hta_init_policy(&table, hta_test_constant_hash, &hta_int_comp, sizeof(int),
+                  sizeof(int), policy);
+  for (i = 0; i < n; i++) {
+    hta_insert(&table, &i, &i);
+  }
+  hta_remove(&table, &i, &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+  i = 0;
+  hta_remove(&table, &i, &status);
+  hta_stats(&table, &stats);
+  TA_INT_EQ(stats.length, n - 1);
+  TA_INT_EQ(stats.allocated, table.allocated);
+  TA_INT_EQ(stats.graves, 1);
+  for (i = 0; i < HT_STATS_PROBES; i++) {
+    total += stats.probe_lengths[i];
+  }
+  TA_INT_EQ(total, n - 1);
+  if (policy == HT_GROUP) {
+    // Colliding keys fill one group before moving on to the next.
+    TA_INT_EQ(stats.max_probe_length, (n - 1) / HTA_GROUP_SIZE + 1);
+  } else {
+    TA_INT_EQ(stats.max_probe_length, n);
+  }
+  TA_SIZE_EQ(stats.bytes, sizeof(smb_hta) + table.allocated *
+             (HTA_KEY_OFFSET + 2 * sizeof(int) + (policy == HT_GROUP)));
+  TEST_ASSERT(stats.resizes > 0);
+#ifdef SMB_HT_STATS
+  TA_INT_EQ(stats.lookups, n + 2);
+  TA_INT_EQ(stats.hits, 1);
+  TEST_ASSERT(stats.probes >= stats.lookups);
+#else
+  TA_INT_EQ(stats.lookups + stats.hits + stats.probes, 0);
+#endif
+  hta_destroy(&table);
+  return 0;
+}
+
+int hta_test_stats()
+{
+  return hta_test_stats_policy(HT_PRIME) || hta_test_stats_policy(HT_POW2) ||
+    hta_test_stats_policy(HT_GROUP);
+}
+
+/**
+   A saved table maps back with the same keys, and changing the mapped table
+   leaves the file alone.
+ */
+static int hta_test_save_policy(smb_ht_policy policy)
+{
+  char path[] = "/tmp/hta_test_XXXXXX";
+  int i, n = 5000;
+  long long value;
+  smb_status status = SMB_SUCCESS;
+  smb_hta table, mapped;
+
+  close(mkstemp(path));
+  hta_init_policy(&table, hta_int_hash, &hta_int_comp, sizeof(int),
+                  sizeof(long long), policy);
+  hta_set_incremental(&table, true);
+  for (i = 0; i < n; i++) {
+    value = -i;
+    hta_insert(&table, &i, &value);
+  }
+  for (i = 0; i < n; i += 2) {
+    hta_remove(&table, &i, &status);
+  }
+  hta_save(&table, path, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TEST_ASSERT(table.old == NULL);
+
+  for (int round = 0; round < 2; round++) {
+    hta_map(&mapped, path, hta_int_hash, &hta_int_comp, sizeof(int),
+            sizeof(long long), &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_INT_EQ(mapped.length, n / 2);
+    TA_INT_EQ(mapped.allocated, table.allocated);
+    for (i = 0; i < n; i++) {
+      TA_INT_EQ(hta_contains(&mapped, &i), i % 2);
+    }
+    i = 7;
+    TA_LLINT_EQ(*(long long *) hta_get(&mapped, &i, &status), -7);
+
+    // Writes go to private copies of pages, and rehashing leaves the mapping.
+    for (i = 0; i < n; i++) {
+      value = i;
+      hta_insert(&mapped, &i, &value);
+    }
+    i = 7;
+    TA_LLINT_EQ(*(long long *) hta_get(&mapped, &i, &status), 7);
+    hta_reserve(&mapped, 4 * n);
+    TEST_ASSERT(mapped.map == NULL);
+    TA_LLINT_EQ(*(long long *) hta_get(&mapped, &i, &status), 7);
+    hta_destroy(&mapped);
+  }
+
+  hta_destroy(&table);
+  unlink(path);
+  return 0;
+}
+
+int hta_test_save()
+{
+  return hta_test_save_policy(HT_PRIME) || hta_test_save_policy(HT_POW2) ||
+    hta_test_save_policy(HT_GROUP);
+}
+
+static unsigned int hta_test_offset_hash(void *key)
+{
+  return *(unsigned int *) key + 1;
+}
+
+/**
+   Files that don't match what the caller expects aren't mapped.
+ */
+int hta_test_map_errors()
+{
+  char path[] = "/tmp/hta_test_XXXXXX";
+  int i;
+  long long value = 1;
+  smb_status status = SMB_SUCCESS;
+  smb_hta table, mapped;
+
+  close(mkstemp(path));
+  hta_map(&mapped, path, hta_int_hash, &hta_int_comp, sizeof(int),
+          sizeof(long long), &status);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+
+  hta_init(&table, hta_test_linear_hash, &hta_int_comp, sizeof(int),
+           sizeof(long long));
+  for (i = 0; i < 100; i++) {
+    hta_insert(&table, &i, &value);
+  }
+  hta_save(&table, path, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  hta_destroy(&table);
+
+  // Wrong sizes, and a hash function the file doesn't name but which doesn't
+  // give the stored hashes.
+  hta_map(&mapped, path, hta_test_linear_hash, &hta_int_comp, sizeof(int),
+          sizeof(int), &status);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+  hta_map(&mapped, path, hta_int_hash, &hta_int_comp, sizeof(int),
+          sizeof(long long), &status);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+  hta_map(&mapped, path, hta_test_offset_hash, &hta_int_comp, sizeof(int),
+          sizeof(long long), &status);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+
+  // A seeded hash function needs the same seed.
+  hta_init(&table, hta_int_hash, &hta_int_comp, sizeof(int), sizeof(int));
+  hta_insert(&table, &i, &i);
+  hta_save(&table, path, &status);
+  hta_destroy(&table);
+  hash_set_seed(99);
+  hta_map(&mapped, path, hta_int_hash, &hta_int_comp, sizeof(int),
+          sizeof(int), &status);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+  hash_set_seed(0);
+  hta_map(&mapped, path, hta_int_hash, &hta_int_comp, sizeof(int),
+          sizeof(int), &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  hta_destroy(&mapped);
+
+  unlink(path);
+  hta_map(&mapped, path, hta_int_hash, &hta_int_comp, sizeof(int),
+          sizeof(int), &status);
+  TA_INT_EQ(status, SMB_IO_ERROR);
+  return 0;
+}
+
+/**
+   Byte offset of the number of slots in a saved table's header.
+ */
+#define HTA_TEST_ALLOCATED_OFFSET 36
+
+/**
+   Rewrite a saved (empty) table's file as though it had allocated slots, with
+   every slot empty, and return the status of mapping it.
+ */
+static smb_status hta_test_map_size(const char *path, smb_ht_policy policy,
+                                    uint32_t allocated)
+{
+  char header[64];
+  smb_status status = SMB_SUCCESS;
+  unsigned int record_size = HTA_KEY_OFFSET + sizeof(int) + sizeof(int);
+  smb_hta table;
+  FILE *f;
+
+  hta_init_policy(&table, hta_int_hash, &hta_int_comp, sizeof(int),
+                  sizeof(int), policy);
+  hta_save(&table, path, &status);
+  hta_destroy(&table);
+
+  f = fopen(path, "rb");
+  fread(header, 1, sizeof(header), f);
+  fclose(f);
+  memcpy(header + HTA_TEST_ALLOCATED_OFFSET, &allocated, sizeof(allocated));
+
+  f = fopen(path, "wb");
+  fwrite(header, 1, sizeof(header), f);
+  for (uint32_t i = 0; i < allocated * record_size; i++) {
+    fputc(0, f);
+  }
+  for (uint32_t i = 0; policy == HT_GROUP && i < allocated; i++) {
+    fputc(HTA_CTRL_EMPTY, f);
+  }
+  fclose(f);
+
+  hta_map(&table, path, hta_int_hash, &hta_int_comp, sizeof(int), sizeof(int),
+          &status);
+  if (status == SMB_SUCCESS) {
+    hta_destroy(&table);
+  }
+  return status;
+}
+
+/**
+   Files whose number of slots the policy can't probe aren't mapped.
+ */
+int hta_test_map_sizes()
+{
+  char path[] = "/tmp/hta_test_XXXXXX";
+  close(mkstemp(path));
+
+  // Sizes each policy really uses, to show the rewritten files are good.
+  TA_INT_EQ(hta_test_map_size(path, HT_PRIME, 61), SMB_SUCCESS);
+  TA_INT_EQ(hta_test_map_size(path, HT_POW2, 64), SMB_SUCCESS);
+  TA_INT_EQ(hta_test_map_size(path, HT_GROUP, 64), SMB_SUCCESS);
+
+  TA_INT_EQ(hta_test_map_size(path, HT_PRIME, 64), SMB_FORMAT_ERROR);
+  TA_INT_EQ(hta_test_map_size(path, HT_PRIME, 59), SMB_FORMAT_ERROR);
+  TA_INT_EQ(hta_test_map_size(path, HT_POW2, 48), SMB_FORMAT_ERROR);
+  TA_INT_EQ(hta_test_map_size(path, HT_POW2, 61), SMB_FORMAT_ERROR);
+  TA_INT_EQ(hta_test_map_size(path, HT_GROUP, 48), SMB_FORMAT_ERROR);
+  TA_INT_EQ(hta_test_map_size(path, HT_GROUP, 8), SMB_FORMAT_ERROR);
+
+  unlink(path);
+  return 0;
+}
+
+/**
+   Write key i of the arena test into buf: its digits, padded out to as many as
+   40 bytes, so some keys go inline and some to the arena.
+ */
+static smb_hta_bytes hta_test_arena_key(char *buf, int i)
+{
+  int length = snprintf(buf, 64, "%d", i);
+  while (length < i % 41) {
+    buf[length++] = 'a' + i % 26;
+  }
+  return HTA_BYTES(buf, length);
+}
+
+/**
+   Keys of any length are copied in, found by their bytes, and the arena is
+   compacted once enough of them are removed.
+ */
+static int hta_test_arena_policy(smb_ht_policy policy)
+{
+  char buf[64], copy[64];
+  smb_status status = SMB_SUCCESS;
+  int i, n = 5000;
+  size_t length;
+  smb_hta_bytes key;
+  smb_hta table;
+
+  hta_init_keys(&table, sizeof(int), policy);
+  hta_set_incremental(&table, true);
+  for (i = 0; i < n; i++) {
+    key = hta_test_arena_key(buf, i);
+    hta_insert(&table, &key, &i);
+  }
+  hta_insert(&table, &HTA_BYTES("", 0), &n);
+  TA_INT_EQ(table.length, n + 1);
+  for (i = 0; i < n; i++) {
+    key = hta_test_arena_key(buf, i);
+    memcpy(copy, buf, key.length);
+    key.data = copy;
+    TEST_ASSERT(hta_contains(&table, &key));
+  }
+  TEST_ASSERT(hta_contains(&table, &HTA_BYTES("", 0)));
+  TEST_ASSERT(!hta_contains(&table, &HTA_STR("not a key")));
+  key = hta_test_arena_key(buf, 40);
+  TA_INT_EQ(*(int *) hta_get(&table, &key, &status), 40);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  length = table.arena->length;
+  TEST_ASSERT(length > 0);
+
+  // Removing keys leaves their bytes in the arena, but the table shrinks,
+  // and rehashing compacts it.
+  for (i = 0; i < n - 100; i++) {
+    key = hta_test_arena_key(buf, i);
+    hta_remove(&table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  hta_set_incremental(&table, false);
+  TEST_ASSERT(table.arena->length < length / 2);
+  for (i = n - 100; i < n; i++) {
+    key = hta_test_arena_key(buf, i);
+    TA_INT_EQ(*(int *) hta_get(&table, &key, &status), i);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+
+  // Their keys aren't all in the records, so they can't be saved.
+  hta_save(&table, "/nonexistent/hta_test", &status);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+  hta_destroy(&table);
+  return 0;
+}
+
+int hta_test_arena()
+{
+  return hta_test_arena_policy(HT_PRIME) || hta_test_arena_policy(HT_POW2) ||
+    hta_test_arena_policy(HT_GROUP);
+}
+
+/**
+   Set operations work on sets with no values, and see keys still in an old
+   table.
+ */
+static int hta_test_set_ops_policy(smb_ht_policy policy)
+{
+  smb_hta a, b, out;
+  int i;
+
+  // a holds the evens below 2000, and is partway through a rehash.
+  hta_init_policy(&a, hta_int_hash, &hta_int_comp, sizeof(int), 0, policy);
+  hta_set_incremental(&a, true);
+  for (i = 0; i < 2000; i += 2) {
+    hta_insert(&a, &i, NULL);
+  }
+  hta_reserve(&a, 4000);
+  TEST_ASSERT(a.old != NULL);
+  // b holds the multiples of 3 below 3000.
+  hta_init_policy(&b, hta_int_hash, &hta_int_comp, sizeof(int), 0, policy);
+  for (i = 0; i < 3000; i += 3) {
+    hta_insert(&b, &i, NULL);
+  }
+
+  hta_union(&out, &a, &b);
+  TA_INT_EQ(out.length, 1000 + 1000 - 334);
+  TEST_ASSERT(hta_is_subset(&a, &out) && hta_is_subset(&b, &out));
+  hta_destroy(&out);
+
+  hta_intersection(&out, &b, &a);
+  TA_INT_EQ(out.length, 334);
+  for (i = 0; i < 2000; i++) {
+    TA_INT_EQ(hta_contains(&out, &i), i % 6 == 0);
+  }
+  hta_destroy(&out);
+
+  hta_difference(&out, &a, &b);
+  TA_INT_EQ(out.length, 1000 - 334);
+  i = 4;
+  TEST_ASSERT(hta_contains(&out, &i));
+  i = 6;
+  TEST_ASSERT(!hta_contains(&out, &i));
+  TEST_ASSERT(!hta_is_subset(&a, &b));
+  TEST_ASSERT(hta_is_subset(&out, &a));
+  TEST_ASSERT(!hta_is_subset(&a, &out));
+  hta_destroy(&out);
+
+  hta_destroy(&a);
+  hta_destroy(&b);
+  return 0;
+}
+
+/**
+   Set operations keep the first table's values, and work on tables made by
+   hta_init_keys().
+ */
+static int hta_test_set_ops_keys()
+{
+  char buf[64];
+  smb_status status = SMB_SUCCESS;
+  smb_hta a, b, out;
+  smb_hta_bytes key;
+  int i, value;
+
+  hta_init_keys(&a, sizeof(int), HT_POW2);
+  hta_init_keys(&b, sizeof(int), HT_POW2);
+  for (i = 0; i < 200; i++) {
+    key = hta_test_arena_key(buf, i);
+    hta_insert(&a, &key, &i);
+    key = hta_test_arena_key(buf, i + 100);
+    value = -i;
+    hta_insert(&b, &key, &value);
+  }
+
+  hta_union(&out, &b, &a);
+  TA_INT_EQ(out.length, 300);
+  key = hta_test_arena_key(buf, 150);
+  TA_INT_EQ(*(int *) hta_get(&out, &key, &status), -50);
+  key = hta_test_arena_key(buf, 50);
+  TA_INT_EQ(*(int *) hta_get(&out, &key, &status), 50);
+  hta_destroy(&out);
+
+  hta_intersection(&out, &a, &b);
+  TA_INT_EQ(out.length, 100);
+  key = hta_test_arena_key(buf, 150);
+  TA_INT_EQ(*(int *) hta_get(&out, &key, &status), 150);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  hta_destroy(&out);
+
+  hta_destroy(&a);
+  hta_destroy(&b);
+  return 0;
+}
+
+int hta_test_set_ops()
+{
+  return hta_test_set_ops_policy(HT_PRIME) ||
+    hta_test_set_ops_policy(HT_POW2) || hta_test_set_ops_policy(HT_GROUP) ||
+    hta_test_set_ops_keys();
+}
+
 void hta_test()
 {
   smb_ut_group *group = su_create_test_group("test/hta.c");
@@ -277,6 +941,42 @@ void hta_test()
   smb_ut_test *duplicate = su_create_test("duplicate", hta_test_duplicate);
   su_add_test(group, duplicate);
 
+  smb_ut_test *pow2 = su_create_test("pow2", hta_test_pow2);
+  su_add_test(group, pow2);
+
+  smb_ut_test *group_ = su_create_test("group", hta_test_group);
+  su_add_test(group, group_);
+
+  smb_ut_test *group_graves = su_create_test("group_graves", hta_test_group_graves);
+  su_add_test(group, group_graves);
+
+  smb_ut_test *shrink = su_create_test("shrink", hta_test_shrink);
+  su_add_test(group, shrink);
+
+  smb_ut_test *incremental = su_create_test("incremental", hta_test_incremental);
+  su_add_test(group, incremental);
+
+  smb_ut_test *upsert = su_create_test("upsert", hta_test_upsert);
+  su_add_test(group, upsert);
+
+  smb_ut_test *stats = su_create_test("stats", hta_test_stats);
+  su_add_test(group, stats);
+
+  smb_ut_test *save = su_create_test("save", hta_test_save);
+  su_add_test(group, save);
+
+  smb_ut_test *map_errors = su_create_test("map_errors", hta_test_map_errors);
+  su_add_test(group, map_errors);
+
+  smb_ut_test *map_sizes = su_create_test("map_sizes", hta_test_map_sizes);
+  su_add_test(group, map_sizes);
+
+  smb_ut_test *arena = su_create_test("arena", hta_test_arena);
+  su_add_test(group, arena);
+
+  smb_ut_test *set_ops = su_create_test("set_ops", hta_test_set_ops);
+  su_add_test(group, set_ops);
+
   su_run_group(group);
   su_delete_group(group);
 }
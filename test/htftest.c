@@ -0,0 +1,301 @@
+/***************************************************************************//**
+
+  @file         htftest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the frozen hash tables.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "tests.h"
+#include "libstephen/ut.h"
+#include "libstephen/hash.h"
+#include "libstephen/htf.h"
+
+static unsigned int htf_test_constant_hash(DATA key)
+{
+  (void) key;
+  return 4;
+}
+
+static unsigned int htf_test_hta_pair_hash(void *key)
+{
+  return *(unsigned int *) key / 2;
+}
+
+static unsigned int htf_test_offset_hash(void *key)
+{
+  return *(unsigned int *) key + 1;
+}
+
+/**
+   Every key gets its value back, and nothing else is found.
+ */
+static int htf_test_freeze()
+{
+  smb_status status = SMB_SUCCESS;
+  int i, n = 50000;
+  smb_ht table;
+  smb_ht_frozen frozen;
+
+  ht_init(&table, ht_int_hash, data_compare_int);
+  for (i = 0; i < n; i++) {
+    ht_insert(&table, LLINT(i), LLINT(3 * i));
+  }
+  ht_freeze(&table, &frozen);
+  ht_destroy(&table);
+
+  TA_INT_EQ(frozen.length, n);
+  TA_INT_EQ(frozen.allocated + frozen.noverflow, n);
+  for (i = 0; i < n; i++) {
+    TA_LLINT_EQ(ht_frozen_get(&frozen, LLINT(i), &status).data_llint, 3 * i);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  for (i = n; i < 2 * n; i++) {
+    TEST_ASSERT(!ht_frozen_contains(&frozen, LLINT(i)));
+  }
+  ht_frozen_get(&frozen, LLINT(-1), &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+
+  ht_frozen_destroy(&frozen);
+  return 0;
+}
+
+/**
+   Keys with equal hashes go to the overflow, and are still found.
+ */
+static int htf_test_overflow()
+{
+  smb_status status = SMB_SUCCESS;
+  int i, n = 100;
+  smb_ht table;
+  smb_ht_frozen frozen;
+
+  ht_init(&table, htf_test_constant_hash, data_compare_int);
+  for (i = 0; i < n; i++) {
+    ht_insert(&table, LLINT(i), LLINT(-i));
+  }
+  ht_freeze(&table, &frozen);
+  ht_destroy(&table);
+
+  TA_INT_EQ(frozen.allocated, 1);
+  TA_INT_EQ(frozen.noverflow, n - 1);
+  for (i = 0; i < n; i++) {
+    TA_LLINT_EQ(ht_frozen_get(&frozen, LLINT(i), &status).data_llint, -i);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  TEST_ASSERT(!ht_frozen_contains(&frozen, LLINT(n)));
+
+  ht_frozen_destroy(&frozen);
+  return 0;
+}
+
+/**
+   An empty table freezes, and finds nothing.
+ */
+static int htf_test_empty()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ht table;
+  smb_ht_frozen frozen;
+
+  ht_init(&table, ht_int_hash, data_compare_int);
+  ht_freeze(&table, &frozen);
+  ht_destroy(&table);
+
+  TA_INT_EQ(frozen.length, 0);
+  TEST_ASSERT(!ht_frozen_contains(&frozen, LLINT(0)));
+  ht_frozen_get(&frozen, LLINT(0), &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+
+  ht_frozen_destroy(&frozen);
+  return 0;
+}
+
+/**
+   Keys still in the old table of an incremental rehash are frozen too.
+ */
+static int htf_test_incremental()
+{
+  int i = 0, n;
+  smb_ht table;
+  smb_ht_frozen frozen;
+
+  ht_init(&table, ht_int_hash, data_compare_int);
+  ht_set_incremental(&table, true);
+  while (!table.old) {
+    ht_insert(&table, LLINT(i), LLINT(i));
+    i++;
+  }
+  n = i;
+  ht_freeze(&table, &frozen);
+  ht_destroy(&table);
+
+  TA_INT_EQ(frozen.length, n);
+  for (i = 0; i < n; i++) {
+    TEST_ASSERT(ht_frozen_contains(&frozen, LLINT(i)));
+  }
+
+  ht_frozen_destroy(&frozen);
+  return 0;
+}
+
+static int htf_test_hta_policy(smb_ht_policy policy)
+{
+  smb_status status = SMB_SUCCESS;
+  int i, n = 20000;
+  long long value;
+  smb_hta table;
+  smb_hta_frozen frozen;
+
+  // Pairs of keys share a hash, and every third key is removed.
+  hta_init_policy(&table, htf_test_hta_pair_hash, &hta_int_comp, sizeof(int),
+                  sizeof(long long), policy);
+  for (i = 0; i < n; i++) {
+    value = -i;
+    hta_insert(&table, &i, &value);
+  }
+  for (i = 0; i < n; i += 3) {
+    hta_remove(&table, &i, &status);
+  }
+  hta_freeze(&table, &frozen, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+
+  TA_INT_EQ(frozen.length, table.length);
+  for (i = 0; i < n; i++) {
+    TA_INT_EQ(hta_frozen_contains(&frozen, &i), i % 3 != 0);
+  }
+  i = 7;
+  TA_LLINT_EQ(*(long long *) hta_frozen_get(&frozen, &i, &status), -7);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  i = 9;
+  TEST_ASSERT(hta_frozen_get(&frozen, &i, &status) == NULL);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+
+  hta_frozen_destroy(&frozen);
+  hta_destroy(&table);
+  return 0;
+}
+
+static int htf_test_hta()
+{
+  return htf_test_hta_policy(HT_PRIME) || htf_test_hta_policy(HT_POW2) ||
+    htf_test_hta_policy(HT_GROUP);
+}
+
+/**
+   A saved table maps back with the same keys, and files that don't match
+   what the caller expects aren't mapped.
+ */
+static int htf_test_save()
+{
+  char path[] = "/tmp/htf_test_XXXXXX";
+  smb_status status = SMB_SUCCESS;
+  int i, n = 5000;
+  long long value;
+  smb_hta table;
+  smb_hta_frozen frozen, mapped;
+
+  close(mkstemp(path));
+  hta_frozen_map(&mapped, path, hta_int_hash, &hta_int_comp, sizeof(int),
+                 sizeof(long long), &status);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+
+  hta_init(&table, hta_int_hash, &hta_int_comp, sizeof(int),
+           sizeof(long long));
+  for (i = 0; i < n; i++) {
+    value = 2 * i;
+    hta_insert(&table, &i, &value);
+  }
+  hta_freeze(&table, &frozen, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  hta_destroy(&table);
+  hta_frozen_save(&frozen, path, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  hta_frozen_destroy(&frozen);
+
+  hta_frozen_map(&mapped, path, hta_int_hash, &hta_int_comp, sizeof(int),
+                 sizeof(long long), &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_INT_EQ(mapped.length, n);
+  for (i = 0; i < n; i++) {
+    TA_LLINT_EQ(*(long long *) hta_frozen_get(&mapped, &i, &status), 2 * i);
+  }
+  i = n;
+  TEST_ASSERT(!hta_frozen_contains(&mapped, &i));
+  hta_frozen_destroy(&mapped);
+
+  hta_frozen_map(&mapped, path, hta_int_hash, &hta_int_comp, sizeof(int),
+                 sizeof(int), &status);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+  hta_frozen_map(&mapped, path, htf_test_offset_hash, &hta_int_comp,
+                 sizeof(int), sizeof(long long), &status);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+
+  unlink(path);
+  hta_frozen_map(&mapped, path, hta_int_hash, &hta_int_comp, sizeof(int),
+                 sizeof(long long), &status);
+  TA_INT_EQ(status, SMB_IO_ERROR);
+  return 0;
+}
+
+/**
+   Tables made by hta_init_keys() can't be frozen, and fail without leaking.
+ */
+static int htf_test_hta_keys()
+{
+  smb_status status = SMB_SUCCESS;
+  int value = 1;
+  smb_hta table;
+  smb_hta_frozen frozen;
+
+  hta_init_keys(&table, sizeof(int), HT_POW2);
+  hta_insert(&table, &HTA_STR("a key long enough for the arena"), &value);
+  hta_freeze(&table, &frozen, &status);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+  TA_INT_EQ(frozen.length, 0);
+  hta_frozen_destroy(&frozen);
+  TA_INT_EQ(table.length, 1);
+
+  hta_destroy(&table);
+  return 0;
+}
+
+void htf_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/htftest.c");
+
+  smb_ut_test *freeze = su_create_test("freeze", htf_test_freeze);
+  su_add_test(group, freeze);
+
+  smb_ut_test *overflow = su_create_test("overflow", htf_test_overflow);
+  su_add_test(group, overflow);
+
+  smb_ut_test *empty = su_create_test("empty", htf_test_empty);
+  su_add_test(group, empty);
+
+  smb_ut_test *incremental = su_create_test("incremental",
+                                            htf_test_incremental);
+  su_add_test(group, incremental);
+
+  smb_ut_test *hta = su_create_test("hta", htf_test_hta);
+  su_add_test(group, hta);
+
+  smb_ut_test *save = su_create_test("save", htf_test_save);
+  su_add_test(group, save);
+
+  smb_ut_test *hta_keys = su_create_test("hta_keys", htf_test_hta_keys);
+  su_add_test(group, hta_keys);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
@@ -0,0 +1,144 @@
+/***************************************************************************//**
+
+  @file         htttest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the macro-generated hash tables.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <stdio.h>
+
+#include "tests.h"
+#include "libstephen/ut.h"
+#include "libstephen/htt.h"
+
+#define htt_test_constant_hash(key) 4u
+
+SMB_HT_DECLARE(htt_test_ii, int, long long, SMB_HT_INT_HASH, SMB_HT_INT_EQ)
+SMB_HT_DECLARE(htt_test_si, const char *, int, SMB_HT_STR_HASH, SMB_HT_STR_EQ)
+SMB_HT_DECLARE(htt_test_cc, int, int, htt_test_constant_hash, SMB_HT_INT_EQ)
+
+static int htt_test_int(void)
+{
+  smb_status status = SMB_SUCCESS;
+  int i, n = 20000;
+  htt_test_ii table;
+  htt_test_ii_init(&table);
+
+  for (i = -n; i < n; i++) {
+    htt_test_ii_insert(&table, i, 2ll * i);
+  }
+  TA_INT_EQ(table.length, 2 * n);
+  for (i = -n; i < n; i++) {
+    TA_LLINT_EQ(*htt_test_ii_get(&table, i, &status), 2ll * i);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  TEST_ASSERT(htt_test_ii_get(&table, n, &status) == NULL);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+
+  // Remove most of them, which shrinks the table.
+  unsigned int allocated = table.allocated;
+  for (i = -n; i < n - 10; i++) {
+    htt_test_ii_remove(&table, i, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  htt_test_ii_remove(&table, -n, &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+  TA_INT_EQ(table.length, 10);
+  TEST_ASSERT(table.allocated < allocated);
+  for (i = n - 10; i < n; i++) {
+    TEST_ASSERT(htt_test_ii_contains(&table, i));
+  }
+
+  htt_test_ii_destroy(&table);
+  return 0;
+}
+
+static int htt_test_string(void)
+{
+  smb_status status = SMB_SUCCESS;
+  const char *keys[] = {"alpha", "beta", "gamma", "delta"};
+  char copy[] = "gamma";
+  bool inserted;
+  unsigned int i, count = 0;
+  htt_test_si table;
+  htt_test_si_init(&table);
+
+  for (i = 0; i < 4; i++) {
+    *htt_test_si_upsert(&table, keys[i], &inserted) += i;
+    TEST_ASSERT(inserted);
+  }
+  // Keys are compared by contents, not address.
+  *htt_test_si_upsert(&table, copy, &inserted) += 10;
+  TEST_ASSERT(!inserted);
+  TA_INT_EQ(*htt_test_si_get(&table, "gamma", &status), 12);
+  TEST_ASSERT(!htt_test_si_contains(&table, "epsilon"));
+
+  for (i = htt_test_si_next(&table, 0); i < table.allocated;
+       i = htt_test_si_next(&table, i + 1)) {
+    TEST_ASSERT(htt_test_si_contains(&table, table.table[i].key));
+    count++;
+  }
+  TA_INT_EQ(count, 4);
+
+  htt_test_si_destroy(&table);
+  return 0;
+}
+
+/**
+   Colliding keys, removed and re-inserted, are still found past the graves,
+   and a reserved table doesn't rehash.
+ */
+static int htt_test_collisions(void)
+{
+  smb_status status = SMB_SUCCESS;
+  int i, round, n = 40;
+  unsigned int allocated;
+  htt_test_cc table;
+  htt_test_cc_init(&table);
+  htt_test_cc_reserve(&table, n);
+  allocated = table.allocated;
+
+  for (round = 0; round < 100; round++) {
+    for (i = 0; i < n; i++) {
+      htt_test_cc_insert(&table, i, round);
+    }
+    for (i = 0; i < n; i += 2) {
+      htt_test_cc_remove(&table, i, &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+    }
+    for (i = 0; i < n; i++) {
+      TA_INT_EQ(htt_test_cc_contains(&table, i), i % 2);
+    }
+  }
+  TA_INT_EQ(table.length, n / 2);
+  TA_INT_EQ(table.allocated, allocated);
+  TA_INT_EQ(*htt_test_cc_get(&table, 1, &status), 99);
+
+  htt_test_cc_destroy(&table);
+  return 0;
+}
+
+void htt_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/htttest.c");
+
+  smb_ut_test *int_ = su_create_test("int", htt_test_int);
+  su_add_test(group, int_);
+
+  smb_ut_test *string = su_create_test("string", htt_test_string);
+  su_add_test(group, string);
+
+  smb_ut_test *collisions = su_create_test("collisions", htt_test_collisions);
+  su_add_test(group, collisions);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
@@ -29,8 +29,14 @@ int main(int argc, char ** argv)
   sl_set_level(NULL, LEVEL_INFO);
   linked_list_test();
   array_list_test();
+  ala_test();
   hash_table_test();
   hta_test();
+  chta_test();
+  hash_test();
+  od_test();
+  htt_test();
+  htf_test();
   bit_field_test();
   iter_test();
   list_test();
@@ -41,6 +47,9 @@ int main(int argc, char ** argv)
   lex_test();
   codegen_test();
   pike_test();
+  backtrack_test();
+  jit_test();
+  sub_test();
   log_test();
   ringbuf_test();
   // return args_test_main(argc, argv);
@@ -0,0 +1,217 @@
+/***************************************************************************//**
+
+  @file         odtest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the ordered dict.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <stdio.h>
+
+#include "tests.h"
+#include "libstephen/ut.h"
+#include "libstephen/od.h"
+
+static unsigned int od_test_linear_hash(DATA key)
+{
+  return (unsigned int) key.data_llint;
+}
+
+/*
+  Check that iterating gives exactly these keys, in order.
+ */
+static int od_test_order(smb_od *table, const long long *expected, size_t n)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_iter it = od_get_iter(table);
+  size_t i = 0;
+
+  while (it.has_next(&it)) {
+    DATA key = it.next(&it, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TEST_ASSERT(i < n);
+    TA_LLINT_EQ(key.data_llint, expected[i++]);
+  }
+  TA_SIZE_EQ(i, n);
+  it.next(&it, &status);
+  TA_INT_EQ(status, SMB_STOP_ITERATION);
+  return 0;
+}
+
+static int od_test_insert(void)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_od *table = od_create(ht_string_hash, &data_compare_string);
+  char *keys[] = {"zebra", "apple", "mango"};
+
+  for (int i = 0; i < 3; i++) {
+    od_insert(table, PTR(keys[i]), LLINT(i));
+  }
+  TA_INT_EQ(table->length, 3);
+  TA_LLINT_EQ(od_get(table, PTR("apple"), &status).data_llint, 1);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  od_get(table, PTR("pear"), &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+  TEST_ASSERT(od_contains(table, PTR("mango")));
+  TEST_ASSERT(!od_contains(table, PTR("kiwi")));
+
+  // Iteration is in insertion order, not alphabetical or hash order.
+  smb_iter it = od_get_iter(table);
+  for (int i = 0; i < 3; i++) {
+    TA_STR_EQ((char *) it.next(&it, &status).data_ptr, keys[i]);
+  }
+  TEST_ASSERT(!it.has_next(&it));
+
+  od_delete(table);
+  return 0;
+}
+
+static int od_test_reorder(void)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_od table;
+  od_init(&table, od_test_linear_hash, &data_compare_int);
+
+  for (long long i = 5; i > 0; i--) {
+    od_insert(&table, LLINT(i), LLINT(i));
+  }
+  const long long all[] = {5, 4, 3, 2, 1};
+  TA_INT_EQ(od_test_order(&table, all, 5), 0);
+
+  // Overwriting stays in place, and removing then inserting moves to the end.
+  od_insert(&table, LLINT(4), LLINT(40));
+  od_remove(&table, LLINT(3), &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  od_remove(&table, LLINT(3), &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+  od_insert(&table, LLINT(5), LLINT(50));
+  od_insert(&table, LLINT(3), LLINT(30));
+  const long long moved[] = {5, 4, 2, 1, 3};
+  TA_INT_EQ(od_test_order(&table, moved, 5), 0);
+  TA_LLINT_EQ(od_get(&table, LLINT(4), &status).data_llint, 40);
+
+  od_destroy(&table);
+  return 0;
+}
+
+/**
+   Growing past each index width, with removals along the way, keeps every key
+   and the order.
+ */
+static int od_test_grow(void)
+{
+  smb_status status = SMB_SUCCESS;
+  long long i, n = 70000;
+  smb_od table;
+  od_init(&table, od_test_linear_hash, &data_compare_int);
+  TA_INT_EQ(table.width, 1);
+
+  for (i = 0; i < n; i++) {
+    od_insert(&table, LLINT(i * 1024), LLINT(-i));
+    if (i % 3 == 0) {
+      od_remove(&table, LLINT(i * 1024), &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+    }
+  }
+  TA_INT_EQ(table.width, 4);
+  TA_LLINT_EQ(table.length, n - (n + 2) / 3);
+
+  smb_iter it = od_get_iter(&table);
+  long long last = -1;
+  while (it.has_next(&it)) {
+    DATA key = it.next(&it, &status);
+    TEST_ASSERT(key.data_llint > last);
+    TEST_ASSERT(key.data_llint / 1024 - key.data_llint / 3072 * 3 != 0);
+    last = key.data_llint;
+  }
+  TA_INT_EQ(it.index, table.length);
+  for (i = 0; i < n; i++) {
+    DATA value = od_get(&table, LLINT(i * 1024), &status);
+    if (i % 3 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+    } else {
+      TA_LLINT_EQ(value.data_llint, -i);
+    }
+  }
+
+  od_destroy(&table);
+  return 0;
+}
+
+/**
+   Inserting and removing over and over doesn't grow the table.
+ */
+static int od_test_churn(void)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_od table;
+  od_init(&table, od_test_linear_hash, &data_compare_int);
+
+  for (long long i = 0; i < 10000; i++) {
+    od_insert(&table, LLINT(i), LLINT(i));
+    if (i >= 2) {
+      od_remove(&table, LLINT(i - 2), &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+    }
+  }
+  TA_INT_EQ(table.length, 2);
+  TA_INT_EQ(table.size, OD_INITIAL_SIZE);
+  const long long last[] = {9998, 9999};
+  TA_INT_EQ(od_test_order(&table, last, 2), 0);
+
+  od_destroy(&table);
+  return 0;
+}
+
+static int od_test_deleter_count;
+
+static void od_test_deleter(DATA value)
+{
+  (void) value;
+  od_test_deleter_count++;
+}
+
+static int od_test_destroy_act(void)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_od *table = od_create(od_test_linear_hash, &data_compare_int);
+  for (long long i = 0; i < 10; i++) {
+    od_insert(table, LLINT(i), LLINT(i));
+  }
+  od_test_deleter_count = 0;
+  od_remove_act(table, LLINT(0), od_test_deleter, &status);
+  TA_INT_EQ(od_test_deleter_count, 1);
+  od_delete_act(table, od_test_deleter);
+  TA_INT_EQ(od_test_deleter_count, 10);
+  return 0;
+}
+
+void od_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/odtest.c");
+
+  smb_ut_test *insert = su_create_test("insert", od_test_insert);
+  su_add_test(group, insert);
+
+  smb_ut_test *reorder = su_create_test("reorder", od_test_reorder);
+  su_add_test(group, reorder);
+
+  smb_ut_test *grow = su_create_test("grow", od_test_grow);
+  su_add_test(group, grow);
+
+  smb_ut_test *churn = su_create_test("churn", od_test_churn);
+  su_add_test(group, churn);
+
+  smb_ut_test *destroy_act = su_create_test("destroy_act", od_test_destroy_act);
+  su_add_test(group, destroy_act);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
@@ -0,0 +1,207 @@
+/***************************************************************************//**
+
+  @file         re_backtrack.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Backtracking matcher tests.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+  The backtracker has to give exactly the same answers as the Pike VM, so most
+  of these tests generate random regexes and inputs, and compare the two.
+
+*******************************************************************************/
+
+#include <string.h>
+#include <wchar.h>
+
+#include "libstephen/ut.h"
+#include "tests.h"
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+
+#define NPATTERNS 500
+#define NINPUTS 40
+#define MAXINPUT 12
+
+/*
+  Small, deterministic random number generator, so failures are reproducible.
+ */
+static unsigned long seed;
+static unsigned int rnd(unsigned int n)
+{
+  seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+  return (unsigned int)(seed >> 33) % n;
+}
+
+static void gen_regex(char *buf, size_t *len, int depth);
+
+static void gen_atom(char *buf, size_t *len, int depth)
+{
+  static const char *atoms[] = {
+    "a", "b", "c", ".", "[a-b]", "[^b]", "\\w", "\\S", "[ac]"
+  };
+  if (depth > 0 && rnd(4) == 0) {
+    buf[(*len)++] = '(';
+    gen_regex(buf, len, depth - 1);
+    buf[(*len)++] = ')';
+  } else {
+    const char *atom = atoms[rnd(nelem(atoms))];
+    strcpy(buf + *len, atom);
+    *len += strlen(atom);
+  }
+  switch (rnd(6)) {
+  case 0:
+    buf[(*len)++] = '*';
+    break;
+  case 1:
+    buf[(*len)++] = '+';
+    break;
+  case 2:
+    buf[(*len)++] = '?';
+    break;
+  default:
+    return;
+  }
+  if (rnd(3) == 0) {
+    buf[(*len)++] = '?';
+  }
+}
+
+static void gen_regex(char *buf, size_t *len, int depth)
+{
+  int nterms = 1 + rnd(3);
+  for (int i = 0; i < nterms; i++) {
+    gen_atom(buf, len, depth);
+  }
+  if (rnd(3) == 0) {
+    buf[(*len)++] = '|';
+    gen_regex(buf, len, depth);
+  }
+}
+
+static void gen_input(char *buf)
+{
+  int len = rnd(MAXINPUT + 1);
+  for (int i = 0; i < len; i++) {
+    buf[i] = "abcd"[rnd(4)];
+  }
+  buf[len] = '\0';
+}
+
+/*
+  Run both matchers on an input and require identical results.
+ */
+static int compare(Regex r, struct Input in, size_t len, bool anchored)
+{
+  size_t *pike_saved = NULL, *bt_saved = NULL;
+  size_t pike_start = 0, bt_start = 0;
+  ssize_t pike_match = pike(r.p, in, anchored, &pike_start, &pike_saved);
+  ssize_t bt_match = backtrack(r.p, in, len, anchored, &bt_start, &bt_saved);
+
+  TA_LLINT_EQ((long long)bt_match, (long long)pike_match);
+  if (pike_match != -1) {
+    TA_SIZE_EQ(bt_start, pike_start);
+    for (size_t i = 0; i < r.p->nsave; i++) {
+      TA_SIZE_EQ(bt_saved[i], pike_saved[i]);
+    }
+  } else {
+    TA_PTR_EQ(bt_saved, NULL);
+  }
+  free(pike_saved);
+  free(bt_saved);
+  return 0;
+}
+
+static int test_random(void)
+{
+  char pattern[1024];
+  char input[MAXINPUT + 1];
+  wchar_t winput[MAXINPUT + 1];
+  seed = 42;
+
+  for (int i = 0; i < NPATTERNS; i++) {
+    size_t len = 0;
+    gen_regex(pattern, &len, 3);
+    pattern[len] = '\0';
+    Regex r = recomp(pattern);
+
+    for (int j = 0; j < NINPUTS; j++) {
+      gen_input(input);
+      size_t ilen = strlen(input);
+      mbstowcs(winput, input, MAXINPUT + 1);
+      struct Input in = {.str=input, .wstr=NULL};
+      struct Input win = {.str=NULL, .wstr=winput};
+      if (compare(r, in, ilen, true) || compare(r, win, ilen, true) ||
+          compare(r, in, ilen, false) || compare(r, win, ilen, false)) {
+        printf("pattern: \"%s\", input: \"%s\"\n", pattern, input);
+        refree(r);
+        return 1;
+      }
+    }
+    refree(r);
+  }
+  return 0;
+}
+
+/*
+  Empty loops are where a backtracker would spin forever, so make sure the
+  visited bitmap cuts them off just like the Pike VM does.
+ */
+static int test_empty_loop(void)
+{
+  size_t *capture;
+  Regex r = recomp("(a*)*b");
+
+  TA_INT_EQ(reexec(r, "aab", &capture), 3);
+  TA_SIZE_EQ(capture[0], 0);
+  TA_SIZE_EQ(capture[1], 2);
+  free(capture);
+  TA_INT_EQ(reexec(r, "aac", NULL), -1);
+
+  refree(r);
+  return 0;
+}
+
+/*
+  Inputs too long for the visited bitmap must go to the Pike VM.
+ */
+static int test_long_input(void)
+{
+  size_t len = BACKTRACK_MAX_BITS;
+  char *input = malloc(len + 2);
+  Regex r = recomp("a*b");
+
+  memset(input, 'a', len);
+  input[len] = 'b';
+  input[len + 1] = '\0';
+  TA_LLINT_EQ((long long)reexec(r, input, NULL), (long long)len + 1);
+  input[len] = '\0';
+  TA_LLINT_EQ((long long)reexec(r, input, NULL), -1);
+
+  refree(r);
+  free(input);
+  return 0;
+}
+
+void backtrack_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/re_backtrack.c");
+
+  smb_ut_test *random = su_create_test("random", test_random);
+  su_add_test(group, random);
+
+  smb_ut_test *empty_loop = su_create_test("empty_loop", test_empty_loop);
+  su_add_test(group, empty_loop);
+
+  smb_ut_test *long_input = su_create_test("long_input", test_long_input);
+  su_add_test(group, long_input);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
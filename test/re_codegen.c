@@ -13,7 +13,9 @@
 
 *******************************************************************************/
 
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "libstephen/ut.h"
 #include "tests.h"
@@ -298,6 +300,171 @@ static int test_join_complex(void)
   return 0;
 }
 
+static int test_packed(void)
+{
+  Regex r = recomp("(a*?)[b-c]");
+
+  TA_SIZE_EQ(sizeof(PInstr), 8);
+  TA_SIZE_EQ(r.p->n, r.n);
+  TA_SIZE_EQ(r.p->nsave, 2);
+
+  TA_INT_EQ(r.p->code[0].code, Save);
+  TA_INT_EQ(r.p->code[0].arg, 0);
+  TA_INT_EQ(r.p->code[1].code, Split);
+  TA_INT_EQ(r.p->code[1].x, 3);
+  TA_INT_EQ(r.p->code[1].arg, 1);
+  TA_INT_EQ(r.p->code[2].code, Char);
+  TA_INT_EQ(r.p->code[2].arg, 'a');
+  TA_INT_EQ(r.p->code[3].code, Jump);
+  TA_INT_EQ(r.p->code[3].x, -2);
+  TA_INT_EQ(r.p->code[4].code, Save);
+  TA_INT_EQ(r.p->code[4].arg, 1);
+  TA_INT_EQ(r.p->code[5].code, Range);
+  TA_INT_EQ(r.p->code[5].arg, 0);
+  TA_SIZE_EQ(r.p->classes[0].n, 1);
+  TA_STRN_EQ(r.p->ranges + 2 * r.p->classes[0].start, "bc", 2);
+  TA_UINT_EQ(r.p->classes[0].bits['b' / 32], (3u << ('b' % 32)));
+  TA_INT_EQ(r.p->code[6].code, Match);
+
+  refree(r);
+  return 0;
+}
+
+static int test_rewritec(void)
+{
+  char *text = NULL;
+  size_t size = 0;
+  FILE *f = open_memstream(&text, &size);
+  Regex r = recomp("a*");
+
+  rewritec(r, "astar", f);
+  fclose(f);
+
+  TEST_ASSERT(strstr(text, "{.code=Split, .x=astar_instr + 1, .y=astar_instr + 3},") != NULL);
+  TEST_ASSERT(strstr(text, "{.code=Jump, .x=-2, .arg=0},") != NULL);
+  TEST_ASSERT(strstr(text, "const Regex astar = {.n=4, .i=astar_instr, .p=(Prog *) &astar_prog};") != NULL);
+
+  free(text);
+  refree(r);
+  return 0;
+}
+
+/*
+  re_fixture.c was written by rewritec(), and is compiled into the tests, so
+  this checks that its output compiles, links, and matches exactly like the
+  regex it came from.  If the generated code changes, regenerate it with:
+      regex -c re_fixture_email 'PATTERN' > test/re_fixture.c
+  where PATTERN is FIXTURE_PATTERN without the C escapes.
+ */
+#define FIXTURE_PATTERN "(\\w+)\\.(\\w+)@([a-z]+\\.)+(com|org|net)"
+extern const Regex re_fixture_email;
+
+static int compare_fixture(Regex r, Matcher *fm, Matcher *rm, const char *input)
+{
+  size_t nsave = renumsaves(r);
+  size_t *fsaved = NULL, *rsaved = NULL;
+  size_t fstart = 0, rstart = 0;
+  ssize_t fmatch, rmatch;
+
+  TA_SIZE_EQ(renumsaves(re_fixture_email), nsave);
+
+  fmatch = reexec(re_fixture_email, input, &fsaved);
+  rmatch = reexec(r, input, &rsaved);
+  TA_LLINT_EQ((long long)fmatch, (long long)rmatch);
+  for (size_t i = 0; rmatch != -1 && i < nsave; i++) {
+    TA_SIZE_EQ(fsaved[i], rsaved[i]);
+  }
+  free(fsaved);
+  free(rsaved);
+  fsaved = rsaved = NULL;
+
+  fmatch = research(re_fixture_email, input, &fstart, &fsaved);
+  rmatch = research(r, input, &rstart, &rsaved);
+  TA_LLINT_EQ((long long)fmatch, (long long)rmatch);
+  if (rmatch != -1) {
+    TA_SIZE_EQ(fstart, rstart);
+    for (size_t i = 0; i < nsave; i++) {
+      TA_SIZE_EQ(fsaved[i], rsaved[i]);
+    }
+  }
+  free(fsaved);
+  free(rsaved);
+
+  fmatch = rematch(fm, input);
+  rmatch = rematch(rm, input);
+  TA_LLINT_EQ((long long)fmatch, (long long)rmatch);
+  for (size_t i = 0; rmatch != -1 && i < nsave; i++) {
+    TA_SIZE_EQ(fm->saved[i], rm->saved[i]);
+  }
+  return 0;
+}
+
+static int test_rewritec_fixture(void)
+{
+  static const char *inputs[] = {
+    "john.smith@example.com", "a.b@c.org", "j_1.x2@mail.example.net",
+    "john.smith@example.edu", "john@example.com", "john.smith@example",
+    "john.smith@EXAMPLE.com", "john.smith@example.com and more",
+    "mail john.smith@example.com", "x.y@a.b.c.d.org.", ".@.com", "", "@",
+  };
+  Regex r = recomp(FIXTURE_PATTERN);
+  Matcher fm, rm;
+  reminit(&fm, re_fixture_email);
+  reminit(&rm, r);
+
+  // The fixture should have something to match, or this proves little.
+  TA_LLINT_EQ((long long)reexec(re_fixture_email, inputs[0], NULL), 22LL);
+
+  for (size_t i = 0; i < nelem(inputs); i++) {
+    if (compare_fixture(r, &fm, &rm, inputs[i])) {
+      printf("input: \"%s\"\n", inputs[i]);
+      remdestroy(&fm);
+      remdestroy(&rm);
+      refree(r);
+      return 1;
+    }
+  }
+
+  remdestroy(&fm);
+  remdestroy(&rm);
+  refree(r);
+  return 0;
+}
+
+/*
+  Code generation used to walk fragment lists on every join, which made compile
+  time quadratic in the length of the regex.  Large generated alternations
+  (think keyword lists) were painfully slow to compile.  This compiles about
+  100KB worth of alternation, and requires that it happens within a second.
+ */
+#define LARGE_PATTERN_SIZE (100 * 1024)
+#define LARGE_PATTERN_BUDGET CLOCKS_PER_SEC
+static int test_large_alternation(void)
+{
+  char *pattern = calloc(LARGE_PATTERN_SIZE + 16, sizeof(char));
+  char last[16];
+  size_t len = 0;
+  int nkeywords = 0;
+
+  while (len < LARGE_PATTERN_SIZE) {
+    len += sprintf(pattern + len, "%skw%06d", nkeywords ? "|" : "", nkeywords);
+    nkeywords++;
+  }
+  sprintf(last, "kw%06d", nkeywords - 1);
+
+  clock_t start = clock();
+  Regex r = recomp(pattern);
+  clock_t elapsed = clock() - start;
+
+  TA_SIZE_LT(elapsed, LARGE_PATTERN_BUDGET);
+  TA_INT_EQ(reexec(r, last, NULL), 8);
+  TA_INT_EQ(reexec(r, "kw", NULL), -1);
+
+  refree(r);
+  free(pattern);
+  return 0;
+}
+
 void codegen_test(void)
 {
   smb_ut_group *group = su_create_test_group("test/codegen.c");
@@ -344,6 +511,18 @@ void codegen_test(void)
   smb_ut_test *join_complex = su_create_test("join_complex", test_join_complex);
   su_add_test(group, join_complex);
 
+  smb_ut_test *packed = su_create_test("packed", test_packed);
+  su_add_test(group, packed);
+
+  smb_ut_test *rewritec_ = su_create_test("rewritec", test_rewritec);
+  su_add_test(group, rewritec_);
+
+  smb_ut_test *rewritec_fixture = su_create_test("rewritec_fixture", test_rewritec_fixture);
+  su_add_test(group, rewritec_fixture);
+
+  smb_ut_test *large_alternation = su_create_test("large_alternation", test_large_alternation);
+  su_add_test(group, large_alternation);
+
   su_run_group(group);
   su_delete_group(group);
 }
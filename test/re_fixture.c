@@ -0,0 +1,99 @@
+/*
+  Generated by rewritec(), do not edit.
+
+  Declare this regex wherever you use it with:
+      extern const Regex re_fixture_email;
+  It is static data, so it must not be passed to refree().
+ */
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+
+static char re_fixture_email_block1[] = {97, 122, 65, 90, 48, 57, 95, 95};
+static char re_fixture_email_block6[] = {97, 122, 65, 90, 48, 57, 95, 95};
+static char re_fixture_email_block11[] = {97, 122};
+
+static Instr re_fixture_email_instr[] = {
+  {.code=Save, .s=0},
+  {.code=Range, .s=4, .x=(Instr *) re_fixture_email_block1},
+  {.code=Split, .x=re_fixture_email_instr + 1, .y=re_fixture_email_instr + 3},
+  {.code=Save, .s=1},
+  {.code=Char, .c=46},
+  {.code=Save, .s=2},
+  {.code=Range, .s=4, .x=(Instr *) re_fixture_email_block6},
+  {.code=Split, .x=re_fixture_email_instr + 6, .y=re_fixture_email_instr + 8},
+  {.code=Save, .s=3},
+  {.code=Char, .c=64},
+  {.code=Save, .s=4},
+  {.code=Range, .s=1, .x=(Instr *) re_fixture_email_block11},
+  {.code=Split, .x=re_fixture_email_instr + 11, .y=re_fixture_email_instr + 13},
+  {.code=Char, .c=46},
+  {.code=Save, .s=5},
+  {.code=Split, .x=re_fixture_email_instr + 10, .y=re_fixture_email_instr + 16},
+  {.code=Save, .s=6},
+  {.code=Split, .x=re_fixture_email_instr + 18, .y=re_fixture_email_instr + 22},
+  {.code=Char, .c=99},
+  {.code=Char, .c=111},
+  {.code=Char, .c=109},
+  {.code=Jump, .x=re_fixture_email_instr + 30},
+  {.code=Split, .x=re_fixture_email_instr + 23, .y=re_fixture_email_instr + 27},
+  {.code=Char, .c=111},
+  {.code=Char, .c=114},
+  {.code=Char, .c=103},
+  {.code=Jump, .x=re_fixture_email_instr + 30},
+  {.code=Char, .c=110},
+  {.code=Char, .c=101},
+  {.code=Char, .c=116},
+  {.code=Save, .s=7},
+  {.code=Match},
+};
+
+static const PInstr re_fixture_email_code[] = {
+  {.code=Save, .x=0, .arg=0},
+  {.code=Range, .x=0, .arg=0},
+  {.code=Split, .x=-1, .arg=1},
+  {.code=Save, .x=0, .arg=1},
+  {.code=Char, .x=0, .arg=46},
+  {.code=Save, .x=0, .arg=2},
+  {.code=Range, .x=0, .arg=1},
+  {.code=Split, .x=-1, .arg=1},
+  {.code=Save, .x=0, .arg=3},
+  {.code=Char, .x=0, .arg=64},
+  {.code=Save, .x=0, .arg=4},
+  {.code=Range, .x=0, .arg=2},
+  {.code=Split, .x=-1, .arg=1},
+  {.code=Char, .x=0, .arg=46},
+  {.code=Save, .x=0, .arg=5},
+  {.code=Split, .x=-5, .arg=1},
+  {.code=Save, .x=0, .arg=6},
+  {.code=Split, .x=1, .arg=5},
+  {.code=Char, .x=0, .arg=99},
+  {.code=Char, .x=0, .arg=111},
+  {.code=Char, .x=0, .arg=109},
+  {.code=Jump, .x=9, .arg=0},
+  {.code=Split, .x=1, .arg=5},
+  {.code=Char, .x=0, .arg=111},
+  {.code=Char, .x=0, .arg=114},
+  {.code=Char, .x=0, .arg=103},
+  {.code=Jump, .x=4, .arg=0},
+  {.code=Char, .x=0, .arg=110},
+  {.code=Char, .x=0, .arg=101},
+  {.code=Char, .x=0, .arg=116},
+  {.code=Save, .x=0, .arg=7},
+  {.code=Match, .x=0, .arg=0},
+};
+
+static const PClass re_fixture_email_classes[] = {
+  {.bits={0x00000000, 0x03ff0000, 0x87fffffe, 0x07fffffe, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, .start=0, .n=4},
+  {.bits={0x00000000, 0x03ff0000, 0x87fffffe, 0x07fffffe, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, .start=4, .n=4},
+  {.bits={0x00000000, 0x00000000, 0x00000000, 0x07fffffe, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, .start=8, .n=1},
+};
+
+static const char re_fixture_email_ranges[] = {97, 122, 65, 90, 48, 57, 95, 95, 97, 122, 65, 90, 48, 57, 95, 95, 97, 122};
+
+static const Prog re_fixture_email_prog = {
+  .n=32, .nsave=8, .code=re_fixture_email_code,
+  .classes=re_fixture_email_classes, .ranges=re_fixture_email_ranges,
+};
+
+const Regex re_fixture_email = {.n=32, .i=re_fixture_email_instr, .p=(Prog *) &re_fixture_email_prog};
@@ -0,0 +1,263 @@
+/***************************************************************************//**
+
+  @file         re_jit.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Regex JIT tests.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+  Native code has to give exactly the same answers as reexec() and research(),
+  so these tests run a Matcher with remjit() against them on random regexes and
+  inputs.  Where there's no JIT, the Matcher uses the interpreters, and the
+  tests still pass.
+
+*******************************************************************************/
+
+#include <string.h>
+
+#include "libstephen/ut.h"
+#include "tests.h"
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+
+#define NPATTERNS 500
+#define NINPUTS 40
+#define MAXINPUT 24
+
+/*
+  Small, deterministic random number generator, so failures are reproducible.
+ */
+static unsigned long seed;
+static unsigned int rnd(unsigned int n)
+{
+  seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+  return (unsigned int)(seed >> 33) % n;
+}
+
+static void gen_regex(char *buf, size_t *len, int depth);
+
+/*
+  Atoms include a char with the high bit set, since the JIT has to load it the
+  same way InputIdx() does (signed for Char, unsigned for class bitmaps).
+ */
+static void gen_atom(char *buf, size_t *len, int depth)
+{
+  static const char *atoms[] = {
+    "a", "b", "c", ".", "[a-b]", "[^b]", "\\w", "\\S", "[ac]", "\xe9",
+    "[^\xe9]", "\\d"
+  };
+  if (depth > 0 && rnd(4) == 0) {
+    buf[(*len)++] = '(';
+    gen_regex(buf, len, depth - 1);
+    buf[(*len)++] = ')';
+  } else {
+    const char *atom = atoms[rnd(nelem(atoms))];
+    strcpy(buf + *len, atom);
+    *len += strlen(atom);
+  }
+  switch (rnd(6)) {
+  case 0:
+    buf[(*len)++] = '*';
+    break;
+  case 1:
+    buf[(*len)++] = '+';
+    break;
+  case 2:
+    buf[(*len)++] = '?';
+    break;
+  default:
+    return;
+  }
+  if (rnd(3) == 0) {
+    buf[(*len)++] = '?';
+  }
+}
+
+static void gen_regex(char *buf, size_t *len, int depth)
+{
+  int nterms = 1 + rnd(3);
+  for (int i = 0; i < nterms; i++) {
+    gen_atom(buf, len, depth);
+  }
+  if (rnd(3) == 0) {
+    buf[(*len)++] = '|';
+    gen_regex(buf, len, depth);
+  }
+}
+
+static void gen_input(char *buf)
+{
+  int len = rnd(MAXINPUT + 1);
+  for (int i = 0; i < len; i++) {
+    buf[i] = "abcd1 \xe9"[rnd(7)];
+  }
+  buf[len] = '\0';
+}
+
+/*
+  Match and search with the Matcher, and require the same results as reexec()
+  and research().
+ */
+static int compare(Regex r, Matcher *m, const char *input)
+{
+  size_t *saved = NULL;
+  size_t start = 0, mstart = 0;
+  size_t len = strlen(input);
+  struct Input in = {.str=input, .wstr=NULL};
+  ssize_t expected, actual;
+
+  expected = reexec(r, input, &saved);
+  actual = rematch(m, input);
+  TA_LLINT_EQ((long long)actual, (long long)expected);
+  if (expected != -1) {
+    for (size_t i = 0; i < m->p->nsave; i++) {
+      TA_SIZE_EQ(m->saved[i], saved[i]);
+    }
+  }
+  free(saved);
+  saved = NULL;
+
+  // Searching from an index is how resub() and friends use a Matcher.
+  for (size_t from = 0; from <= len && from < 3; from++) {
+    expected = research(r, input + from, &start, &saved);
+    actual = remsearch(m, in, len, from, &mstart);
+    TA_LLINT_EQ((long long)actual, (long long)expected);
+    if (expected != -1) {
+      TA_SIZE_EQ(mstart, start + from);
+      for (size_t i = 0; i < m->p->nsave; i++) {
+        TA_SIZE_EQ(m->saved[i], saved[i] + from);
+      }
+    }
+    free(saved);
+    saved = NULL;
+  }
+  return 0;
+}
+
+static int test_random(void)
+{
+  char pattern[1024];
+  char input[MAXINPUT + 1];
+  seed = 1234;
+
+  for (int i = 0; i < NPATTERNS; i++) {
+    size_t len = 0;
+    Matcher m;
+    gen_regex(pattern, &len, 3);
+    pattern[len] = '\0';
+    Regex r = recomp(pattern);
+    reminit(&m, r);
+    remjit(&m);
+
+    for (int j = 0; j < NINPUTS; j++) {
+      gen_input(input);
+      if (compare(r, &m, input)) {
+        printf("pattern: \"%s\", input: \"%s\"\n", pattern, input);
+        remdestroy(&m);
+        refree(r);
+        return 1;
+      }
+    }
+    remdestroy(&m);
+    refree(r);
+  }
+  return 0;
+}
+
+/*
+  The JIT is there whenever the library was built with it.
+ */
+static int test_available(void)
+{
+  Matcher m;
+  Regex r = recomp("(a|b)*c");
+  reminit(&m, r);
+#ifdef SMB_RE_JIT
+  TEST_ASSERT(remjit(&m));
+#endif
+  // A second call keeps the code it already has.
+  TA_INT_EQ(remjit(&m), m.jit != NULL);
+  TA_LLINT_EQ((long long)rematch(&m, "abbac"), 5LL);
+  TA_SIZE_EQ(m.saved[0], 3);
+  TA_SIZE_EQ(m.saved[1], 4);
+  TA_LLINT_EQ((long long)rematch(&m, "abba"), -1LL);
+  remdestroy(&m);
+  refree(r);
+  return 0;
+}
+
+/*
+  Empty loops must be cut off by the visited bitmap, in native code too.
+ */
+static int test_empty_loop(void)
+{
+  Matcher m;
+  Regex r = recomp("(a*)*b");
+  reminit(&m, r);
+  remjit(&m);
+
+  TA_LLINT_EQ((long long)rematch(&m, "aab"), 3LL);
+  TA_SIZE_EQ(m.saved[0], 0);
+  TA_SIZE_EQ(m.saved[1], 2);
+  TA_LLINT_EQ((long long)rematch(&m, "aac"), -1LL);
+
+  remdestroy(&m);
+  refree(r);
+  return 0;
+}
+
+/*
+  Wide strings and inputs too long for the visited bitmap go to the
+  interpreters, even with native code.
+ */
+static int test_fallback(void)
+{
+  size_t len = BACKTRACK_MAX_BITS;
+  char *input = malloc(len + 2);
+  Matcher m;
+  Regex r = recomp("(a*)b");
+  reminit(&m, r);
+  remjit(&m);
+
+  memset(input, 'a', len);
+  input[len] = 'b';
+  input[len + 1] = '\0';
+  TA_LLINT_EQ((long long)rematch(&m, input), (long long)len + 1);
+  TA_SIZE_EQ(m.saved[1], len);
+  input[len] = '\0';
+  TA_LLINT_EQ((long long)rematch(&m, input), -1LL);
+
+  TA_LLINT_EQ((long long)rematchw(&m, L"aab"), 3LL);
+  TA_SIZE_EQ(m.saved[1], 2);
+
+  remdestroy(&m);
+  refree(r);
+  free(input);
+  return 0;
+}
+
+void jit_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/re_jit.c");
+
+  smb_ut_test *random = su_create_test("random", test_random);
+  su_add_test(group, random);
+
+  smb_ut_test *available = su_create_test("available", test_available);
+  su_add_test(group, available);
+
+  smb_ut_test *empty_loop = su_create_test("empty_loop", test_empty_loop);
+  su_add_test(group, empty_loop);
+
+  smb_ut_test *fallback = su_create_test("fallback", test_fallback);
+  su_add_test(group, fallback);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
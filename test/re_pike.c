@@ -13,6 +13,8 @@
 
 *******************************************************************************/
 
+#include <stdlib.h>
+
 #include "libstephen/ut.h"
 #include "tests.h"
 
@@ -345,6 +347,112 @@ static int test_save_discard_stash_wide(void)
   return 0;
 }
 
+/*
+  A Regex put together by hand won't have a packed program, so reexec() should
+  pack one on the fly.
+ */
+static int test_unpacked(void)
+{
+  size_t *capture;
+  Regex r = recomp("(a*)b");
+  Regex u = {.n=r.n, .i=r.i, .p=NULL};
+
+  TA_INT_EQ(reexec(u, "aab", &capture), 3);
+  TA_SIZE_EQ(capture[0], 0);
+  TA_SIZE_EQ(capture[1], 2);
+  free(capture);
+  TA_INT_EQ(reexec(u, "aac", NULL), -1);
+
+  refree(r);
+  return 0;
+}
+
+static int test_rematch(void)
+{
+  Matcher m;
+  Regex r = recomp("(a*)b");
+  reminit(&m, r);
+
+  TA_INT_EQ(rematch(&m, "aab"), 3);
+  TA_SIZE_EQ(m.saved[0], 0);
+  TA_SIZE_EQ(m.saved[1], 2);
+  TA_INT_EQ(rematch(&m, "aac"), -1);
+  TA_INT_EQ(rematchw(&m, L"ab"), 2);
+  TA_SIZE_EQ(m.saved[1], 1);
+
+  remdestroy(&m);
+  refree(r);
+  return 0;
+}
+
+static int test_batch(void)
+{
+  const size_t n = 5000;
+  const char *inputs[] = {"abc", "aab", "b", "", "cab", "aaaaaaaab"};
+  const char **batch = calloc(n, sizeof(char *));
+  ssize_t *results = calloc(n, sizeof(ssize_t));
+  Regex r = recomp("(a*)b");
+  Regex u = {.n=r.n, .i=r.i, .p=NULL};
+
+  for (size_t i = 0; i < n; i++) {
+    batch[i] = inputs[i % nelem(inputs)];
+  }
+  int nthreads[] = {1, 4, 0};
+  for (size_t t = 0; t < nelem(nthreads); t++) {
+    rebatch(t == 2 ? u : r, batch, n, nthreads[t], results);
+    for (size_t i = 0; i < n; i++) {
+      TA_LLINT_EQ((long long)results[i], (long long)reexec(r, batch[i], NULL));
+    }
+  }
+  rebatch(r, batch, 0, 4, results);
+
+  refree(r);
+  free(batch);
+  free(results);
+  return 0;
+}
+
+/*
+  Literal programs must give the same results as the VM, which still runs
+  them when called directly.
+ */
+static int test_literal(void)
+{
+  const char *patterns[] = {"abc", "foo|bar|baz", "ab?c", "a|ab", "ab|a",
+                            "x?", "(a|b)(c|d)"};
+  const size_t nlits[] = {1, 3, 2, 2, 2, 2, 0};
+  const char *inputs[] = {"abc", "xabcx", "ac", "zzbaz", "barfoo", "ab", "",
+                          "bd", "aabab", "ba", "xxxxxxxxxxxxxxxxxxab"};
+
+  for (size_t i = 0; i < nelem(patterns); i++) {
+    Regex r = recomp((char *) patterns[i]);
+    TA_SIZE_EQ(r.p->nlit, nlits[i]);
+
+    for (size_t j = 0; j < nelem(inputs); j++) {
+      struct Input in = {.str=inputs[j], .wstr=NULL};
+      size_t start, expected_start;
+      ssize_t expected = pike(r.p, in, true, NULL, NULL);
+      TA_LLINT_EQ((long long)reexec(r, inputs[j], NULL), (long long)expected);
+
+      expected = pike(r.p, in, false, &expected_start, NULL);
+      ssize_t len = research(r, inputs[j], &start, NULL);
+      if (expected == -1) {
+        TA_LLINT_EQ((long long)len, -1);
+      } else {
+        TA_LLINT_EQ((long long)len, (long long)(expected - expected_start));
+        TA_SIZE_EQ(start, expected_start);
+      }
+    }
+    refree(r);
+  }
+
+  // Wide strings and captures still go through the VM.
+  Regex r = recomp("a|ab");
+  TA_INT_EQ(reexecw(r, L"ab", NULL), 1);
+  refree(r);
+  return 0;
+}
+
 void pike_test(void)
 {
   smb_ut_group *group = su_create_test_group("test/re_pike.c");
@@ -403,6 +511,18 @@ void pike_test(void)
   smb_ut_test *save_discard_stash_wide = su_create_test("save_discard_stash_wide", test_save_discard_stash_wide);
   su_add_test(group, save_discard_stash_wide);
 
+  smb_ut_test *unpacked = su_create_test("unpacked", test_unpacked);
+  su_add_test(group, unpacked);
+
+  smb_ut_test *rematch_ = su_create_test("rematch", test_rematch);
+  su_add_test(group, rematch_);
+
+  smb_ut_test *batch = su_create_test("batch", test_batch);
+  su_add_test(group, batch);
+
+  smb_ut_test *literal = su_create_test("literal", test_literal);
+  su_add_test(group, literal);
+
   su_run_group(group);
   su_delete_group(group);
 }
@@ -0,0 +1,282 @@
+/***************************************************************************//**
+
+  @file         re_sub.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Regex search, substitution and splitting tests.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+#include "libstephen/ut.h"
+#include "tests.h"
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+#include "libstephen/cb.h"
+
+/*
+  Substitute and check the result, returning the number of substitutions.
+ */
+static size_t sub(const char *regex, const char *input, const char *repl,
+                  size_t max, const char *expected)
+{
+  cbuf cb;
+  Regex r = recomp((char *) regex);
+  cb_init(&cb, 16);
+  size_t count = resubn(r, input, repl, max, &cb);
+  if (strcmp(cb.buf, expected) != 0) {
+    printf("resub(\"%s\", \"%s\", \"%s\") = \"%s\", expected \"%s\"\n",
+           regex, input, repl, cb.buf, expected);
+    count = (size_t) -1;
+  }
+  cb_destroy(&cb);
+  refree(r);
+  return count;
+}
+
+static int test_research(void)
+{
+  Regex r = recomp("b(c+)");
+  size_t start, *saved;
+
+  TA_LLINT_EQ((long long)research(r, "aabccd", &start, &saved), 3);
+  TA_SIZE_EQ(start, 2);
+  TA_SIZE_EQ(saved[0], 3);
+  TA_SIZE_EQ(saved[1], 5);
+  free(saved);
+
+  TA_LLINT_EQ((long long)researchw(r, L"xbc", &start, NULL), 2);
+  TA_SIZE_EQ(start, 1);
+  TA_LLINT_EQ((long long)research(r, "abd", &start, NULL), -1);
+
+  refree(r);
+  return 0;
+}
+
+static int test_basic(void)
+{
+  TA_SIZE_EQ(sub("o", "foo boo", "0", -1, "f00 b00"), 4);
+  TA_SIZE_EQ(sub("xyz", "foo boo", "0", -1, "foo boo"), 0);
+  TA_SIZE_EQ(sub("o+", "foo boo", "", -1, "f b"), 2);
+  TA_SIZE_EQ(sub("foo", "foo", "bar", -1, "bar"), 1);
+  return 0;
+}
+
+static int test_groups(void)
+{
+  TA_SIZE_EQ(sub("(\\w+)=(\\w+)", "a=1, bc=23", "$2=$1", -1, "1=a, 23=bc"), 2);
+  TA_SIZE_EQ(sub("b+", "abbc", "[$0]", -1, "a[bb]c"), 1);
+  TA_SIZE_EQ(sub("(b)", "abc", "${1}${1}", -1, "abbc"), 1);
+  TA_SIZE_EQ(sub("b", "abc", "$$", -1, "a$c"), 1);
+  // Missing groups expand to nothing, and other dollar signs are literal.
+  TA_SIZE_EQ(sub("(b)", "abc", "$5", -1, "ac"), 1);
+  TA_SIZE_EQ(sub("b", "abc", "$x${", -1, "a$x${c"), 1);
+  return 0;
+}
+
+static int test_max(void)
+{
+  TA_SIZE_EQ(sub("a", "aaaa", "b", 2, "bbaa"), 2);
+  TA_SIZE_EQ(sub("a", "aaaa", "b", 0, "aaaa"), 0);
+  return 0;
+}
+
+static int test_empty(void)
+{
+  TA_SIZE_EQ(sub("a*", "baaac", "-", -1, "-b--c-"), 4);
+  TA_SIZE_EQ(sub("x*", "", "-", -1, "-"), 1);
+  return 0;
+}
+
+static int test_wide(void)
+{
+  wcbuf wcb;
+  Regex r = recomp("(\\w)(\\w)");
+  wcb_init(&wcb, 16);
+
+  TA_SIZE_EQ(resubw(r, L"ab cd e", L"$2$1", &wcb), 2);
+  TA_INT_EQ(wcscmp(wcb.buf, L"ba dc e"), 0);
+
+  wcb_destroy(&wcb);
+  refree(r);
+  return 0;
+}
+
+/*
+  Split and check each field against a list of expected strings.
+ */
+static int split(Matcher *m, const char *input, size_t max, size_t nexpected,
+                 const char **expected)
+{
+  Slice out[8];
+  TA_SIZE_EQ(resplit(m, input, max, out, 8), nexpected);
+  for (size_t i = 0; i < nexpected; i++) {
+    TA_SIZE_EQ(out[i].length, strlen(expected[i]));
+    TA_INT_EQ(strncmp(input + out[i].offset, expected[i], out[i].length), 0);
+  }
+  return 0;
+}
+
+static int test_split(void)
+{
+  Matcher m;
+  Regex r = recomp(",\\s*");
+  reminit(&m, r);
+
+  const char *fields[] = {"a", "bc", "", "d"};
+  TA_INT_EQ(split(&m, "a, bc,,   d", 0, 4, fields), 0);
+  const char *one[] = {"abc"};
+  TA_INT_EQ(split(&m, "abc", 0, 1, one), 0);
+  const char *none[] = {""};
+  TA_INT_EQ(split(&m, "", 0, 1, none), 0);
+  const char *ends[] = {"", "a", ""};
+  TA_INT_EQ(split(&m, ",a,", 0, 3, ends), 0);
+
+  remdestroy(&m);
+  refree(r);
+  return 0;
+}
+
+static int test_split_max(void)
+{
+  Matcher m;
+  Regex r = recomp(" ");
+  Slice out[2];
+  reminit(&m, r);
+
+  const char *limited[] = {"a", "b", "c d"};
+  TA_INT_EQ(split(&m, "a b c d", 3, 3, limited), 0);
+  const char *whole[] = {"a b c d"};
+  TA_INT_EQ(split(&m, "a b c d", 1, 1, whole), 0);
+
+  // The count is returned even when the array is too small.
+  TA_SIZE_EQ(resplit(&m, "a b c d", 0, out, 2), 4);
+  TA_SIZE_EQ(out[1].offset, 2);
+
+  remdestroy(&m);
+  refree(r);
+  return 0;
+}
+
+static int test_split_empty(void)
+{
+  Matcher m;
+  Regex r = recomp("x*");
+  reminit(&m, r);
+
+  // Empty matches never separate fields.
+  const char *fields[] = {"a", "b", "c"};
+  TA_INT_EQ(split(&m, "axbxxc", 0, 3, fields), 0);
+  const char *plain[] = {"abc"};
+  TA_INT_EQ(split(&m, "abc", 0, 1, plain), 0);
+
+  remdestroy(&m);
+  refree(r);
+  return 0;
+}
+
+/*
+  Long inputs are searched with the Pike VM instead of the backtracker.
+ */
+static int test_split_long(void)
+{
+  Matcher m;
+  Regex r = recomp(",");
+  size_t len = BACKTRACK_MAX_BITS;
+  char *input = malloc(len + 1);
+  Slice out[3];
+  reminit(&m, r);
+
+  memset(input, 'a', len);
+  input[len] = '\0';
+  input[10] = input[len - 10] = ',';
+  TA_SIZE_EQ(resplit(&m, input, 0, out, 3), 3);
+  TA_SIZE_EQ(out[1].offset, 11);
+  TA_SIZE_EQ(out[1].length, len - 21);
+  TA_SIZE_EQ(out[2].offset, len - 9);
+
+  remdestroy(&m);
+  refree(r);
+  free(input);
+  return 0;
+}
+
+static void count_length(Slice s, void *data)
+{
+  *(size_t *) data += s.length;
+}
+
+static int test_split_fn(void)
+{
+  Matcher m;
+  Regex r = recomp("\\s+");
+  Slice out[4];
+  size_t total = 0;
+  reminit(&m, r);
+
+  TA_SIZE_EQ(resplitf(&m, "ab  cde\tf", 0, count_length, &total), 3);
+  TA_SIZE_EQ(total, 6);
+
+  TA_SIZE_EQ(resplitw(&m, L"x y", 0, out, 4), 2);
+  TA_SIZE_EQ(out[1].offset, 2);
+  TA_SIZE_EQ(out[1].length, 1);
+
+  total = 0;
+  TA_SIZE_EQ(resplitfw(&m, L"xy z", 0, count_length, &total), 2);
+  TA_SIZE_EQ(total, 3);
+
+  remdestroy(&m);
+  refree(r);
+  return 0;
+}
+
+void sub_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/re_sub.c");
+
+  smb_ut_test *research = su_create_test("research", test_research);
+  su_add_test(group, research);
+
+  smb_ut_test *basic = su_create_test("basic", test_basic);
+  su_add_test(group, basic);
+
+  smb_ut_test *groups = su_create_test("groups", test_groups);
+  su_add_test(group, groups);
+
+  smb_ut_test *max = su_create_test("max", test_max);
+  su_add_test(group, max);
+
+  smb_ut_test *empty = su_create_test("empty", test_empty);
+  su_add_test(group, empty);
+
+  smb_ut_test *wide = su_create_test("wide", test_wide);
+  su_add_test(group, wide);
+
+  smb_ut_test *split = su_create_test("split", test_split);
+  su_add_test(group, split);
+
+  smb_ut_test *split_max = su_create_test("split_max", test_split_max);
+  su_add_test(group, split_max);
+
+  smb_ut_test *split_empty = su_create_test("split_empty", test_split_empty);
+  su_add_test(group, split_empty);
+
+  smb_ut_test *split_long = su_create_test("split_long", test_split_long);
+  su_add_test(group, split_long);
+
+  smb_ut_test *split_fn = su_create_test("split_fn", test_split_fn);
+  su_add_test(group, split_fn);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
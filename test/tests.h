@@ -23,6 +23,11 @@ void linked_list_test();
  */
 void array_list_test();
 
+/**
+   Run the inline record array list tests
+*/
+void ala_test(void);
+
 /**
    Run the hash table tests
  */
@@ -33,6 +38,31 @@ void hash_table_test();
 */
 void hta_test();
 
+/**
+   Run the concurrent hash table tests
+*/
+void chta_test(void);
+
+/**
+   Run the hash function tests
+*/
+void hash_test(void);
+
+/**
+   Run the ordered dict tests
+*/
+void od_test(void);
+
+/**
+   Run the macro-generated hash table tests
+*/
+void htt_test(void);
+
+/**
+   Run the frozen hash table tests
+*/
+void htf_test(void);
+
 /**
    Run the bit field tests
  */
@@ -75,6 +105,9 @@ void parse_test(void);
 void lex_test(void);
 void codegen_test(void);
 void pike_test(void);
+void backtrack_test(void);
+void jit_test(void);
+void sub_test(void);
 void ringbuf_test(void);
 
 
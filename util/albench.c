@@ -0,0 +1,178 @@
+/***************************************************************************//**
+
+  @file         albench.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Benchmark of appending to an smb_al.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  Appends COUNT items to a list, one at a time with and without al_reserve(),
+  and in chunks of 1000 with al_extend().  For comparison, it also times the
+  old growth policy, which added 20 items of capacity per realloc(), by doing
+  the same reallocations directly.  Then it appends the same number of items
+  to 100 lists in turn, with both policies.  Each is repeated and the best
+  time kept.
+
+  With glibc, a single large list grows in place (realloc() uses mremap()), so
+  the old policy's copying mostly shows up when several lists grow at once.
+
+  Usage: albench [COUNT]
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "libstephen/al.h"
+
+#define DEFAULT_COUNT 1000000
+#define REPEAT 5
+#define CHUNK 1000
+#define OLD_BLOCK_SIZE 20
+#define LISTS 100
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+   Append an item the way smb_al used to.  It isn't inlined, so that it costs
+   a call like al_append() does.
+ */
+static __attribute__((noinline)) void old_append(smb_al *list, DATA item)
+{
+  if (list->length == list->allocated) {
+    list->allocated += OLD_BLOCK_SIZE;
+    list->data = smb_renew(DATA, list->data, list->allocated);
+  }
+  list->data[list->length++] = item;
+}
+
+static long long append_old(int n)
+{
+  smb_al list;
+  long long last;
+  int i;
+
+  al_init(&list);
+  for (i = 0; i < n; i++) {
+    old_append(&list, LLINT(i));
+  }
+  last = list.data[list.length - 1].data_llint;
+  al_destroy(&list);
+  return last;
+}
+
+static long long append(int n, bool reserve)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_al list;
+  long long last;
+  int i;
+
+  al_init(&list);
+  if (reserve) {
+    al_reserve(&list, n);
+  }
+  for (i = 0; i < n; i++) {
+    al_append(&list, LLINT(i));
+  }
+  last = al_peek_back(&list, &status).data_llint;
+  al_destroy(&list);
+  return last;
+}
+
+/**
+   Append n items to LISTS lists in turn, with either growth policy.
+ */
+static long long interleave(int n, bool old)
+{
+  smb_al lists[LISTS];
+  long long last;
+  int i, j;
+
+  for (j = 0; j < LISTS; j++) {
+    al_init(&lists[j]);
+  }
+  for (i = 0; i < n / LISTS; i++) {
+    for (j = 0; j < LISTS; j++) {
+      if (old) {
+        old_append(&lists[j], LLINT(i));
+      } else {
+        al_append(&lists[j], LLINT(i));
+      }
+    }
+  }
+  last = lists[0].length;
+  for (j = 0; j < LISTS; j++) {
+    al_destroy(&lists[j]);
+  }
+  return last;
+}
+
+static long long extend(int n, const DATA *chunk)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_al list;
+  long long last;
+  int i;
+
+  al_init(&list);
+  for (i = 0; i < n; i += CHUNK) {
+    al_extend(&list, chunk, n - i < CHUNK ? n - i : CHUNK);
+  }
+  last = al_peek_back(&list, &status).data_llint;
+  al_destroy(&list);
+  return last;
+}
+
+int main(int argc, char **argv)
+{
+  int n = argc > 1 ? atoi(argv[1]) : DEFAULT_COUNT;
+  const char *names[] = {"old (+20 per realloc)", "al_append",
+                         "al_reserve + al_append", "al_extend (1000 at once)",
+                         "100 lists, old", "100 lists, al_append"};
+  double best[6], start, elapsed;
+  DATA chunk[CHUNK];
+  long long sink = 0;
+  int i, r;
+
+  if (n <= 0) {
+    fprintf(stderr, "usage: %s [COUNT]\n", argv[0]);
+    return 1;
+  }
+  for (i = 0; i < CHUNK; i++) {
+    chunk[i] = LLINT(i);
+  }
+
+  for (i = 0; i < 6; i++) {
+    best[i] = 0;
+    for (r = 0; r < REPEAT; r++) {
+      start = now();
+      switch (i) {
+      case 0: sink += append_old(n); break;
+      case 1: sink += append(n, false); break;
+      case 2: sink += append(n, true); break;
+      case 3: sink += extend(n, chunk); break;
+      case 4: sink += interleave(n, true); break;
+      default: sink += interleave(n, false); break;
+      }
+      elapsed = now() - start;
+      if (r == 0 || elapsed < best[i]) {
+        best[i] = elapsed;
+      }
+    }
+    printf("%-26s %8.2f ms\n", names[i], best[i] * 1000);
+  }
+  fprintf(stderr, "(%lld)\n", sink);
+  return 0;
+}
@@ -0,0 +1,151 @@
+/***************************************************************************//**
+
+  @file         chtabench.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Benchmark for the concurrent hash table.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  Runs the same mix of lookups and inserts on an smb_hta behind one mutex, and
+  on an smb_chta, using 1, 2, 4, ... threads up to the number of CPUs, and
+  reports millions of operations per second for each.
+
+  Usage: chtabench [OPS [READ_PERCENT [MAXTHREADS]]]
+
+*******************************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libstephen/chta.h"
+
+#define DEFAULT_OPS 4000000
+#define DEFAULT_READS 90
+#define KEY_SPACE (1 << 20)
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned int int_hash(void *key)
+{
+  return * (unsigned int*) key * 2654435761u;
+}
+
+struct bench {
+  smb_hta *locked;
+  pthread_mutex_t *lock;
+  smb_chta *striped;
+  size_t ops;
+  unsigned int reads;
+  unsigned int seed;
+};
+
+/**
+   A cheap random number generator, so threads don't share rand()'s state.
+ */
+static unsigned int next(unsigned int *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static void *worker(void *data)
+{
+  struct bench *b = data;
+  smb_status status = SMB_SUCCESS;
+  unsigned int state = b->seed, key, value;
+
+  for (size_t i = 0; i < b->ops; i++) {
+    key = next(&state) % KEY_SPACE;
+    bool read = next(&state) % 100 < b->reads;
+    if (b->striped) {
+      if (read) {
+        chta_get(b->striped, &key, &value, &status);
+      } else {
+        chta_insert(b->striped, &key, &key);
+      }
+    } else {
+      pthread_mutex_lock(b->lock);
+      if (read) {
+        hta_get(b->locked, &key, &status);
+      } else {
+        hta_insert(b->locked, &key, &key);
+      }
+      pthread_mutex_unlock(b->lock);
+    }
+  }
+  return NULL;
+}
+
+/**
+   Run the operations split between some threads, returning millions of
+   operations per second.
+ */
+static double run(struct bench *shared, size_t ops, long nthreads)
+{
+  pthread_t *threads = calloc(nthreads, sizeof(pthread_t));
+  struct bench *args = calloc(nthreads, sizeof(struct bench));
+  double begin = now();
+
+  for (long t = 0; t < nthreads; t++) {
+    args[t] = *shared;
+    args[t].ops = ops / nthreads;
+    args[t].seed = 2463534242u + t;
+    pthread_create(&threads[t], NULL, worker, &args[t]);
+  }
+  for (long t = 0; t < nthreads; t++) {
+    pthread_join(threads[t], NULL);
+  }
+
+  double elapsed = now() - begin;
+  free(threads);
+  free(args);
+  return ops / elapsed / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+  size_t ops = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_OPS;
+  unsigned int reads = argc > 2 ? atoi(argv[2]) : DEFAULT_READS;
+  long ncpu = argc > 3 ? atol(argv[3]) : sysconf(_SC_NPROCESSORS_ONLN);
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  struct bench b = {.lock=&lock, .reads=reads};
+
+  printf("operations: %zu, reads: %u%%\n", ops, reads);
+  printf("%8s %12s %12s\n", "threads", "mutex Mop/s", "chta Mop/s");
+  for (long t = 1; ; t *= 2) {
+    if (t > ncpu) {
+      t = ncpu;
+    }
+
+    // Each run starts from an empty table, so both have to grow.
+    b.locked = hta_create(int_hash, &hta_int_comp, sizeof(int), sizeof(int));
+    b.striped = NULL;
+    double locked = run(&b, ops, t);
+    hta_delete(b.locked);
+
+    b.striped = chta_create(int_hash, &hta_int_comp, sizeof(int), sizeof(int));
+    double striped = run(&b, ops, t);
+    chta_delete(b.striped);
+
+    printf("%8ld %12.2f %12.2f\n", t, locked, striped);
+    if (t == ncpu) {
+      break;
+    }
+  }
+  return 0;
+}
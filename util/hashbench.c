@@ -0,0 +1,154 @@
+/***************************************************************************//**
+
+  @file         hashbench.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Benchmark comparing ht_string_hash() with ht_fast_string_hash().
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  For a few sets of keys, reports how fast each function hashes them, how many
+  of their 32 bit hashes collide (a good hash gives about n^2 / 2^33), how many
+  collide in their low 20 bits (which is what a power of two table without
+  scrambling would use), and how long it takes to insert and then look up
+  every key in an smb_ht.
+
+  Usage: hashbench [COUNT]
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libstephen/hash.h"
+#include "libstephen/ht.h"
+
+#define DEFAULT_COUNT 1000000
+#define LOW_BITS 20
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_uint(const void *left, const void *right)
+{
+  unsigned int l = *(const unsigned int *) left, r = *(const unsigned int *) right;
+  return (l > r) - (l < r);
+}
+
+/**
+   Make the nth key of a set.
+ */
+static char *gen(int set, size_t n)
+{
+  char buf[128];
+  switch (set) {
+  case 0:
+    sprintf(buf, "https://example.com/api/v2/users/%zu/items/%zu?page=%zu",
+            n % 1000, n / 1000, n % 7);
+    break;
+  case 1:
+    sprintf(buf, "%zu", n);
+    break;
+  default:
+    sprintf(buf, "/var/lib/data/%c%c/%08zx.dat", 'a' + (int) (n % 26),
+            'a' + (int) (n / 26 % 26), n);
+    break;
+  }
+  return strdup(buf);
+}
+
+/**
+   Count the values in a sorted array equal to the one before.
+ */
+static size_t count_collisions(const unsigned int *hashes, size_t n)
+{
+  size_t i, collisions = 0;
+  for (i = 1; i < n; i++) {
+    collisions += hashes[i] == hashes[i - 1];
+  }
+  return collisions;
+}
+
+static void bench(const char *name, HASH_FUNCTION hash, char **keys, size_t n)
+{
+  unsigned int *hashes = calloc(n, sizeof(unsigned int));
+  size_t i, collisions, low;
+  smb_status status = SMB_SUCCESS;
+  smb_ht table;
+
+  double begin = now();
+  for (int round = 0; round < 10; round++) {
+    for (i = 0; i < n; i++) {
+      hashes[i] += hash(PTR(keys[i]));
+    }
+  }
+  double hashing = (now() - begin) / 10;
+
+  for (i = 0; i < n; i++) {
+    hashes[i] = hash(PTR(keys[i]));
+  }
+  qsort(hashes, n, sizeof(unsigned int), compare_uint);
+  collisions = count_collisions(hashes, n);
+  for (i = 0; i < n; i++) {
+    hashes[i] &= (1u << LOW_BITS) - 1;
+  }
+  qsort(hashes, n, sizeof(unsigned int), compare_uint);
+  low = count_collisions(hashes, n);
+
+  begin = now();
+  ht_init(&table, hash, &data_compare_string);
+  for (i = 0; i < n; i++) {
+    ht_insert(&table, PTR(keys[i]), LLINT(i));
+  }
+  for (i = 0; i < n; i++) {
+    ht_get(&table, PTR(keys[i]), &status);
+  }
+  double table_time = now() - begin;
+  ht_destroy(&table);
+
+  printf("  %-22s %10.1f %12zu %12zu %10.3f\n", name, n / hashing / 1e6,
+         collisions, low, table_time);
+  free(hashes);
+}
+
+int main(int argc, char **argv)
+{
+  size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_COUNT;
+  const char *sets[] = {"URLs", "decimal numbers", "paths"};
+  char **keys = calloc(n, sizeof(char *));
+
+  // Each bucket stays empty with probability (1 - 1/buckets)^n.
+  double buckets = 1 << LOW_BITS, empty = 1;
+  for (size_t i = 0; i < n; i++) {
+    empty *= 1 - 1 / buckets;
+  }
+  printf("keys: %zu, expected collisions for a random hash: %.1f (32 bits), "
+         "%.0f (%d bits)\n", n, (double) n * n / 8589934592.0,
+         n - buckets * (1 - empty), LOW_BITS);
+  for (int set = 0; set < 3; set++) {
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = gen(set, i);
+    }
+    printf("%s (e.g. \"%s\")\n", sets[set], keys[n / 2]);
+    printf("  %-22s %10s %12s %12s %10s\n", "function", "Mhash/s",
+           "collisions", "low bits", "ht secs");
+    bench("ht_string_hash", ht_string_hash, keys, n);
+    bench("ht_fast_string_hash", ht_fast_string_hash, keys, n);
+    for (size_t i = 0; i < n; i++) {
+      free(keys[i]);
+    }
+  }
+
+  free(keys);
+  return 0;
+}
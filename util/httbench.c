@@ -0,0 +1,187 @@
+/***************************************************************************//**
+
+  @file         httbench.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Benchmark comparing smb_ht and smb_hta with SMB_HT_DECLARE().
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  Inserts COUNT integer keys, looks each up, and looks up COUNT keys which
+  aren't there, in each kind of table, and reports the seconds taken by each
+  step.  Then does the same with string keys.
+
+  Usage: httbench [COUNT]
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "libstephen/hash.h"
+#include "libstephen/ht.h"
+#include "libstephen/hta.h"
+#include "libstephen/htt.h"
+
+#define DEFAULT_COUNT 1000000
+
+SMB_HT_DECLARE(ht_ll, long long, long long, SMB_HT_INT_HASH, SMB_HT_INT_EQ)
+SMB_HT_DECLARE(ht_sl, char *, long long, SMB_HT_STR_HASH, SMB_HT_STR_EQ)
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int llint_comp(void *left, void *right)
+{
+  long long l = *(long long *) left, r = *(long long *) right;
+  return (l > r) - (l < r);
+}
+
+static void report(const char *name, double *times, long long check)
+{
+  printf("  %-8s %8.3f %8.3f %8.3f  (check %lld)\n", name, times[0],
+         times[1] - times[0], times[2] - times[1], check);
+}
+
+static void bench_ints(long long n)
+{
+  smb_status status = SMB_SUCCESS;
+  long long i, check = 0, value;
+  double begin, times[3];
+
+  printf("integer keys\n  %-8s %8s %8s %8s\n", "table", "insert", "hit",
+         "miss");
+
+  smb_ht ht;
+  begin = now();
+  ht_init_policy(&ht, ht_int_hash, &data_compare_int, HT_POW2);
+  for (i = 0; i < n; i++) {
+    ht_insert(&ht, LLINT(i), LLINT(i));
+  }
+  times[0] = now() - begin;
+  for (i = 0; i < n; i++) {
+    check += ht_get(&ht, LLINT(i), &status).data_llint;
+  }
+  times[1] = now() - begin;
+  for (i = n; i < 2 * n; i++) {
+    check += ht_contains(&ht, LLINT(i));
+  }
+  times[2] = now() - begin;
+  ht_destroy(&ht);
+  report("smb_ht", times, check);
+
+  smb_hta hta;
+  check = 0;
+  begin = now();
+  hta_init_policy(&hta, hta_llint_hash, &llint_comp, sizeof(long long),
+                  sizeof(long long), HT_POW2);
+  for (i = 0; i < n; i++) {
+    hta_insert(&hta, &i, &i);
+  }
+  times[0] = now() - begin;
+  for (i = 0; i < n; i++) {
+    check += *(long long *) hta_get(&hta, &i, &status);
+  }
+  times[1] = now() - begin;
+  for (i = n; i < 2 * n; i++) {
+    check += hta_contains(&hta, &i);
+  }
+  times[2] = now() - begin;
+  hta_destroy(&hta);
+  report("smb_hta", times, check);
+
+  ht_ll htt;
+  check = 0;
+  begin = now();
+  ht_ll_init(&htt);
+  for (i = 0; i < n; i++) {
+    value = i;
+    ht_ll_insert(&htt, i, value);
+  }
+  times[0] = now() - begin;
+  for (i = 0; i < n; i++) {
+    check += *ht_ll_get(&htt, i, &status);
+  }
+  times[1] = now() - begin;
+  for (i = n; i < 2 * n; i++) {
+    check += ht_ll_contains(&htt, i);
+  }
+  times[2] = now() - begin;
+  ht_ll_destroy(&htt);
+  report("htt", times, check);
+}
+
+static void bench_strings(char **keys, long long n)
+{
+  smb_status status = SMB_SUCCESS;
+  long long i, check = 0;
+  double begin, times[3];
+
+  printf("string keys\n  %-8s %8s %8s %8s\n", "table", "insert", "hit",
+         "miss");
+
+  smb_ht ht;
+  begin = now();
+  ht_init_policy(&ht, ht_fast_string_hash, &data_compare_string, HT_POW2);
+  for (i = 0; i < n; i++) {
+    ht_insert(&ht, PTR(keys[i]), LLINT(i));
+  }
+  times[0] = now() - begin;
+  for (i = 0; i < n; i++) {
+    check += ht_get(&ht, PTR(keys[i]), &status).data_llint;
+  }
+  times[1] = now() - begin;
+  for (i = n; i < 2 * n; i++) {
+    check += ht_contains(&ht, PTR(keys[i]));
+  }
+  times[2] = now() - begin;
+  ht_destroy(&ht);
+  report("smb_ht", times, check);
+
+  ht_sl htt;
+  check = 0;
+  begin = now();
+  ht_sl_init(&htt);
+  for (i = 0; i < n; i++) {
+    ht_sl_insert(&htt, keys[i], i);
+  }
+  times[0] = now() - begin;
+  for (i = 0; i < n; i++) {
+    check += *ht_sl_get(&htt, keys[i], &status);
+  }
+  times[1] = now() - begin;
+  for (i = n; i < 2 * n; i++) {
+    check += ht_sl_contains(&htt, keys[i]);
+  }
+  times[2] = now() - begin;
+  ht_sl_destroy(&htt);
+  report("htt", times, check);
+}
+
+int main(int argc, char **argv)
+{
+  long long i, n = argc > 1 ? strtoll(argv[1], NULL, 10) : DEFAULT_COUNT;
+  char **keys = calloc(2 * n, sizeof(char *));
+
+  bench_ints(n);
+
+  for (i = 0; i < 2 * n; i++) {
+    keys[i] = malloc(32);
+    sprintf(keys[i], "key-%lld", i);
+  }
+  bench_strings(keys, n);
+  for (i = 0; i < 2 * n; i++) {
+    free(keys[i]);
+  }
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,104 @@
+/***************************************************************************//**
+
+  @file         rebatch.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Benchmark for matching a regex against many strings in parallel.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  Generates a lot of short, email-address-like strings, matches them all with
+  rebatch() using 1, 2, 4, ... threads up to the number of CPUs, and reports
+  the speedup over one thread.
+
+  Usage: rebatch [REGEXP [COUNT [MAXTHREADS]]]
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libstephen/re.h"
+
+#define DEFAULT_REGEX "(\\w+)\\.(\\w+)@(\\w+\\.)+(com|org|net)"
+#define DEFAULT_COUNT 1000000
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+   Make a random string, which matches the default regex most of the time.
+ */
+static char *gen(void)
+{
+  static const char *tlds[] = {"com", "org", "net", "edu"};
+  char buf[128];
+  int len = 0;
+
+  for (int part = 0; part < 3; part++) {
+    int n = 3 + rand() % 10;
+    for (int i = 0; i < n; i++) {
+      buf[len++] = 'a' + rand() % 26;
+    }
+    buf[len++] = ".@."[part];
+  }
+  strcpy(buf + len, tlds[rand() % 4]);
+  return strdup(buf);
+}
+
+int main(int argc, char **argv)
+{
+  const char *pattern = argc > 1 ? argv[1] : DEFAULT_REGEX;
+  size_t n = argc > 2 ? strtoul(argv[2], NULL, 10) : DEFAULT_COUNT;
+  long ncpu = argc > 3 ? atol(argv[3]) : sysconf(_SC_NPROCESSORS_ONLN);
+  char **inputs = calloc(n, sizeof(char *));
+  ssize_t *results = calloc(n, sizeof(ssize_t));
+  Regex r = recomp((char *) pattern);
+  double base = 0;
+
+  srand(42);
+  for (size_t i = 0; i < n; i++) {
+    inputs[i] = gen();
+  }
+
+  printf("regex: %s\ninputs: %zu\n", pattern, n);
+  printf("%8s %10s %8s\n", "threads", "seconds", "speedup");
+  for (long t = 1; ; t *= 2) {
+    if (t > ncpu) {
+      t = ncpu;
+    }
+    double begin = now();
+    rebatch(r, (const char *const *) inputs, n, (int) t, results);
+    double elapsed = now() - begin;
+    if (t == 1) {
+      base = elapsed;
+    }
+    printf("%8ld %10.3f %7.2fx\n", t, elapsed, base / elapsed);
+    if (t == ncpu) {
+      break;
+    }
+  }
+
+  size_t matches = 0;
+  for (size_t i = 0; i < n; i++) {
+    matches += results[i] != -1;
+    free(inputs[i]);
+  }
+  printf("matches: %zu\n", matches);
+
+  refree(r);
+  free(inputs);
+  free(results);
+  return 0;
+}
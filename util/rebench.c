@@ -0,0 +1,145 @@
+/***************************************************************************//**
+
+  @file         rebench.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Benchmark of the regex matchers on short strings.
+
+  @copyright    Copyright (c) 2026, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  Generates a lot of short, email-address-like strings, and matches them all
+  with each matcher in turn: the Pike VM, the backtracker (a Matcher), and
+  native code (a Matcher after remjit()).  Each is repeated and the best time
+  kept.  Every matcher must agree on every string.
+
+  Usage: rebench [REGEXP [COUNT]]
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libstephen/re.h"
+#include "libstephen/re_internals.h"
+
+#define DEFAULT_REGEX "(\\w+)\\.(\\w+)@(\\w+\\.)+(com|org|net)"
+#define DEFAULT_COUNT 200000
+#define REPEAT 5
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+   Make a random string, which matches the default regex most of the time.
+ */
+static char *gen(void)
+{
+  static const char *tlds[] = {"com", "org", "net", "edu"};
+  char buf[128];
+  int len = 0;
+
+  for (int part = 0; part < 3; part++) {
+    int n = 3 + rand() % 10;
+    for (int i = 0; i < n; i++) {
+      buf[len++] = 'a' + rand() % 26;
+    }
+    buf[len++] = ".@."[part];
+  }
+  strcpy(buf + len, tlds[rand() % 4]);
+  return strdup(buf);
+}
+
+/**
+   Match every input with one matcher: 0 for the Pike VM, 1 for a Matcher, and
+   2 for a Matcher with native code.
+ */
+static ssize_t run(Regex r, char **inputs, int n, int which, ssize_t *results)
+{
+  ssize_t total = 0;
+  Matcher m;
+
+  reminit(&m, r);
+  if (which == 2) {
+    remjit(&m);
+  }
+  for (int i = 0; i < n; i++) {
+    if (which == 0) {
+      struct Input in = {.str=inputs[i], .wstr=NULL};
+      results[i] = pike(r.p, in, true, NULL, NULL);
+    } else {
+      results[i] = rematch(&m, inputs[i]);
+    }
+    total += results[i];
+  }
+  remdestroy(&m);
+  return total;
+}
+
+int main(int argc, char **argv)
+{
+  const char *pattern = argc > 1 ? argv[1] : DEFAULT_REGEX;
+  int n = argc > 2 ? atoi(argv[2]) : DEFAULT_COUNT;
+  const char *names[] = {"pike", "backtrack", "jit"};
+  double best[3], start, elapsed;
+  ssize_t *expected, *results;
+  char **inputs;
+  long long sink = 0;
+  Regex r;
+  Matcher m;
+
+  if (n <= 0) {
+    fprintf(stderr, "usage: %s [REGEXP [COUNT]]\n", argv[0]);
+    return 1;
+  }
+  r = recomp(pattern);
+  reminit(&m, r);
+  if (!remjit(&m)) {
+    printf("(no native code on this system; jit is the backtracker)\n");
+  }
+  remdestroy(&m);
+
+  srand(42);
+  inputs = malloc(n * sizeof(char *));
+  expected = malloc(n * sizeof(ssize_t));
+  results = malloc(n * sizeof(ssize_t));
+  for (int i = 0; i < n; i++) {
+    inputs[i] = gen();
+  }
+
+  for (int which = 0; which < 3; which++) {
+    for (int rep = 0; rep < REPEAT; rep++) {
+      start = now();
+      sink += run(r, inputs, n, which, which == 0 ? expected : results);
+      elapsed = now() - start;
+      if (rep == 0 || elapsed < best[which]) {
+        best[which] = elapsed;
+      }
+    }
+    if (which > 0 && memcmp(expected, results, n * sizeof(ssize_t)) != 0) {
+      fprintf(stderr, "%s disagrees with pike!\n", names[which]);
+      return 1;
+    }
+    printf("%-10s %8.2f ms  %6.1f ns/string  %5.2fx\n", names[which],
+           best[which] * 1000, best[which] * 1e9 / n, best[0] / best[which]);
+  }
+  fprintf(stderr, "(%lld)\n", sink);
+
+  for (int i = 0; i < n; i++) {
+    free(inputs[i]);
+  }
+  free(inputs);
+  free(expected);
+  free(results);
+  refree(r);
+  return 0;
+}
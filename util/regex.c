@@ -14,32 +14,70 @@
 *******************************************************************************/
 
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "libstephen/re.h"
 
 
+/**
+   Compile a regex, or read its code from a file.
+   @param arg A file name, or a regex.
+   @param[out] compiled Set to whether arg was compiled (may be NULL).
+ */
+static Regex load(char *arg, bool *compiled)
+{
+  // Try to open arg as file.
+  Regex code;
+  FILE *in = fopen(arg, "r");
+
+  if (in == NULL) {
+    // If it doesn't open, it's a regex we should compile.
+    code = recomp(arg);
+  } else {
+    // Otherwise, open it and read the code from it.
+    code = refread(in);
+    fclose(in);
+  }
+  if (compiled) {
+    *compiled = in == NULL;
+  }
+  return code;
+}
+
+/**
+   Write a regex out as C code, to be compiled into another program.
+ */
+static int generate(char *name, char *arg)
+{
+  Regex code = load(arg, NULL);
+  rewritec(code, name, stdout);
+  refree(code);
+  return EXIT_SUCCESS;
+}
+
 int main(int argc, char **argv)
 {
+  if (argc == 4 && strcmp(argv[1], "-c") == 0) {
+    return generate(argv[2], argv[3]);
+  }
+
   if (argc < 3) {
     fprintf(stderr, "too few arguments\n");
     fprintf(stderr, "usage: %s REGEXP string1 [string2 [...]]\n", argv[0]);
+    fprintf(stderr, "       %s -c NAME REGEXP\n", argv[0]);
     exit(EXIT_FAILURE);
   }
 
-  // Try to open first arg as file.
-  Regex code;
-  FILE *in = fopen(argv[1], "r");
+  bool compiled;
+  Regex code = load(argv[1], &compiled);
 
-  if (in == NULL) {
-    // If it doesn't open, it's a regex we should compile.
+  if (compiled) {
     printf(";; Regex: \"%s\"\n\n", argv[1]);
-    code = recomp(argv[1]);
     printf(";; BEGIN GENERATED CODE:\n");
   } else {
-    // Otherwise, open it and read the code from it.
-    code = refread(in);
     printf(";; BEGIN READ CODE:\n");
   }
   rewrite(code, stdout);